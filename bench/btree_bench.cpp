@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include "BPlusTree.h"
+#include "HashIndex.h"
+
+// ------------------- B+ Tree Microbenchmark -------------------
+// Insert, bulk-load, point-search and range-scan throughput for several node
+// orders, plus the resulting tree height, node count and node-pool footprint.
+// The table is repeated for each in-node search level the CPU supports,
+// followed by the same key set as strings in the string-keyed tree and as
+// ints in a USING HASH index, and a hash index over duplicate keys.
+//
+// Usage: btree_bench [keys]
+
+template <int Order>
+using IntTree = BasicBPlusTree<int, int, std::less<int>, Order>;
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <int Order>
+static void run(const std::vector<int> &keys, const std::vector<int> &probes)
+{
+    IntTree<Order> tree;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++)
+        tree.insert(keys[i], i);
+    double insert_rate = keys.size() / seconds_since(start) / 1e6;
+
+    // Bottom-up build of the same entries; the sort is part of the cost
+    start = std::chrono::steady_clock::now();
+    std::vector<std::pair<int, int>> entries(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+        entries[i] = {keys[i], static_cast<int>(i)};
+    std::sort(entries.begin(), entries.end());
+    IntTree<Order> loaded;
+    loaded.bulk_load(entries);
+    double bulk_rate = keys.size() / seconds_since(start) / 1e6;
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int key : probes)
+    {
+        int value;
+        found += tree.find(key, value);
+    }
+    double search_rate = probes.size() / seconds_since(start) / 1e6;
+
+    // Ranges of 1000 keys starting at each probe; rate counts entries visited
+    const int range_width = 1000;
+    const size_t range_queries = probes.size() / 100;
+    size_t scanned = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < range_queries; q++)
+    {
+        int lo = probes[q];
+        for (auto it = tree.lower_bound(lo); it.valid() && it.key() < lo + range_width; it.next())
+            scanned++;
+    }
+    double scan_rate = scanned / seconds_since(start) / 1e6;
+
+    size_t pool_bytes = tree.leaf_pool_stats().reserved_bytes + tree.internal_pool_stats().reserved_bytes;
+    if (found != probes.size())
+        std::cerr << "Order " << Order << ": lost keys\n";
+
+    std::cout << std::left << std::setw(8) << Order << std::setw(8) << tree.height()
+              << std::setw(12) << tree.node_count() << std::setw(12) << sizeof(typename IntTree<Order>::Leaf)
+              << std::setw(12) << pool_bytes / 1024
+              << std::fixed << std::setprecision(2) << std::setw(14) << insert_rate
+              << std::setw(14) << bulk_rate
+              << std::setw(14) << search_rate << std::setw(14) << scan_rate << "\n";
+}
+
+// String keys sharing a long common prefix, so comparisons past the inline
+// 8-byte head hit the key arena
+static void run_strings(const std::vector<int> &keys, const std::vector<int> &probes)
+{
+    auto text = [](int key) { return "customer-" + std::to_string(key); };
+    std::vector<std::string> key_text(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+        key_text[i] = text(keys[i]);
+    std::vector<std::string> probe_text(probes.size());
+    for (size_t i = 0; i < probes.size(); i++)
+        probe_text[i] = text(probes[i]);
+
+    BasicBPlusTree<std::string> tree;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < key_text.size(); i++)
+        tree.insert(key_text[i], i);
+    double insert_rate = keys.size() / seconds_since(start) / 1e6;
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto &key : probe_text)
+    {
+        int value;
+        found += tree.find(key, value);
+    }
+    double search_rate = probes.size() / seconds_since(start) / 1e6;
+    if (found != probes.size())
+        std::cerr << "String keys: lost keys\n";
+
+    BPlusTreeStats stats = tree.stats();
+    std::cout << "\nString keys (\"customer-N\"): height " << stats.height << ", "
+              << (stats.reserved_bytes + stats.key_bytes) / 1024 << " KiB, insert "
+              << std::fixed << std::setprecision(2) << insert_rate << " M/s, search " << search_rate << " M/s\n";
+}
+
+static void run_hash(const std::vector<int> &keys, const std::vector<int> &probes)
+{
+    HashIndex hash;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++)
+        hash.insert(keys[i], i);
+    double insert_rate = keys.size() / seconds_since(start) / 1e6;
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int key : probes)
+    {
+        int value;
+        found += hash.find(key, value);
+    }
+    double search_rate = probes.size() / seconds_since(start) / 1e6;
+    if (found != probes.size())
+        std::cerr << "Hash index: lost keys\n";
+
+    HashIndexStats stats = hash.stats();
+    std::cout << "Hash index: longest probe " << stats.max_probe << ", " << stats.reserved_bytes / 1024
+              << " KiB, insert " << std::fixed << std::setprecision(2) << insert_rate << " M/s, search "
+              << search_rate << " M/s\n";
+}
+
+// Rows spread over few distinct keys, as on a low-cardinality column:
+// inserts, lookups of every row of a key, and removal of half the rows
+static void run_hash_duplicates(size_t rows, int distinct)
+{
+    std::mt19937 rng(11);
+    std::vector<int> row_keys(rows);
+    for (auto &key : row_keys)
+        key = rng() % distinct;
+
+    auto start = std::chrono::steady_clock::now();
+    HashIndex hash;
+    for (size_t i = 0; i < rows; i++)
+        hash.insert(row_keys[i], i);
+    double insert_rate = rows / seconds_since(start) / 1e6;
+
+    start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int key = 0; key < distinct; key++)
+        found += hash.lookup(key).size();
+    double lookup_ms = seconds_since(start) * 1000;
+    if (found != rows)
+        std::cerr << "Hash index: lost rows under duplicate keys\n";
+
+    std::vector<int> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rows / 2; i++)
+        hash.remove(row_keys[order[i]], order[i]);
+    double remove_rate = rows / 2 / seconds_since(start) / 1e6;
+    if (hash.size() != rows - rows / 2)
+        std::cerr << "Hash index: wrong row count after removes\n";
+
+    std::cout << "Hash index, " << distinct << " distinct keys: insert " << std::fixed << std::setprecision(2)
+              << insert_rate << " M/s, lookup of all rows " << lookup_ms << " ms, remove " << remove_rate
+              << " M/s\n";
+}
+
+static void print_table(const std::vector<int> &keys, const std::vector<int> &probes)
+{
+    std::cout << std::left << std::setw(8) << "order" << std::setw(8) << "height" << std::setw(12) << "nodes"
+              << std::setw(12) << "leaf bytes"
+              << std::setw(12) << "pool KiB" << std::setw(14) << "insert M/s" << std::setw(14) << "bulk M/s"
+              << std::setw(14) << "search M/s"
+              << std::setw(14) << "scan M/s" << "\n";
+
+    run<16>(keys, probes);
+    run<32>(keys, probes);
+    run<64>(keys, probes);
+    run<128>(keys, probes);
+    run<256>(keys, probes);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    std::vector<int> keys(count);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::mt19937 rng(7);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<int> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), rng);
+
+    std::cout << "Keys: " << count << " (random insert order)\n";
+    for (int l = 0; l <= static_cast<int>(detect_simd_level()); l++)
+    {
+        SimdLevel level = static_cast<SimdLevel>(l);
+        set_simd_level(level);
+        std::cout << "\nIn-node search: " << simd_level_name(level) << "\n";
+        print_table(keys, probes);
+    }
+    run_strings(keys, probes);
+    run_hash(keys, probes);
+    run_hash_duplicates(count, 2);
+    run_hash_duplicates(count, 1000);
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BPlusTree.h"
+
+// ------------------- Concurrent B+ Tree Benchmark -------------------
+// Mixed read/write throughput of one shared tree: every thread does 50
+// point lookups per write, with a short range scan every 1000 operations.
+// Lookups and scans go through the tree's optimistic lock coupling, and the
+// same mix is repeated behind a reader-writer lock for comparison.
+//
+// Doubles as a stress test. Even keys are loaded up front and never
+// removed, so every lookup of one must succeed and every scan must return
+// all of them in its range. Each thread writes only odd keys of its own
+// (inserting, then removing its oldest once it holds 256), so the final
+// contents are known exactly.
+//
+// Usage: concurrent_bench [keys] [operations per thread]
+
+static constexpr int READS_PER_WRITE = 50;
+static constexpr int SCAN_EVERY = 1000;
+static constexpr int SCAN_WIDTH = 100;
+static constexpr size_t KEPT_PER_THREAD = 256;
+
+struct Shared
+{
+    BPlusTree tree;
+    std::shared_mutex latch;
+    std::atomic<size_t> failures{0};
+};
+
+template <bool Locked>
+static void worker(Shared &shared, int thread, int stable_keys, size_t operations, std::vector<int> &held)
+{
+    std::mt19937 rng(thread + 1);
+    std::uniform_int_distribution<int> pick(0, stable_keys - 1);
+    // Odd keys above the stable range, disjoint between threads
+    int next_key = 2 * stable_keys + 1 + thread * 2 * static_cast<int>(operations);
+    size_t first_held = 0;
+
+    auto read = [&](auto &&fn)
+    {
+        if constexpr (Locked)
+        {
+            std::shared_lock<std::shared_mutex> lock(shared.latch);
+            return fn();
+        }
+        else
+            return fn();
+    };
+    auto write = [&](auto &&fn)
+    {
+        if constexpr (Locked)
+        {
+            std::unique_lock<std::shared_mutex> lock(shared.latch);
+            fn();
+        }
+        else
+            fn();
+    };
+
+    for (size_t op = 0; op < operations; op++)
+    {
+        if (op % SCAN_EVERY == 0)
+        {
+            int lo = 2 * pick(rng);
+            std::vector<int> rows = read([&] { return shared.tree.range_search(lo, lo + 2 * SCAN_WIDTH - 1); });
+            size_t evens = std::count_if(rows.begin(), rows.end(), [](int v) { return v % 2 == 0; });
+            size_t expected = std::min<size_t>(SCAN_WIDTH, stable_keys - lo / 2);
+            if (evens != expected || !std::is_sorted(rows.begin(), rows.end()))
+                shared.failures++;
+        }
+        else if (op % (READS_PER_WRITE + 1) != READS_PER_WRITE)
+        {
+            int key = 2 * pick(rng);
+            int value = -1;
+            bool found = read([&] { return shared.tree.find(key, value); });
+            if (!found || value != key)
+                shared.failures++;
+        }
+        else if (held.size() - first_held < KEPT_PER_THREAD)
+        {
+            int key = next_key;
+            next_key += 2;
+            write([&] { shared.tree.insert(key, key); });
+            held.push_back(key);
+        }
+        else
+        {
+            int key = held[first_held++];
+            write([&] { shared.tree.remove(key); });
+        }
+    }
+    held.erase(held.begin(), held.begin() + first_held);
+}
+
+template <bool Locked>
+static double run(int stable_keys, size_t operations, int threads)
+{
+    Shared shared;
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i < stable_keys; i++)
+        entries.push_back({2 * i, 2 * i});
+    shared.tree.bulk_load(entries);
+
+    std::vector<std::vector<int>> held(threads);
+    std::vector<std::thread> pool;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back(worker<Locked>, std::ref(shared), t, stable_keys, operations, std::ref(held[t]));
+    for (auto &thread : pool)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Exactly the stable keys plus each thread's outstanding odd keys
+    std::vector<int> expected;
+    for (int i = 0; i < stable_keys; i++)
+        expected.push_back(2 * i);
+    for (const auto &keys : held)
+        expected.insert(expected.end(), keys.begin(), keys.end());
+    std::sort(expected.begin(), expected.end());
+    std::vector<int> actual;
+    for (auto it = shared.tree.begin(); it.valid(); it.next())
+        actual.push_back(it.key());
+    if (actual != expected || shared.tree.size() != expected.size())
+        shared.failures++;
+    if (shared.failures > 0)
+    {
+        std::cerr << (Locked ? "Locked" : "Optimistic") << ", " << threads << " threads: "
+                  << shared.failures << " failed checks\n";
+        std::exit(1);
+    }
+    return operations * threads / seconds / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int stable_keys = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    size_t operations = argc > 2 ? std::stoul(argv[2]) : 2000000;
+
+    std::vector<int> thread_counts = {1, 2, 4, 8};
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware > 8)
+        thread_counts.push_back(hardware);
+
+    std::cout << "Keys: " << stable_keys << ", " << operations << " operations per thread, "
+              << READS_PER_WRITE << " reads per write (hardware threads: " << hardware << ")\n\n";
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(18) << "optimistic M/s"
+              << std::setw(18) << "rw-lock M/s" << "\n";
+    for (int threads : thread_counts)
+    {
+        double optimistic = run<false>(stable_keys, operations, threads);
+        double locked = run<true>(stable_keys, operations, threads);
+        std::cout << std::left << std::setw(10) << threads << std::fixed << std::setprecision(2)
+                  << std::setw(18) << optimistic << std::setw(18) << locked << "\n";
+    }
+    std::cout << "All checks passed\n";
+    return 0;
+}
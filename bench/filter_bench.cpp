@@ -0,0 +1,171 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include "Predicate.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+
+// ------------------- Filter Microbenchmark -------------------
+// Rows/second for each comparison operator on INT and FLOAT columns:
+// the row-at-a-time predicate over a ROW table versus the bitmap kernels
+// over a COLUMNAR table at every SIMD level this CPU supports. A second
+// table scales a morsel-driven scan of `qty < 50` over thread counts.
+//
+// Usage: filter_bench [rows]
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t popcount_bits(const std::vector<uint64_t> &bits)
+{
+    size_t total = 0;
+    for (uint64_t w : bits)
+        total += __builtin_popcountll(w);
+    return total;
+}
+
+int main(int argc, char **argv)
+{
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : (size_t(1) << 22);
+    const int repeats = 5;
+
+    Table row_table;
+    row_table.columns = {{"qty", "INT", false}, {"price", "FLOAT", false}};
+    row_table.init_storage();
+    Table col_table;
+    col_table.columns = row_table.columns;
+    col_table.layout = StorageLayout::COLUMNAR;
+    col_table.init_storage();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> qty_dist(0, 100);
+    std::uniform_real_distribution<float> price_dist(0.0f, 100.0f);
+    for (size_t i = 0; i < rows; i++)
+    {
+        std::vector<Value> row = {qty_dist(rng), price_dist(rng)};
+        row_table.append_row(row);
+        col_table.append_row(row);
+    }
+
+    const std::pair<const char *, CompareOp> ops[] = {
+        {"=", CompareOp::EQ}, {"!=", CompareOp::NE}, {"<", CompareOp::LT},
+        {"<=", CompareOp::LE}, {">", CompareOp::GT}, {">=", CompareOp::GE}};
+
+    std::vector<SimdLevel> levels = {SimdLevel::SCALAR};
+    if (detect_simd_level() >= SimdLevel::SSE2)
+        levels.push_back(SimdLevel::SSE2);
+    if (detect_simd_level() >= SimdLevel::AVX2)
+        levels.push_back(SimdLevel::AVX2);
+
+    std::cout << "Rows: " << rows << ", detected SIMD level: "
+              << simd_level_name(detect_simd_level()) << "\n\n";
+    std::cout << std::left << std::setw(8) << "type" << std::setw(5) << "op"
+              << std::setw(16) << "row path";
+    for (SimdLevel level : levels)
+        std::cout << std::setw(16) << (std::string("kernel ") + simd_level_name(level));
+    std::cout << "(million rows/s)\n";
+
+    std::vector<uint64_t> bits((rows + 63) / 64);
+    for (const char *type : {"INT", "FLOAT"})
+    {
+        bool is_int = std::string(type) == "INT";
+        for (const auto &op : ops)
+        {
+            Condition cond;
+            cond.column = is_int ? "qty" : "price";
+            cond.op = op.first;
+            cond.value = is_int ? Value(50) : Value(50.5f);
+            Predicate pred = Predicate::compile(row_table, {cond});
+
+            // Current path: one predicate evaluation per row
+            size_t expected = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++)
+            {
+                expected = 0;
+                for (size_t i = 0; i < rows; i++)
+                    expected += pred.matches(row_table, i);
+            }
+            double row_rate = rows * repeats / seconds_since(start) / 1e6;
+
+            std::cout << std::left << std::setw(8) << type << std::setw(5) << op.first
+                      << std::setw(16) << std::fixed << std::setprecision(1) << row_rate;
+
+            for (SimdLevel level : levels)
+            {
+                set_simd_level(level);
+                start = std::chrono::steady_clock::now();
+                for (int r = 0; r < repeats; r++)
+                {
+                    if (is_int)
+                        filter_int32(col_table.column_data[0].ints.data(), rows, op.second, 50, bits.data());
+                    else
+                        filter_float(col_table.column_data[1].floats.data(), rows, op.second, 50.5f, bits.data());
+                }
+                double kernel_rate = rows * repeats / seconds_since(start) / 1e6;
+                if (popcount_bits(bits) != expected)
+                {
+                    std::cerr << "Mismatch for " << type << " " << op.first << " at "
+                              << simd_level_name(level) << "\n";
+                    return 1;
+                }
+                std::cout << std::setw(16) << kernel_rate;
+            }
+            std::cout << "\n";
+        }
+    }
+
+    set_simd_level(detect_simd_level());
+    Condition cond;
+    cond.column = "qty";
+    cond.op = "<";
+    cond.value = Value(50);
+    Predicate pred = Predicate::compile(row_table, {cond});
+    const size_t morsel_rows = 16384;
+    const size_t morsels = (rows + morsel_rows - 1) / morsel_rows;
+
+    std::cout << "\nMorsel scan, qty < 50 (" << morsel_rows << "-row morsels)\n"
+              << std::left << std::setw(10) << "threads" << std::setw(16) << "row path"
+              << std::setw(16) << "columnar" << "(million rows/s)\n";
+    for (size_t threads = 1;; threads = std::min(threads * 2, ThreadPool::default_threads()))
+    {
+        ThreadPool pool(threads);
+        std::vector<size_t> counts(morsels);
+        double rates[2];
+        for (int columnar = 0; columnar < 2; columnar++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++)
+            {
+                pool.run(morsels, [&](size_t m, size_t)
+                         {
+                             size_t begin = m * morsel_rows;
+                             size_t end = std::min(rows, begin + morsel_rows);
+                             size_t count = 0;
+                             if (!columnar)
+                             {
+                                 for (size_t i = begin; i < end; i++)
+                                     count += pred.matches(row_table, i);
+                             }
+                             for (size_t b = begin; columnar && b < end; b += Predicate::BLOCK_ROWS)
+                             {
+                                 uint64_t block_bits[Predicate::BLOCK_ROWS / 64];
+                                 size_t n = std::min(Predicate::BLOCK_ROWS, end - b);
+                                 pred.filter_block(col_table, b, n, block_bits);
+                                 for (size_t w = 0; w < (n + 63) / 64; w++)
+                                     count += __builtin_popcountll(block_bits[w]);
+                             }
+                             counts[m] = count;
+                         });
+            }
+            rates[columnar] = rows * repeats / seconds_since(start) / 1e6;
+        }
+        std::cout << std::setw(10) << threads << std::setw(16) << rates[0] << std::setw(16) << rates[1] << "\n";
+        if (threads == ThreadPool::default_threads())
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "WriteAheadLog.h"
+
+// ------------------- WAL Group Commit Benchmark -------------------
+// Commits per second when every committing thread waits for its record to
+// be durable. With one thread each commit pays a full fdatasync; with more,
+// commits that arrive during a sync share the next one. The last column
+// runs the same load with SET WAL_SYNC_MS-style interval syncing.
+//
+// Usage: wal_bench [directory] [commits per thread] [record bytes]
+
+struct Result
+{
+    double commits_per_second;
+    double commits_per_sync;
+};
+
+static Result run(const std::string &path, int threads, size_t commits, size_t record_bytes,
+                  unsigned interval)
+{
+    ::unlink(path.c_str());
+    WriteAheadLog wal(path, 1, 0);
+    wal.set_sync_interval(interval);
+    std::string record(record_bytes, 'x');
+
+    std::vector<std::thread> pool;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        pool.emplace_back([&]
+        {
+            for (size_t i = 0; i < commits; i++)
+                wal.commit(wal.append(record));
+        });
+    }
+    for (auto &thread : pool)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double total = double(threads) * commits;
+    if (wal.records() != total)
+    {
+        std::cerr << "Expected " << total << " records, log holds " << wal.records() << "\n";
+        std::exit(1);
+    }
+    return {total / seconds, wal.syncs() ? total / wal.syncs() : 0};
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = argc > 1 ? argv[1] : ".";
+    size_t commits = argc > 2 ? std::stoul(argv[2]) : 500;
+    size_t record_bytes = argc > 3 ? std::stoul(argv[3]) : 64;
+    std::string path = dir + "/wal_bench.log";
+
+    std::cout << commits << " commits per thread, " << record_bytes << "-byte records, log at "
+              << path << "\n\n";
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(16) << "commits/s"
+              << std::setw(18) << "commits/sync" << std::setw(16) << "10 ms commits/s" << "\n";
+    for (int threads : {1, 2, 4, 8, 16, 32})
+    {
+        Result each = run(path, threads, commits, record_bytes, 0);
+        Result interval = run(path, threads, commits, record_bytes, 10);
+        std::cout << std::left << std::setw(10) << threads << std::fixed << std::setprecision(0)
+                  << std::setw(16) << each.commits_per_second << std::setprecision(1)
+                  << std::setw(18) << each.commits_per_sync << std::setprecision(0)
+                  << std::setw(16) << interval.commits_per_second << "\n";
+    }
+    ::unlink(path.c_str());
+    return 0;
+}
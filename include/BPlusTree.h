@@ -2,41 +2,1146 @@
 #define BPLUSTREE_H
 
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "NodePool.h"
+#include "SimdKernels.h"
 
 // ------------------- B+ Tree Implementation -------------------
-const int ORDER = 4;
+constexpr size_t CACHE_LINE_SIZE = 64;
 
+// Keys per node. Key, value and child arrays live inline in the node and
+// are whole cache lines, so Order must be a multiple of 16.
+constexpr int BPLUS_DEFAULT_ORDER = 128;
+
+// Deepest tree the insert path stack can describe; a tree of 16-key nodes
+// holding every int key is far shallower than this
+constexpr int BPLUS_MAX_HEIGHT = 32;
+
+// Share of each node bulk_load fills; lower values leave room for later
+// inserts before the first splits
+constexpr double BPLUS_DEFAULT_FILL_FACTOR = 1.0;
+
+// Shape of a tree as reported by BasicBPlusTree::stats
+struct BPlusTreeStats
+{
+    size_t entries = 0;
+    int height = 0;
+    size_t leaves = 0;
+    size_t internals = 0;
+    double leaf_fill = 0;     // Keys in use / leaf key capacity
+    double internal_fill = 0; // Children in use / internal child capacity
+    size_t reserved_bytes = 0; // Slab memory held by the node pools
+    size_t key_bytes = 0;      // Out-of-line key storage (string keys only)
+};
+
+// Version word bits: a writer holds the node, or the node was freed. The
+// rest counts up by VERSION_STEP from a per-tree clock.
+constexpr uint64_t BPLUS_VERSION_OBSOLETE = 1;
+constexpr uint64_t BPLUS_VERSION_LOCKED = 2;
+constexpr uint64_t BPLUS_VERSION_STEP = 4;
+
+template <typename Key, int Order>
 struct BPlusNode
 {
+    static_assert(std::is_trivially_copyable_v<Key>, "B+ tree keys are stored inline and copied bytewise");
+    static_assert(Order >= 16 && (Order * sizeof(Key)) % CACHE_LINE_SIZE == 0,
+                  "B+ tree order must fill whole cache lines of keys");
+
+    alignas(CACHE_LINE_SIZE) Key keys[Order];
+    int count = 0; // Keys in use
     bool is_leaf;
-    std::vector<int> keys;
-    std::vector<int> values;
-    std::vector<BPlusNode *> children;
-    BPlusNode *next;
-    BPlusNode *parent;
+    std::atomic<uint64_t> version; // Changes whenever a writer releases the node
+
+    BPlusNode(bool leaf, uint64_t v) : is_leaf(leaf), version(v) {}
+};
+
+template <typename Key, typename Value, int Order>
+struct BPlusLeaf : BPlusNode<Key, Order>
+{
+    static_assert(std::is_trivially_copyable_v<Value> && (Order * sizeof(Value)) % CACHE_LINE_SIZE == 0,
+                  "B+ tree values are stored inline in whole cache lines");
+
+    alignas(CACHE_LINE_SIZE) Value values[Order];
+    BPlusLeaf *next = nullptr;
+
+    explicit BPlusLeaf(uint64_t version) : BPlusNode<Key, Order>(true, version) {}
+};
+
+// An internal node with count keys has count + 1 children. Each separator
+// is the smallest key of the subtree to its right. Apart from the root,
+// deletes keep every node at least half full by borrowing from or merging
+// with a sibling.
+template <typename Key, int Order>
+struct BPlusInternal : BPlusNode<Key, Order>
+{
+    alignas(CACHE_LINE_SIZE) BPlusNode<Key, Order> *children[Order + 1];
+
+    explicit BPlusInternal(uint64_t version) : BPlusNode<Key, Order>(false, version) {}
+};
+
+// Keys and values are trivially copyable types; Compare is a stateless
+// strict weak order on keys. Int keys under std::less use the SIMD in-node
+// search. std::string keys are handled by the specialization below.
+//
+// find, search and range_search may run alongside insert and remove
+// (optimistic lock coupling). Readers take no locks: they note each node's
+// version, read it, and re-check the version before trusting what they
+// read or stepping to a child, restarting on a mismatch. Writers queue on a
+// tree mutex, version-lock only the nodes they change, and release them
+// together once the change is complete. Freed nodes stay in the pools'
+// slabs and versions never repeat, so a reader holding a stale pointer
+// only ever sees a failed check. The optimistic reads race with writers by
+// design, which is why Key must compare without following pointers.
+// Cursors, size, stats, clear and bulk_load assume no concurrent writer.
+template <typename Key = int, typename Value = int, typename Compare = std::less<Key>,
+          int Order = BPLUS_DEFAULT_ORDER>
+class BasicBPlusTree
+{
+public:
+    using Node = BPlusNode<Key, Order>;
+    using Leaf = BPlusLeaf<Key, Value, Order>;
+    using Internal = BPlusInternal<Key, Order>;
+
+    // Forward position in the leaf chain
+    class Cursor
+    {
+    public:
+        bool valid() const { return leaf != nullptr; }
+        const Key &key() const { return leaf->keys[pos]; }
+        const Value &value() const { return leaf->values[pos]; }
+
+        void next()
+        {
+            pos++;
+            skip_exhausted();
+        }
+
+    private:
+        friend class BasicBPlusTree;
+
+        Cursor(const Leaf *l, int p) : leaf(l), pos(p) { skip_exhausted(); }
+
+        void skip_exhausted()
+        {
+            while (leaf && pos >= leaf->count)
+            {
+                leaf = leaf->next;
+                pos = 0;
+            }
+        }
+
+        const Leaf *leaf;
+        int pos;
+    };
+
+    BasicBPlusTree() = default;
+
+    BasicBPlusTree(const BasicBPlusTree &) = delete;
+    BasicBPlusTree &operator=(const BasicBPlusTree &) = delete;
+
+    BasicBPlusTree(BasicBPlusTree &&other) noexcept { swap(other); }
+
+    BasicBPlusTree &operator=(BasicBPlusTree &&other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            swap(other);
+            other.leaves.release();
+            other.internals.release();
+        }
+        return *this;
+    }
+
+    void insert(const Key &key, const Value &value);
+
+    // Removes key if present, rebalancing underfull nodes and dropping the
+    // root level when it is left with a single child
+    void remove(const Key &key);
+
+    // Replace the contents with (key, value) pairs in strictly ascending key
+    // order, building packed leaves and then each internal level bottom-up.
+    // fill_factor is clamped to [0.5, 1].
+    void bulk_load(const std::vector<std::pair<Key, Value>> &sorted,
+                   double fill_factor = BPLUS_DEFAULT_FILL_FACTOR);
+
+    std::vector<Value> range_search(const Key &min_key, const Key &max_key) const;
+
+    std::vector<Value> search(const Key &key) const;
+
+    // Allocation-free point lookup; returns false when key is absent
+    bool find(const Key &key, Value &value) const;
+
+    // First entry in key order
+    Cursor begin() const;
+
+    // First entry with key >= the given key
+    Cursor lower_bound(const Key &key) const;
+
+    // Drops every node at once; the pools keep their slabs for refilling
+    void clear();
+
+    size_t size() const { return entries; }
+
+    size_t node_count() const { return leaves.get_stats().live + internals.get_stats().live; }
+
+    const NodePoolStats &leaf_pool_stats() const { return leaves.get_stats(); }
+
+    const NodePoolStats &internal_pool_stats() const { return internals.get_stats(); }
+
+    int height() const;
+
+    BPlusTreeStats stats() const;
+
+private:
+    std::atomic<Node *> root{nullptr};
+    size_t entries = 0;
+    NodePool<Leaf> leaves;
+    NodePool<Internal> internals;
+
+    // Writer state, guarded by writer_latch
+    std::mutex writer_latch;
+    uint64_t version_clock = 0;
+    std::vector<Node *> latched; // Version-locked by the running writer
+    std::vector<Node *> retired; // Unlinked by the running writer
+
+    void swap(BasicBPlusTree &other) noexcept
+    {
+        root.store(other.root.exchange(root.load()));
+        std::swap(entries, other.entries);
+        std::swap(leaves, other.leaves);
+        std::swap(internals, other.internals);
+        // Both trees' nodes must stay below either clock
+        version_clock = other.version_clock = std::max(version_clock, other.version_clock);
+    }
+
+    uint64_t next_version() { return version_clock += BPLUS_VERSION_STEP; }
+
+    Leaf *new_leaf() { return leaves.create(next_version()); }
+
+    Internal *new_internal() { return internals.create(next_version()); }
+
+    // Held for the whole of an insert or remove; on release the locked
+    // nodes get fresh versions and the unlinked ones go back to the pools
+    class WriteGuard
+    {
+    public:
+        explicit WriteGuard(BasicBPlusTree &t) : tree(t), latch(t.writer_latch) {}
+        ~WriteGuard() { tree.publish(); }
+
+    private:
+        BasicBPlusTree &tree;
+        std::lock_guard<std::mutex> latch;
+    };
+
+    // Lock a node before the running writer first modifies it
+    void write_lock(Node *node)
+    {
+        uint64_t version = node->version.load(std::memory_order_relaxed);
+        if (version & BPLUS_VERSION_LOCKED)
+            return;
+        node->version.store(version | BPLUS_VERSION_LOCKED, std::memory_order_relaxed);
+        // Order the lock ahead of the writes it covers
+        std::atomic_thread_fence(std::memory_order_release);
+        latched.push_back(node);
+    }
+
+    void publish();
+
+    // Hand an unlinked node back to its pool once the writer finishes
+    void free_node(Node *node) { retired.push_back(node); }
+
+    // Version of a node once no writer holds it; false if it was freed
+    static bool read_version(const Node *node, uint64_t &version)
+    {
+        for (;;)
+        {
+            version = node->version.load(std::memory_order_acquire);
+            if (version & BPLUS_VERSION_OBSOLETE)
+                return false;
+            if (!(version & BPLUS_VERSION_LOCKED))
+                return true;
+            std::this_thread::yield();
+        }
+    }
+
+    // True when no writer touched the node since its version was read
+    static bool validate(const Node *node, uint64_t version)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return node->version.load(std::memory_order_relaxed) == version;
+    }
+
+    // Optimistic descent to the leaf whose range covers key (null for an
+    // empty tree) and that leaf's version; false means restart
+    bool descend(const Key &key, const Leaf *&leaf, uint64_t &version) const;
+
+    const Leaf *find_leaf(const Key &key) const;
+
+    static constexpr bool SIMD_KEYS = std::is_same_v<Key, int> && std::is_same_v<Compare, std::less<int>>;
+
+    static bool less(const Key &a, const Key &b) { return Compare()(a, b); }
+
+    // First slot whose key is >= key / > key
+    static int lower_index(const Key *keys, int count, const Key &key)
+    {
+        if constexpr (SIMD_KEYS)
+            return search_lower_bound_i32(keys, count, key);
+        else
+            return std::lower_bound(keys, keys + count, key, Compare()) - keys;
+    }
+
+    static int upper_index(const Key *keys, int count, const Key &key)
+    {
+        if constexpr (SIMD_KEYS)
+            return search_upper_bound_i32(keys, count, key);
+        else
+            return std::upper_bound(keys, keys + count, key, Compare()) - keys;
+    }
+
+    static void leaf_insert_at(Leaf *leaf, int pos, const Key &key, const Value &value);
+
+    // Minimum keys in a non-root node; two minimal siblings fit in one node
+    static constexpr int MIN_KEYS = Order / 2;
+
+    void rebalance_leaf(Leaf *leaf, Internal *parent, int idx);
+
+    void rebalance_internal(Internal *node, Internal *parent, int idx);
+
+    // Drop separator idx and child idx + 1 from an internal node
+    static void internal_erase_at(Internal *node, int idx);
+};
+
+using BPlusTree = BasicBPlusTree<>;
+
+// ------------------- Template Definitions -------------------
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::leaf_insert_at(Leaf *leaf, int pos, const Key &key, const Value &value)
+{
+    std::copy_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+    std::copy_backward(leaf->values + pos, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+    leaf->keys[pos] = key;
+    leaf->values[pos] = value;
+    leaf->count++;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::insert(const Key &key, const Value &value)
+{
+    WriteGuard guard(*this);
+    if (root.load(std::memory_order_relaxed) == nullptr)
+    {
+        Leaf *leaf = new_leaf();
+        leaf->keys[0] = key;
+        leaf->values[0] = value;
+        leaf->count = 1;
+        root.store(leaf, std::memory_order_release);
+        entries = 1;
+        return;
+    }
+
+    // Descend, remembering each internal node and the child slot taken
+    Internal *path[BPLUS_MAX_HEIGHT];
+    int slots[BPLUS_MAX_HEIGHT];
+    int depth = 0;
+    Node *current = root;
+    while (!current->is_leaf)
+    {
+        Internal *inner = static_cast<Internal *>(current);
+        int idx = upper_index(inner->keys, inner->count, key);
+        path[depth] = inner;
+        slots[depth] = idx;
+        depth++;
+        current = inner->children[idx];
+    }
+
+    Leaf *leaf = static_cast<Leaf *>(current);
+    int pos = lower_index(leaf->keys, leaf->count, key);
+
+    // Check for duplicate key
+    if (pos < leaf->count && !less(key, leaf->keys[pos]))
+    {
+        throw std::runtime_error("Duplicate key");
+    }
+
+    entries++;
+    write_lock(leaf);
+    if (leaf->count < Order)
+    {
+        leaf_insert_at(leaf, pos, key, value);
+        return;
+    }
+
+    // Split the full leaf so that the left half ends up with `split` entries
+    Leaf *right = new_leaf();
+    const int split = (Order + 1) / 2;
+    int first_moved = pos < split ? split - 1 : split;
+    right->count = Order - first_moved;
+    std::copy(leaf->keys + first_moved, leaf->keys + Order, right->keys);
+    std::copy(leaf->values + first_moved, leaf->values + Order, right->values);
+    leaf->count = first_moved;
+    if (pos < split)
+        leaf_insert_at(leaf, pos, key, value);
+    else
+        leaf_insert_at(right, pos - split, key, value);
+
+    right->next = leaf->next;
+    leaf->next = right;
+
+    Key separator = right->keys[0];
+    Node *new_child = right;
+
+    // Push the separator up the recorded path, splitting full parents
+    while (depth > 0)
+    {
+        depth--;
+        Internal *parent = path[depth];
+        int idx = slots[depth];
+        write_lock(parent);
+
+        if (parent->count < Order)
+        {
+            std::copy_backward(parent->keys + idx, parent->keys + parent->count,
+                               parent->keys + parent->count + 1);
+            std::copy_backward(parent->children + idx + 1, parent->children + parent->count + 1,
+                               parent->children + parent->count + 2);
+            parent->keys[idx] = separator;
+            parent->children[idx + 1] = new_child;
+            parent->count++;
+            return;
+        }
+
+        // Lay out all Order + 1 keys and Order + 2 children, then hand the
+        // middle key up and the upper half to a new sibling
+        Key all_keys[Order + 1];
+        Node *all_children[Order + 2];
+        std::copy(parent->keys, parent->keys + idx, all_keys);
+        all_keys[idx] = separator;
+        std::copy(parent->keys + idx, parent->keys + Order, all_keys + idx + 1);
+        std::copy(parent->children, parent->children + idx + 1, all_children);
+        all_children[idx + 1] = new_child;
+        std::copy(parent->children + idx + 1, parent->children + Order + 1, all_children + idx + 2);
+
+        const int mid = (Order + 1) / 2;
+        Internal *sibling = new_internal();
+        parent->count = mid;
+        std::copy(all_keys, all_keys + mid, parent->keys);
+        std::copy(all_children, all_children + mid + 1, parent->children);
+        sibling->count = Order - mid;
+        std::copy(all_keys + mid + 1, all_keys + Order + 1, sibling->keys);
+        std::copy(all_children + mid + 1, all_children + Order + 2, sibling->children);
 
-    BPlusNode(bool leaf = false) : is_leaf(leaf), next(nullptr), parent(nullptr) {}
+        separator = all_keys[mid];
+        new_child = sibling;
+    }
+
+    // The root split: grow a new root above both halves
+    Internal *new_root = new_internal();
+    new_root->keys[0] = separator;
+    new_root->children[0] = root.load(std::memory_order_relaxed);
+    new_root->children[1] = new_child;
+    new_root->count = 1;
+    root.store(new_root, std::memory_order_release);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::remove(const Key &key)
+{
+    WriteGuard guard(*this);
+    if (!root.load(std::memory_order_relaxed))
+        return;
+
+    Internal *path[BPLUS_MAX_HEIGHT];
+    int slots[BPLUS_MAX_HEIGHT];
+    int depth = 0;
+    Node *current = root;
+    while (!current->is_leaf)
+    {
+        Internal *inner = static_cast<Internal *>(current);
+        int idx = upper_index(inner->keys, inner->count, key);
+        path[depth] = inner;
+        slots[depth] = idx;
+        depth++;
+        current = inner->children[idx];
+    }
+
+    Leaf *leaf = static_cast<Leaf *>(current);
+    int pos = lower_index(leaf->keys, leaf->count, key);
+    if (pos == leaf->count || less(key, leaf->keys[pos]))
+        return;
+
+    write_lock(leaf);
+    std::copy(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+    std::copy(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+    leaf->count--;
+    entries--;
+
+    if (depth == 0)
+    {
+        if (leaf->count == 0)
+        {
+            root.store(nullptr, std::memory_order_release);
+            free_node(leaf);
+        }
+        return;
+    }
+
+    // The leaf's smallest key changed: refresh the separator above it, held
+    // by the nearest ancestor where the path does not take the first child
+    if (pos == 0 && leaf->count > 0)
+    {
+        for (int d = depth - 1; d >= 0; d--)
+        {
+            if (slots[d] > 0)
+            {
+                write_lock(path[d]);
+                path[d]->keys[slots[d] - 1] = leaf->keys[0];
+                break;
+            }
+        }
+    }
+
+    if (leaf->count >= MIN_KEYS)
+        return;
+    rebalance_leaf(leaf, path[depth - 1], slots[depth - 1]);
+
+    // Merges remove a separator from the parent; carry any underflow upward
+    for (int d = depth - 1; d > 0; d--)
+    {
+        if (path[d]->count >= MIN_KEYS)
+            return;
+        rebalance_internal(path[d], path[d - 1], slots[d - 1]);
+    }
+
+    Internal *top = path[0];
+    if (top->count == 0)
+    {
+        root.store(top->children[0], std::memory_order_release);
+        free_node(top);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::internal_erase_at(Internal *node, int idx)
+{
+    std::copy(node->keys + idx + 1, node->keys + node->count, node->keys + idx);
+    std::copy(node->children + idx + 2, node->children + node->count + 1, node->children + idx + 1);
+    node->count--;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::rebalance_leaf(Leaf *leaf, Internal *parent, int idx)
+{
+    Leaf *left = idx > 0 ? static_cast<Leaf *>(parent->children[idx - 1]) : nullptr;
+    Leaf *right = idx < parent->count ? static_cast<Leaf *>(parent->children[idx + 1]) : nullptr;
+    write_lock(parent);
+
+    if (left && left->count > MIN_KEYS)
+    {
+        write_lock(left);
+        left->count--;
+        leaf_insert_at(leaf, 0, left->keys[left->count], left->values[left->count]);
+        parent->keys[idx - 1] = leaf->keys[0];
+        return;
+    }
+    if (right && right->count > MIN_KEYS)
+    {
+        write_lock(right);
+        leaf->keys[leaf->count] = right->keys[0];
+        leaf->values[leaf->count] = right->values[0];
+        leaf->count++;
+        std::copy(right->keys + 1, right->keys + right->count, right->keys);
+        std::copy(right->values + 1, right->values + right->count, right->values);
+        right->count--;
+        parent->keys[idx] = right->keys[0];
+        return;
+    }
+
+    // Neither sibling can lend: fold the right-hand node of a pair into the
+    // left-hand one and unlink it from the leaf chain
+    if (left)
+    {
+        right = leaf;
+        leaf = left;
+        idx--;
+    }
+    write_lock(leaf);
+    std::copy(right->keys, right->keys + right->count, leaf->keys + leaf->count);
+    std::copy(right->values, right->values + right->count, leaf->values + leaf->count);
+    leaf->count += right->count;
+    leaf->next = right->next;
+    internal_erase_at(parent, idx);
+    free_node(right);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::rebalance_internal(Internal *node, Internal *parent, int idx)
+{
+    Internal *left = idx > 0 ? static_cast<Internal *>(parent->children[idx - 1]) : nullptr;
+    Internal *right = idx < parent->count ? static_cast<Internal *>(parent->children[idx + 1]) : nullptr;
+    write_lock(node);
+    write_lock(parent);
+
+    // Borrowing rotates through the parent: the separator comes down and
+    // the sibling's edge key goes up in its place
+    if (left && left->count > MIN_KEYS)
+    {
+        write_lock(left);
+        std::copy_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+        std::copy_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+        node->keys[0] = parent->keys[idx - 1];
+        node->children[0] = left->children[left->count];
+        node->count++;
+        parent->keys[idx - 1] = left->keys[left->count - 1];
+        left->count--;
+        return;
+    }
+    if (right && right->count > MIN_KEYS)
+    {
+        write_lock(right);
+        node->keys[node->count] = parent->keys[idx];
+        node->children[node->count + 1] = right->children[0];
+        node->count++;
+        parent->keys[idx] = right->keys[0];
+        std::copy(right->keys + 1, right->keys + right->count, right->keys);
+        std::copy(right->children + 1, right->children + right->count + 1, right->children);
+        right->count--;
+        return;
+    }
+
+    // Merge the pair around separator idx, pulling that separator down
+    if (left)
+    {
+        right = node;
+        node = left;
+        idx--;
+    }
+    write_lock(node);
+    node->keys[node->count] = parent->keys[idx];
+    std::copy(right->keys, right->keys + right->count, node->keys + node->count + 1);
+    std::copy(right->children, right->children + right->count + 1, node->children + node->count + 1);
+    node->count += right->count + 1;
+    internal_erase_at(parent, idx);
+    free_node(right);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::bulk_load(const std::vector<std::pair<Key, Value>> &sorted, double fill_factor)
+{
+    for (size_t i = 1; i < sorted.size(); i++)
+    {
+        if (less(sorted[i].first, sorted[i - 1].first))
+            throw std::runtime_error("Bulk load input is not sorted");
+        if (!less(sorted[i - 1].first, sorted[i].first))
+            throw std::runtime_error("Duplicate key");
+    }
+
+    clear();
+    if (sorted.empty())
+        return;
+
+    // Fanout of at least 3 keeps every evenly split internal node at two or
+    // more children
+    fill_factor = std::clamp(fill_factor, 0.5, 1.0);
+    const size_t leaf_fill = std::max<size_t>(1, static_cast<size_t>(Order * fill_factor));
+    const size_t fanout = std::max<size_t>(3, static_cast<size_t>((Order + 1) * fill_factor));
+
+    // Each level spreads its items evenly over the fewest nodes that respect
+    // the fill limit; low_keys[i] is the smallest key under level[i]
+    std::vector<Node *> level;
+    std::vector<Key> low_keys;
+    const size_t n = sorted.size();
+    const size_t leaves = (n + leaf_fill - 1) / leaf_fill;
+    level.reserve(leaves);
+    low_keys.reserve(leaves);
+    Leaf *prev = nullptr;
+    size_t pos = 0;
+    for (size_t l = 0; l < leaves; l++)
+    {
+        int take = static_cast<int>(n / leaves + (l < n % leaves));
+        Leaf *leaf = new_leaf();
+        for (int j = 0; j < take; j++, pos++)
+        {
+            leaf->keys[j] = sorted[pos].first;
+            leaf->values[j] = sorted[pos].second;
+        }
+        leaf->count = take;
+        if (prev)
+            prev->next = leaf;
+        prev = leaf;
+        level.push_back(leaf);
+        low_keys.push_back(leaf->keys[0]);
+    }
+
+    while (level.size() > 1)
+    {
+        const size_t m = level.size();
+        const size_t parents = (m + fanout - 1) / fanout;
+        std::vector<Node *> upper;
+        std::vector<Key> upper_low_keys;
+        upper.reserve(parents);
+        upper_low_keys.reserve(parents);
+        size_t child = 0;
+        for (size_t p = 0; p < parents; p++)
+        {
+            int take = static_cast<int>(m / parents + (p < m % parents));
+            Internal *inner = new_internal();
+            inner->children[0] = level[child];
+            for (int j = 1; j < take; j++)
+            {
+                inner->keys[j - 1] = low_keys[child + j];
+                inner->children[j] = level[child + j];
+            }
+            inner->count = take - 1;
+            upper.push_back(inner);
+            upper_low_keys.push_back(low_keys[child]);
+            child += take;
+        }
+        level.swap(upper);
+        low_keys.swap(upper_low_keys);
+    }
+
+    root = level[0];
+    entries = n;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+std::vector<Value> BasicBPlusTree<Key, Value, Compare, Order>::range_search(const Key &min_key,
+                                                                           const Key &max_key) const
+{
+    std::vector<Value> results;
+    // After a restart, resume past the last key already taken
+    Key resume = min_key;
+    bool resumed = false;
+    for (;;)
+    {
+        const Leaf *leaf;
+        uint64_t version;
+        if (!descend(resume, leaf, version))
+            continue;
+        if (!leaf)
+            return results;
+
+        int pos = resumed ? upper_index(leaf->keys, leaf->count, resume)
+                          : lower_index(leaf->keys, leaf->count, resume);
+        for (;;)
+        {
+            // Walk the chain leaf by leaf, keeping a leaf's entries only
+            // once its version still holds
+            size_t kept = results.size();
+            int count = leaf->count;
+            for (; pos < count && !less(max_key, leaf->keys[pos]); pos++)
+                results.push_back(leaf->values[pos]);
+            Key last = pos > 0 ? leaf->keys[pos - 1] : resume;
+            const Leaf *next = leaf->next;
+            if (!validate(leaf, version))
+            {
+                results.resize(kept);
+                break;
+            }
+            if (results.size() > kept)
+            {
+                resume = last;
+                resumed = true;
+            }
+            if (pos < count || !next)
+                return results;
+
+            uint64_t next_version;
+            if (!read_version(next, next_version) || !validate(leaf, version))
+                break;
+            leaf = next;
+            version = next_version;
+            pos = 0;
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+std::vector<Value> BasicBPlusTree<Key, Value, Compare, Order>::search(const Key &key) const
+{
+    std::vector<Value> results;
+    Value value;
+    if (find(key, value))
+        results.push_back(value);
+    return results;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::find(const Key &key, Value &value) const
+{
+    for (;;)
+    {
+        const Leaf *leaf;
+        uint64_t version;
+        if (!descend(key, leaf, version))
+            continue;
+        if (!leaf)
+            return false;
+
+        int count = leaf->count;
+        int pos = lower_index(leaf->keys, count, key);
+        bool found = pos < count && !less(key, leaf->keys[pos]);
+        Value candidate = found ? leaf->values[pos] : Value();
+        if (!validate(leaf, version))
+            continue;
+        if (found)
+            value = candidate;
+        return found;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+bool BasicBPlusTree<Key, Value, Compare, Order>::descend(const Key &key, const Leaf *&leaf, uint64_t &version) const
+{
+    leaf = nullptr;
+    const Node *node = root.load(std::memory_order_acquire);
+    if (!node)
+        return true;
+    // A root that split or collapsed after the load is no longer the root
+    if (!read_version(node, version) || node != root.load(std::memory_order_acquire))
+        return false;
+
+    while (!node->is_leaf)
+    {
+        const Internal *inner = static_cast<const Internal *>(node);
+        const Node *child = inner->children[upper_index(inner->keys, inner->count, key)];
+        // The first check makes the child pointer safe to follow, the
+        // second that it was still this node's child when its version was
+        // read
+        uint64_t child_version;
+        if (!validate(node, version) || !read_version(child, child_version) || !validate(node, version))
+            return false;
+        node = child;
+        version = child_version;
+    }
+    leaf = static_cast<const Leaf *>(node);
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::publish()
+{
+    for (Node *node : latched)
+    {
+        if (std::find(retired.begin(), retired.end(), node) == retired.end())
+            node->version.store(next_version(), std::memory_order_release);
+    }
+    for (Node *node : retired)
+    {
+        node->version.store(next_version() | BPLUS_VERSION_OBSOLETE, std::memory_order_release);
+        if (node->is_leaf)
+            leaves.destroy(static_cast<Leaf *>(node));
+        else
+            internals.destroy(static_cast<Internal *>(node));
+    }
+    latched.clear();
+    retired.clear();
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+typename BasicBPlusTree<Key, Value, Compare, Order>::Cursor BasicBPlusTree<Key, Value, Compare, Order>::begin() const
+{
+    const Node *current = root;
+    while (current && !current->is_leaf)
+        current = static_cast<const Internal *>(current)->children[0];
+    return Cursor(static_cast<const Leaf *>(current), 0);
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+typename BasicBPlusTree<Key, Value, Compare, Order>::Cursor BasicBPlusTree<Key, Value, Compare, Order>::lower_bound(const Key &key) const
+{
+    const Leaf *leaf = find_leaf(key);
+    if (!leaf)
+        return Cursor(nullptr, 0);
+    return Cursor(leaf, lower_index(leaf->keys, leaf->count, key));
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+void BasicBPlusTree<Key, Value, Compare, Order>::clear()
+{
+    root = nullptr;
+    entries = 0;
+    leaves.reset();
+    internals.reset();
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+BPlusTreeStats BasicBPlusTree<Key, Value, Compare, Order>::stats() const
+{
+    BPlusTreeStats out;
+    out.entries = entries;
+    out.height = height();
+    out.leaves = leaves.get_stats().live;
+    out.internals = internals.get_stats().live;
+    out.reserved_bytes = leaves.get_stats().reserved_bytes + internals.get_stats().reserved_bytes;
+    if (out.leaves > 0)
+        out.leaf_fill = double(entries) / (double(out.leaves) * Order);
+    // Every node except the root is exactly one internal node's child
+    if (out.internals > 0)
+        out.internal_fill = double(out.leaves + out.internals - 1) / (double(out.internals) * (Order + 1));
+    return out;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+int BasicBPlusTree<Key, Value, Compare, Order>::height() const
+{
+    int levels = 0;
+    for (const Node *current = root; current; levels++)
+    {
+        if (current->is_leaf)
+            return levels + 1;
+        current = static_cast<const Internal *>(current)->children[0];
+    }
+    return levels;
+}
+
+template <typename Key, typename Value, typename Compare, int Order>
+const typename BasicBPlusTree<Key, Value, Compare, Order>::Leaf *BasicBPlusTree<Key, Value, Compare, Order>::find_leaf(const Key &key) const
+{
+    const Node *current = root;
+    if (!current)
+        return nullptr;
+    while (!current->is_leaf)
+    {
+        // Separators are the first key of their right subtree, same as insert
+        const Internal *inner = static_cast<const Internal *>(current);
+        current = inner->children[upper_index(inner->keys, inner->count, key)];
+    }
+    return static_cast<const Leaf *>(current);
+}
+
+// ------------------- String Keys -------------------
+// A string key as held in tree nodes: the first 8 bytes packed big-endian
+// into `head` (zero padded), so most comparisons settle on one integer
+// compare, and a view of the full bytes, which live out of line.
+struct StringKey
+{
+    uint64_t head;
+    const char *data;
+    uint32_t length;
+
+    static StringKey of(std::string_view bytes)
+    {
+        if (bytes.size() > UINT32_MAX)
+            throw std::runtime_error("Key too long");
+        uint64_t head = 0;
+        for (size_t i = 0; i < std::min<size_t>(bytes.size(), 8); i++)
+            head |= uint64_t(static_cast<unsigned char>(bytes[i])) << (56 - 8 * i);
+        return {head, bytes.data(), static_cast<uint32_t>(bytes.size())};
+    }
+
+    std::string_view view() const { return std::string_view(data, length); }
+};
+
+// Bytewise (memcmp) order; a proper prefix sorts first
+struct StringKeyLess
+{
+    bool operator()(const StringKey &a, const StringKey &b) const
+    {
+        if (a.head != b.head)
+            return a.head < b.head;
+        uint32_t common = std::min(a.length, b.length);
+        if (common > 8)
+        {
+            int c = std::memcmp(a.data + 8, b.data + 8, common - 8);
+            if (c != 0)
+                return c < 0;
+        }
+        return a.length < b.length;
+    }
 };
 
-class BPlusTree
+// Append-only chunks of key bytes. Stored bytes never move, so tree nodes
+// can point at them; space is only reclaimed by copying the live keys into
+// a fresh arena.
+class KeyArena
 {
+public:
+    static constexpr size_t CHUNK_BYTES = 64 * 1024;
+
+    const char *store(std::string_view bytes)
+    {
+        if (bytes.empty())
+            return nullptr;
+        if (bytes.size() > capacity - used)
+        {
+            capacity = std::max(CHUNK_BYTES, bytes.size());
+            chunks.emplace_back(new char[capacity]);
+            used = 0;
+            reserved += capacity;
+        }
+        char *out = chunks.back().get() + used;
+        std::memcpy(out, bytes.data(), bytes.size());
+        used += bytes.size();
+        return out;
+    }
+
+    // Give back the bytes of the latest store()
+    void unstore(size_t length) { used -= std::min(used, length); }
+
+    size_t reserved_bytes() const { return reserved; }
+
 private:
-    BPlusNode *root;
-    void insertInternal(int key, BPlusNode *child, BPlusNode *parent);
+    std::vector<std::unique_ptr<char[]>> chunks;
+    size_t capacity = 0; // Size of the newest chunk
+    size_t used = 0;     // Bytes handed out from the newest chunk
+    size_t reserved = 0;
+};
+
+// String-keyed tree: nodes hold fixed-size StringKeys (inline 8-byte head
+// plus a pointer into the tree's KeyArena), so node layout, search and
+// pools are those of the generic tree. Keys compare bytewise, which is the
+// order composite keys encoded by append_key_bytes rely on.
+template <typename Value, typename Compare, int Order>
+class BasicBPlusTree<std::string, Value, Compare, Order>
+{
+    static_assert(std::is_same_v<Compare, std::less<std::string>>, "String keys are ordered bytewise");
+
+    using Tree = BasicBPlusTree<StringKey, Value, StringKeyLess, Order>;
 
 public:
-    BPlusTree() : root(nullptr) {}
+    class Cursor
+    {
+    public:
+        bool valid() const { return inner.valid(); }
+        std::string_view key() const { return inner.key().view(); }
+        const Value &value() const { return inner.value(); }
+        void next() { inner.next(); }
+
+    private:
+        friend class BasicBPlusTree;
+
+        explicit Cursor(const typename Tree::Cursor &c) : inner(c) {}
+
+        typename Tree::Cursor inner;
+    };
+
+    void insert(std::string_view key, const Value &value)
+    {
+        StringKey stored = store_key(arena, key);
+        try
+        {
+            tree.insert(stored, value);
+        }
+        catch (...)
+        {
+            arena.unstore(key.size());
+            throw;
+        }
+        live_bytes += key.size();
+    }
+
+    void remove(std::string_view key)
+    {
+        size_t before = tree.size();
+        tree.remove(StringKey::of(key));
+        if (tree.size() == before)
+            return;
+
+        // A removed key may survive as a separator, so its bytes stay until
+        // garbage outweighs the live keys and they are copied out
+        live_bytes -= key.size();
+        dead_bytes += key.size();
+        if (dead_bytes >= KeyArena::CHUNK_BYTES && dead_bytes > live_bytes)
+            compact_keys();
+    }
+
+    void bulk_load(const std::vector<std::pair<std::string, Value>> &sorted,
+                   double fill_factor = BPLUS_DEFAULT_FILL_FACTOR)
+    {
+        KeyArena fresh;
+        std::vector<std::pair<StringKey, Value>> entries;
+        entries.reserve(sorted.size());
+        size_t bytes = 0;
+        for (const auto &entry : sorted)
+        {
+            entries.push_back({store_key(fresh, entry.first), entry.second});
+            bytes += entry.first.size();
+        }
+        tree.bulk_load(entries, fill_factor);
+        arena = std::move(fresh);
+        live_bytes = bytes;
+        dead_bytes = 0;
+    }
+
+    std::vector<Value> range_search(std::string_view min_key, std::string_view max_key) const
+    {
+        return tree.range_search(StringKey::of(min_key), StringKey::of(max_key));
+    }
 
-    void insert(int key, int value);
-    
-    void remove(int key);
+    std::vector<Value> search(std::string_view key) const { return tree.search(StringKey::of(key)); }
 
-    std::vector<int> range_search(int min_key, int max_key);
+    bool find(std::string_view key, Value &value) const { return tree.find(StringKey::of(key), value); }
 
-    std::vector<int> search(int key);
+    Cursor begin() const { return Cursor(tree.begin()); }
+
+    Cursor lower_bound(std::string_view key) const { return Cursor(tree.lower_bound(StringKey::of(key))); }
+
+    void clear()
+    {
+        tree.clear();
+        arena = KeyArena();
+        live_bytes = 0;
+        dead_bytes = 0;
+    }
+
+    size_t size() const { return tree.size(); }
+
+    size_t node_count() const { return tree.node_count(); }
+
+    const NodePoolStats &leaf_pool_stats() const { return tree.leaf_pool_stats(); }
+
+    const NodePoolStats &internal_pool_stats() const { return tree.internal_pool_stats(); }
+
+    int height() const { return tree.height(); }
+
+    BPlusTreeStats stats() const
+    {
+        BPlusTreeStats out = tree.stats();
+        out.key_bytes = arena.reserved_bytes();
+        return out;
+    }
 
 private:
-    BPlusNode *find_leaf(int key);
+    Tree tree;
+    KeyArena arena;
+    size_t live_bytes = 0; // Bytes of keys in the tree
+    size_t dead_bytes = 0; // Bytes of removed keys still in the arena
+
+    static StringKey store_key(KeyArena &into, std::string_view key)
+    {
+        StringKey probe = StringKey::of(key);
+        return StringKey::of(std::string_view(into.store(key), probe.length));
+    }
+
+    void compact_keys()
+    {
+        KeyArena fresh;
+        std::vector<std::pair<StringKey, Value>> entries;
+        entries.reserve(tree.size());
+        for (auto it = tree.begin(); it.valid(); it.next())
+            entries.push_back({store_key(fresh, it.key().view()), it.value()});
+        tree.bulk_load(entries);
+        arena = std::move(fresh);
+        dead_bytes = 0;
+    }
 };
 
-#endif // BPLUSTREE_H
\ No newline at end of file
+extern template class BasicBPlusTree<int, int, std::less<int>, BPLUS_DEFAULT_ORDER>;
+extern template class BasicBPlusTree<StringKey, int, StringKeyLess, BPLUS_DEFAULT_ORDER>;
+
+#endif // BPLUSTREE_H
@@ -0,0 +1,137 @@
+#ifndef BINARYCODEC_H
+#define BINARYCODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "Table.h"
+
+// ------------------- Binary Codec -------------------
+// Little helpers behind the WAL record and checkpoint formats: fixed-width
+// fields in host byte order, length-prefixed strings and tagged Values.
+
+enum class ValueTag : uint8_t
+{
+    INT,
+    FLOAT,
+    STRING
+};
+
+class BinaryWriter
+{
+public:
+    explicit BinaryWriter(std::string &buffer) : out(buffer) {}
+
+    template <typename T>
+    void put(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain fields are written bytewise");
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void put_bytes(const void *data, size_t length) { out.append(static_cast<const char *>(data), length); }
+
+    void put_string(std::string_view text)
+    {
+        put<uint32_t>(static_cast<uint32_t>(text.size()));
+        out.append(text.data(), text.size());
+    }
+
+    void put_value(const Value &value)
+    {
+        if (std::holds_alternative<int>(value))
+        {
+            put(ValueTag::INT);
+            put<int32_t>(std::get<int>(value));
+        }
+        else if (std::holds_alternative<float>(value))
+        {
+            put(ValueTag::FLOAT);
+            put<float>(std::get<float>(value));
+        }
+        else
+        {
+            put(ValueTag::STRING);
+            put_string(std::get<std::string>(value));
+        }
+    }
+
+    size_t size() const { return out.size(); }
+
+private:
+    std::string &out;
+};
+
+// Reads what BinaryWriter wrote; running off the end throws
+class BinaryReader
+{
+public:
+    BinaryReader(const char *data, size_t length) : pos(data), end(data + length) {}
+
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain fields are read bytewise");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Pointer to the next length bytes, which the caller copies out
+    const char *take(size_t length)
+    {
+        if (length > static_cast<size_t>(end - pos))
+            throw std::runtime_error("Truncated data");
+        const char *at = pos;
+        pos += length;
+        return at;
+    }
+
+    std::string get_string()
+    {
+        uint32_t length = get<uint32_t>();
+        return std::string(take(length), length);
+    }
+
+    Value get_value()
+    {
+        switch (get<ValueTag>())
+        {
+        case ValueTag::INT:
+            return get<int32_t>();
+        case ValueTag::FLOAT:
+            return get<float>();
+        case ValueTag::STRING:
+            return get_string();
+        }
+        throw std::runtime_error("Corrupt value tag");
+    }
+
+    void skip_value()
+    {
+        switch (get<ValueTag>())
+        {
+        case ValueTag::INT:
+            take(sizeof(int32_t));
+            return;
+        case ValueTag::FLOAT:
+            take(sizeof(float));
+            return;
+        case ValueTag::STRING:
+            take(get<uint32_t>());
+            return;
+        }
+        throw std::runtime_error("Corrupt value tag");
+    }
+
+    bool done() const { return pos == end; }
+
+private:
+    const char *pos;
+    const char *end;
+};
+
+#endif // BINARYCODEC_H
@@ -0,0 +1,146 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ------------------- Buffer Pool -------------------
+// Fixed-size pages of one spill file, cached in a bounded set of frames.
+// A page is pinned while a PageGuard holds it and is never evicted while
+// pinned; unpinned pages are replaced with the CLOCK algorithm, writing
+// dirty ones back first. The file is created (already unlinked) on the
+// first page allocation, so it lives exactly as long as the pool.
+//
+// The pool only protects its own bookkeeping. Whoever owns a page keeps
+// concurrent readers and writers of its bytes apart (tables do it with
+// their latch).
+
+constexpr size_t PAGE_SIZE = 8192;
+
+constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+
+// Frames unless SET BUFFER_POOL_MB says otherwise (64 MiB)
+constexpr size_t DEFAULT_POOL_PAGES = 8192;
+
+// Fewest frames a pool keeps, so concurrent scans can always pin a page
+constexpr size_t MIN_POOL_PAGES = 64;
+
+struct BufferPoolStats
+{
+    size_t capacity = 0;   // Frames allowed
+    size_t resident = 0;   // Frames holding a page
+    size_t pinned = 0;
+    size_t dirty = 0;
+    size_t file_pages = 0; // Pages allocated in the spill file, live or free
+    size_t free_pages = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t writebacks = 0;
+};
+
+class BufferPool;
+
+// Pin on one resident page; unpins when destroyed
+class PageGuard
+{
+public:
+    PageGuard() = default;
+    PageGuard(PageGuard &&other) noexcept;
+    PageGuard &operator=(PageGuard &&other) noexcept;
+    ~PageGuard();
+
+    PageGuard(const PageGuard &) = delete;
+    PageGuard &operator=(const PageGuard &) = delete;
+
+    uint32_t id() const { return page; }
+
+    const char *data() const { return bytes; }
+
+    // Writable bytes; the page is written back before it is evicted
+    char *mutable_data();
+
+private:
+    friend class BufferPool;
+    PageGuard(BufferPool *owner, size_t frame_index, uint32_t page_id, char *frame_bytes)
+        : pool(owner), frame(frame_index), page(page_id), bytes(frame_bytes) {}
+
+    void release();
+
+    BufferPool *pool = nullptr;
+    size_t frame = 0;
+    uint32_t page = INVALID_PAGE;
+    char *bytes = nullptr;
+    bool dirty = false;
+};
+
+class BufferPool
+{
+public:
+    explicit BufferPool(size_t capacity_pages = DEFAULT_POOL_PAGES);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Pin a page, reading it from the spill file when it is not resident.
+    // Throws when every frame is pinned.
+    PageGuard fetch(uint32_t page_id);
+
+    // Pin a fresh zeroed page, reusing a freed page id when there is one
+    PageGuard allocate();
+
+    // Give an unpinned page back for reuse; its contents are dropped
+    void free_page(uint32_t page_id);
+
+    // Change the frame budget; unpinned pages beyond it are evicted now
+    void set_capacity(size_t pages);
+
+    // Directory the spill file goes in; only before the first allocation
+    void set_directory(const std::string &dir);
+
+    BufferPoolStats stats() const;
+
+private:
+    friend class PageGuard;
+
+    struct Frame
+    {
+        uint32_t page = INVALID_PAGE;
+        uint32_t pins = 0;
+        bool referenced = false; // CLOCK second-chance bit
+        bool dirty = false;
+    };
+
+    mutable std::mutex mutex;
+    std::string directory;
+    int fd = -1;
+    size_t capacity;
+    std::vector<Frame> frames;
+    std::vector<std::unique_ptr<char[]>> frame_bytes;
+    std::unordered_map<uint32_t, size_t> page_table; // Page id -> frame
+    std::vector<size_t> empty_frames;
+    size_t resident = 0;
+    size_t clock_hand = 0;
+    uint32_t next_page = 0;
+    std::vector<uint32_t> free_ids;
+    BufferPoolStats counters;
+
+    // Frame to load a page into: an empty one, a new one while under
+    // capacity, or the CLOCK victim. Called with the mutex held.
+    size_t claim_frame();
+
+    // Write a dirty frame back and forget its page. Mutex held.
+    void evict(size_t frame_index);
+
+    void unpin(size_t frame_index, bool dirty);
+
+    void open_file();
+};
+
+#endif // BUFFERPOOL_H
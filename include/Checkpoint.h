@@ -0,0 +1,55 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BufferPool.h"
+#include "Table.h"
+
+// ------------------- Checkpoint -------------------
+// Binary snapshot of every table: schema, live rows (typed column arrays
+// for COLUMNAR tables, tagged values for ROW tables), primary-key entries
+// in key order and secondary index definitions. Together with the log
+// generation it was taken at, it is everything recovery starts from.
+
+struct CheckpointContents
+{
+    uint64_t wal_generation = 0; // Logs of this generation apply on top
+    std::vector<std::unique_ptr<Table>> tables;
+    size_t bytes = 0;
+};
+
+// Write the snapshot to path atomically: a temporary file is synced, then
+// renamed over the old one. Callers keep the tables from changing meanwhile.
+// Returns the file size.
+size_t write_checkpoint(const std::string &path, const std::vector<const Table *> &tables,
+                        uint64_t wal_generation);
+
+// Map the snapshot at path and rebuild its tables, bulk loading the
+// primary keys from their stored order; PAGED tables get their pages from
+// pool. A missing file loads as empty.
+CheckpointContents load_checkpoint(const std::string &path, BufferPool &pool);
+
+// Read-only private mapping of a whole file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return static_cast<const char *>(base); }
+
+    size_t size() const { return length; }
+
+private:
+    void *base = nullptr;
+    size_t length = 0;
+};
+
+#endif // CHECKPOINT_H
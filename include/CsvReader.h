@@ -0,0 +1,42 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Table.h"
+
+// ------------------- CSV Reader -------------------
+// Parses CSV bytes straight into typed rows for COPY. One record per line
+// (a trailing \r is dropped, blank lines are skipped); fields may be
+// quoted, with "" standing for a quote inside them, but may not span
+// lines. INT and FLOAT fields must be a number, in range, and nothing else.
+
+struct CsvOptions
+{
+    char delimiter = ',';
+    bool header = false; // Skip the first line
+};
+
+// Rows parsed from one chunk. On a malformed line parsing stops, error
+// says why and error_line counts lines from the chunk start (1-based).
+struct CsvBatch
+{
+    std::vector<std::vector<Value>> rows;
+    size_t lines = 0; // Lines read, counting blank ones
+    size_t error_line = 0;
+    std::string error;
+};
+
+// Cut [0, size) into ranges of about target_bytes, each starting at the
+// beginning of a line
+std::vector<std::pair<size_t, size_t>> split_csv(const char *data, size_t size, size_t target_bytes);
+
+// Parse the lines of [begin, end), converting each field to its column's
+// type
+CsvBatch parse_csv(const char *begin, const char *end, const std::vector<ColumnType> &types,
+                   char delimiter);
+
+#endif // CSVREADER_H
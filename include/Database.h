@@ -3,16 +3,26 @@
 
 #include <string>
 #include <variant>
-#include "BPlusTree.h"
+#include "Table.h"
+#include "BufferPool.h"
+#include "ThreadPool.h"
+#include "WriteAheadLog.h"
+#include "CsvReader.h"
+#include "ResultCursor.h"
 #include <iomanip> // for std::setw
 #include <numeric> // for std::accumulate
 #include <iostream>
 #include <unordered_map>
 #include <sstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 // ------------------- Database Components -------------------
-using Value = std::variant<int, float, std::string>;
-
 struct Condition
 {
     std::string column;
@@ -27,39 +37,171 @@ struct Condition
     std::string right_col;
 };
 
-struct Column
+enum class AggregateFunction
+{
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG
+};
+
+// One output column of a SELECT: a column, or an aggregate of one (column
+// "*" for COUNT(*)). Columns may be qualified as table.column.
+struct SelectItem
+{
+    std::string column;
+    bool aggregate = false;
+    AggregateFunction function = AggregateFunction::COUNT;
+    std::string name; // Header, as written
+};
+
+// An ORDER BY key: a column, or the header of an aggregate in the select list
+struct OrderItem
+{
+    std::string column;
+    bool descending = false;
+};
+
+// SelectQuery::limit when there is no LIMIT
+constexpr size_t NO_LIMIT = size_t(-1);
+
+// A parsed SELECT; Database::open_query plans it into an operator tree
+struct SelectQuery
+{
+    std::string table;
+    std::string join_table; // Empty unless there is a JOIN
+    Condition join;         // The ON condition
+    std::vector<Condition> where;
+    bool select_all = false;
+    std::vector<SelectItem> items;
+    std::vector<std::string> group_by;
+    std::vector<OrderItem> order_by;
+    size_t limit = NO_LIMIT;
+    size_t offset = 0;
+};
+
+// Access path chosen for a WHERE clause by Database::plan_access_path
+enum class AccessPathType
 {
-    std::string name;
-    std::string type;
-    bool indexed;
+    FULL_SCAN,
+    INDEX_POINT,
+    INDEX_RANGE,
+    EMPTY // Key interval is empty, nothing can match
 };
 
-struct Table
+struct AccessPath
 {
-    std::string name;
-    std::vector<Column> columns;
-    std::vector<std::vector<Value>> rows;
-    BPlusTree index;
+    AccessPathType type = AccessPathType::FULL_SCAN;
+    std::string column; // Indexed column driving the probe
+    int min_key = INT_MIN;
+    int max_key = INT_MAX;
+    // Set when a CREATE INDEX index drives the probe instead of the primary
+    // key; its bounds are index_key_of keys
+    const SecondaryIndex *secondary = nullptr;
+    int64_t secondary_min = INT64_MIN;
+    int64_t secondary_max = INT64_MAX;
+    // Set when the probe runs on a Table::key_index key: keys in
+    // [key_min, key_max), an empty key_max leaving the range open above
+    bool key_bytes = false;
+    std::string key_min;
+    std::string key_max;
+    std::vector<Condition> residual; // Re-checked on every candidate row
+
+    std::string describe() const;
 };
 
-std::ostream &operator<<(std::ostream &os, const Value &val);
+// Rows per scan morsel unless SET MORSEL_SIZE says otherwise
+constexpr size_t DEFAULT_MORSEL_ROWS = 16384;
 
+class Operator;
+class ScanOperator;
+
+// Public methods may be called from several threads at once: statements on
+// one table share its latch when reading and take it alone when writing.
 class Database
 {
 private:
+    // Pages of every PAGED table; declared first so it outlives them
+    std::unique_ptr<BufferPool> buffer_pool = std::make_unique<BufferPool>();
+
     std::unordered_map<std::string, std::unique_ptr<Table>> tables;
 
-    int get_col_index(const std::string &table_name, const std::string &col_name);
+    // Guards `tables` and every table's list of indexes. Statements hold it
+    // shared only while looking a table up; tables are never dropped, so the
+    // Table stays valid after it is released. Lock order: catalog, then
+    // table latches in address order.
+    mutable std::shared_mutex catalog_latch;
+
+    // Workers for morsel-driven scans; SET THREADS swaps in a new pool while
+    // running statements finish on the one they started with
+    std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>();
+    mutable std::mutex pool_mutex;
+    std::atomic<size_t> morsel_rows{DEFAULT_MORSEL_ROWS};
+
+    // Set by open(): changes are logged here and made durable before the
+    // statement returns. Null while in memory only, or while replaying.
+    std::unique_ptr<WriteAheadLog> wal;
+    std::string data_dir;
+
+    // Queue a change record; statements call it while still holding the
+    // latch that ordered the change, so the log replays in the same order
+    uint64_t log_change(const std::string &record);
+
+    // Wait until the record at lsn is durable, after the latch is released
+    // so other statements can join the same group commit
+    void commit_change(uint64_t lsn);
+
+    // Replay one logged change
+    void apply_change(const std::string &record);
+
+    std::shared_ptr<ThreadPool> scan_pool() const;
+
+    // Table by name; throws when there is none
+    Table &table_named(const std::string &name);
+
+    static int get_col_index(const Table &table, const std::string &col_name);
 
     Value parse_value(const std::string &str, const std::string &type);
 
     void determine_range(const Condition &cond, int &min_key, int &max_key);
 
-    bool evaluate_condition(const std::vector<Value> &row,
-                            const Condition &cond, const Table &table);
+    // Probe of Table::key_index for a conjunction: equalities on a leading
+    // run of key columns, then at most one range on the next column
+    AccessPath plan_key_path(const Table &table, const std::vector<Condition> &conditions);
+
+    // Key interval of one comparison against a secondary index column
+    void determine_secondary_range(const Condition &cond, ColumnType type,
+                                   int64_t &min_key, int64_t &max_key);
+
+    // Add or drop the given rows' entries in the table's secondary indexes,
+    // limited to indexes on `columns` when given
+    void maintain_secondary(Table &table, const std::vector<int> &rows, bool add,
+                            const std::vector<bool> *columns = nullptr);
+
+    void rebuild_index(Table &table);
+
+    // Squeeze out tombstones and re-point the index; returns slots reclaimed
+    size_t compact_table(Table &table);
+
+    AccessPath plan_access_path(const Table &table,
+                                const std::vector<Condition> &conditions);
 
     std::vector<int> find_matching_rows(Table &table,
-                                        const std::vector<Condition> &conditions);
+                                        const std::vector<Condition> &conditions,
+                                        AccessPath *chosen = nullptr);
+
+    // Scan of the rows matching conditions along the cheapest access path,
+    // handing out the fetch columns
+    std::unique_ptr<ScanOperator> make_scan(const Table &table, const std::vector<Condition> &conditions,
+                                            std::vector<int> fetch, AccessPath *chosen = nullptr);
+
+    // Operator tree for a SELECT. Latches the tables into latches, which
+    // must outlive the tree, and sets plan_line to the access path or join
+    // strategy shown with the results.
+    std::unique_ptr<Operator> plan_query(const SelectQuery &query,
+                                         std::vector<std::shared_lock<std::shared_mutex>> &latches,
+                                         std::string &plan_line);
 public:
     // Add this static trim function
     static std::string trim(const std::string &s);
@@ -67,7 +209,28 @@ public:
     int public_get_col_index(const std::string &table_name, const std::string &col_name);
     Value public_parse_value(const std::string &str, const std::string &type);
 
-    void create_table(const std::string &name, const std::vector<Column> &columns);
+    // primary_key lists key columns in key order; when empty, the columns
+    // marked indexed form the key in declaration order
+    void create_table(const std::string &name, const std::vector<Column> &columns,
+                      StorageLayout layout = StorageLayout::ROW,
+                      const std::vector<std::string> &primary_key = {});
+
+    // Cursors over SELECT results, for callers that consume rows rather
+    // than print them; the select methods print one. Each keeps its tables
+    // latched for reading until it is exhausted or destroyed.
+    ResultCursor open_query(const SelectQuery &query);
+
+    ResultCursor open_select(const std::string &table_name,
+                             const std::vector<Condition> &conditions,
+                             const std::vector<std::string> &selected_columns,
+                             bool select_all);
+
+    ResultCursor open_join(const std::string &table1_name,
+                           const std::string &table2_name,
+                           const std::vector<Condition> &join_conditions,
+                           const std::vector<Condition> &where_conditions,
+                           const std::vector<std::string> &selected_columns,
+                           bool select_all);
 
     void select_join(const std::string &table1_name,
                      const std::string &table2_name,
@@ -82,11 +245,58 @@ public:
 
     void delete_rows(const std::string &table_name,
                      const std::vector<Condition> &conditions);
+
+    // Explicit compaction: VACUUM table
+    void vacuum(const std::string &table_name);
+
+    // CREATE INDEX name ON table(column) [USING BTREE | HASH]; non-unique,
+    // any column type
+    void create_index(const std::string &index_name, const std::string &table_name,
+                      const std::string &column_name, IndexKind kind = IndexKind::BTREE);
+
+    // Keep the database in directory (created if missing): load its
+    // checkpoint, replay the log written since, and log every later change
+    void open(const std::string &directory);
+
+    // CHECKPOINT: snapshot every table so the log can start over
+    void checkpoint();
+
+    // SET WAL_SYNC_MS n: 0 syncs the log on every commit; otherwise
+    // commits return once written and a background sync runs every n ms
+    void set_wal_sync(unsigned milliseconds);
+
+    // SET BUFFER_POOL_MB n: memory for resident pages of PAGED tables
+    void set_buffer_pool_size(size_t megabytes);
+
+    // Frame usage and hit counts: SHOW BUFFER_POOL
+    void show_buffer_pool();
+
+    // SET THREADS n: threads used by scans, counting the caller
+    void set_threads(size_t threads);
+
+    // SET MORSEL_SIZE n: rows per scan task, rounded up to whole filter
+    // blocks
+    void set_morsel_size(size_t rows);
+
+    // Index shapes: SHOW INDEX table
+    void show_index(const std::string &table_name);
     
 
     void insert_into(const std::string &table_name, const std::vector<Value> &values);
+
+    // Insert a batch of rows; large batches rebuild the index bottom-up
+    void insert_many(const std::string &table_name, const std::vector<std::vector<Value>> &rows);
+
+    // COPY table FROM 'path': load a CSV file as one batch, all rows or none
+    void copy_from(const std::string &table_name, const std::string &path, const CsvOptions &options);
    
 
+    void select(const SelectQuery &query);
+
+    // EXPLAIN SELECT ...: the operator tree. Building it runs the scans and
+    // any join, though no values are fetched.
+    void explain(const SelectQuery &query);
+
     void select(const std::string &table_name,
                 const std::vector<Condition> &conditions,
                 const std::vector<std::string> &selected_columns,
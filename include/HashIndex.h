@@ -0,0 +1,93 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ------------------- Hash Index -------------------
+// Shape of a hash index as reported by HashIndex::stats
+struct HashIndexStats
+{
+    size_t entries = 0;    // (key, row) pairs
+    size_t keys = 0;       // Distinct keys, one slot each
+    size_t capacity = 0;   // Slots in the table
+    double load = 0;       // keys / capacity
+    size_t max_probe = 0;  // Longest distance of a key from its home slot
+    size_t reserved_bytes = 0;
+};
+
+// Open-addressing multimap from int64 keys to row ids. Each distinct key
+// has one 16-byte slot in a flat array probed linearly from the key's
+// hash, so a key is found within a cache line or two however many rows
+// share it. A key with one row keeps it in the slot; more rows go to a
+// posting list, and a per-row position into that list makes removing a
+// row O(1) too. The table stays at most half full, and deletes shift the
+// rest of the probe run back instead of leaving tombstones, so probe runs
+// never grow from churn.
+class HashIndex
+{
+public:
+    void insert(int64_t key, int32_t row);
+
+    // Drop the (key, row) entry if present
+    void remove(int64_t key, int32_t row);
+
+    // Any row stored under key; false when there is none
+    bool find(int64_t key, int &row) const;
+
+    // Every row stored under key, ascending
+    std::vector<int> lookup(int64_t key) const;
+
+    // Drop all entries and size the table for `entries` more
+    void reset(size_t entries);
+
+    size_t size() const { return count; }
+
+    HashIndexStats stats() const;
+
+private:
+    static constexpr int32_t EMPTY = -1;
+    static constexpr int32_t LISTED = -2; // The key's rows are in a posting list
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct Slot
+    {
+        int64_t key;
+        int32_t row = EMPTY; // The key's only row, EMPTY or LISTED
+        int32_t list = -1;   // Posting list of a LISTED key
+    };
+
+    std::vector<Slot> slots; // Power-of-two size, or empty
+    size_t keys = 0;
+    size_t count = 0;
+
+    // Rows of keys with more than one, in no order; freed lists are reused
+    std::vector<std::vector<int32_t>> lists;
+    std::vector<int32_t> free_lists;
+    std::vector<uint32_t> position; // Per row id: its place in its list
+
+    size_t home(int64_t key) const
+    {
+        // splitmix64 finalizer: sequential keys spread over the whole table
+        uint64_t h = static_cast<uint64_t>(key);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h & (slots.size() - 1);
+    }
+
+    // Slot holding key, or the empty slot ending its probe run
+    size_t probe(int64_t key) const;
+
+    void grow(size_t capacity);
+
+    void place(const Slot &slot);
+
+    // Remove the key's slot, shifting the rest of its probe run back
+    void erase_slot(size_t i);
+
+    void add_to_list(int32_t list, int32_t row);
+};
+
+#endif // HASHINDEX_H
@@ -0,0 +1,77 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <utility>
+#include <vector>
+#include "Table.h"
+#include "ThreadPool.h"
+
+// ------------------- Join Algorithms -------------------
+// Joins return matching (left row, right row) pairs; callers project the
+// columns they need from the two tables instead of copying whole rows.
+using JoinPairs = std::vector<std::pair<int, int>>;
+
+// One input of an equi-join: the rows taking part and the join column
+struct JoinInput
+{
+    const Table *table;
+    int column;
+    const std::vector<int> *rows;
+    // STRING keys of `rows`, in order, when they cannot be viewed in place
+    const std::vector<std::string> *strings = nullptr;
+};
+
+// Inputs at least this large (both sides together) are joined by the
+// radix-partitioned parallel hash join when a multi-threaded pool is given
+constexpr size_t PARALLEL_JOIN_MIN_ROWS = size_t(1) << 16;
+
+// Build rows per partition of the parallel join, so that a partition's
+// keys, hashes and chain table stay cache resident
+constexpr size_t JOIN_PARTITION_ROWS = 8192;
+
+// At most 2^12 partitions, partitioned in a single pass
+constexpr int JOIN_MAX_RADIX_BITS = 12;
+
+// Input rows per partitioning task
+constexpr size_t JOIN_MORSEL_ROWS = 16384;
+
+// Build/probe hash join. The smaller input is hashed, the larger one
+// probes. INT/INT and FLOAT/FLOAT compare exactly, INT/FLOAT compare
+// numerically, STRING/STRING byte-wise; any other pairing has no matches.
+// Pairs come in probe order, except from the parallel path, which groups
+// them by hash partition.
+JoinPairs hash_join(const JoinInput &left, const JoinInput &right, ThreadPool *pool = nullptr);
+
+// Whether hash_join takes the parallel path for these inputs
+bool partitioned_join(const JoinInput &left, const JoinInput &right, const ThreadPool *pool);
+
+enum class JoinStrategy
+{
+    HASH,
+    INDEX_NESTED_LOOP, // Probe the inner side's primary-key index per outer row
+    MERGE              // Walk both primary-key leaf chains in key order
+};
+
+const char *join_strategy_name(JoinStrategy strategy);
+
+// True when the join column is the table's INT primary key, so the
+// table's BPlusTree can be probed or walked on it
+bool join_column_indexed(const JoinInput &input);
+
+struct JoinPlan
+{
+    JoinStrategy strategy = JoinStrategy::HASH;
+    bool inner_is_right = true; // INDEX_NESTED_LOOP: which side is probed
+};
+
+// Pick the cheapest strategy from input sizes and available indexes
+JoinPlan choose_join(const JoinInput &left, const JoinInput &right);
+
+JoinPairs index_nested_loop_join(const JoinInput &left, const JoinInput &right, bool inner_is_right);
+
+JoinPairs merge_join(const JoinInput &left, const JoinInput &right);
+
+JoinPairs execute_join(const JoinPlan &plan, const JoinInput &left, const JoinInput &right,
+                       ThreadPool *pool = nullptr);
+
+#endif // JOIN_H
@@ -0,0 +1,144 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ------------------- Node Pool -------------------
+// Allocation counters for one pool
+struct NodePoolStats
+{
+    size_t live = 0;        // Slots currently handed out
+    size_t allocations = 0; // Slots handed out since the pool was created
+    size_t reused = 0;      // Allocations served from the free list
+    size_t slabs = 0;       // Slabs owned by the pool
+    size_t reserved_bytes = 0;
+};
+
+// Fixed-size slots for T carved out of contiguous, T-aligned slabs.
+// Freed slots go on an intrusive free list and are handed out again before
+// the pool touches fresh slab memory. Objects are never destroyed
+// individually, so T must be trivially destructible; that is what lets
+// reset() and the destructor drop everything without visiting each slot.
+template <typename T>
+class NodePool
+{
+    static_assert(std::is_trivially_destructible_v<T>, "NodePool slots are released without running destructors");
+    static_assert(sizeof(T) >= sizeof(void *), "NodePool slots hold the free-list link");
+
+public:
+    // About 64 KiB per slab, and never fewer than 8 slots
+    static constexpr size_t SLOTS_PER_SLAB = sizeof(T) * 8 > 65536 ? 8 : 65536 / sizeof(T);
+
+    NodePool() = default;
+    ~NodePool() { release(); }
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    NodePool(NodePool &&other) noexcept { swap(other); }
+
+    NodePool &operator=(NodePool &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    // Construct a T in a free slot
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        void *slot;
+        if (free_list)
+        {
+            slot = free_list;
+            free_list = free_list->next;
+            stats.reused++;
+        }
+        else
+        {
+            if (slab_used == SLOTS_PER_SLAB || current_slab == slabs.size())
+                next_slab();
+            slot = slabs[current_slab] + slab_used * sizeof(T);
+            slab_used++;
+        }
+        stats.live++;
+        stats.allocations++;
+        return new (slot) T(std::forward<Args>(args)...);
+    }
+
+    // Return a slot for reuse by a later create()
+    void destroy(T *object)
+    {
+        FreeSlot *slot = reinterpret_cast<FreeSlot *>(object);
+        slot->next = free_list;
+        free_list = slot;
+        stats.live--;
+    }
+
+    // Forget every object but keep the slabs for the next fill
+    void reset()
+    {
+        free_list = nullptr;
+        current_slab = 0;
+        slab_used = 0;
+        stats.live = 0;
+    }
+
+    // Forget every object and free the slabs
+    void release()
+    {
+        for (std::byte *slab : slabs)
+            ::operator delete(slab, std::align_val_t(alignof(T)));
+        slabs.clear();
+        reset();
+        stats.slabs = 0;
+        stats.reserved_bytes = 0;
+    }
+
+    const NodePoolStats &get_stats() const { return stats; }
+
+private:
+    struct FreeSlot
+    {
+        FreeSlot *next;
+    };
+
+    std::vector<std::byte *> slabs;
+    size_t current_slab = 0; // Slab being carved; slabs past it are spare
+    size_t slab_used = 0;    // Slots carved from the current slab
+    FreeSlot *free_list = nullptr;
+    NodePoolStats stats;
+
+    void next_slab()
+    {
+        if (current_slab < slabs.size() && slab_used == SLOTS_PER_SLAB)
+            current_slab++;
+        slab_used = 0;
+        if (current_slab < slabs.size())
+            return;
+
+        size_t bytes = SLOTS_PER_SLAB * sizeof(T);
+        slabs.push_back(static_cast<std::byte *>(::operator new(bytes, std::align_val_t(alignof(T)))));
+        stats.slabs++;
+        stats.reserved_bytes += bytes;
+    }
+
+    void swap(NodePool &other) noexcept
+    {
+        std::swap(slabs, other.slabs);
+        std::swap(current_slab, other.current_slab);
+        std::swap(slab_used, other.slab_used);
+        std::swap(free_list, other.free_list);
+        std::swap(stats, other.stats);
+    }
+};
+
+#endif // NODEPOOL_H
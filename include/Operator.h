@@ -0,0 +1,339 @@
+#ifndef OPERATOR_H
+#define OPERATOR_H
+
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Database.h"
+#include "Join.h"
+#include "Predicate.h"
+#include "ResultCursor.h"
+
+// ------------------- Query Operators -------------------
+// Physical plan nodes. A query is a tree of operators; the root is pulled
+// for batches of rows (DEFAULT_BATCH_ROWS by default) and each operator
+// pulls its inputs as it needs them, so values are fetched, filtered and
+// projected a batch at a time and nothing is read past a LIMIT.
+//
+// Scans are the exception on the way in: they find their matching row ids
+// up front, morsel by morsel on the worker pool, and fetch column values
+// only when pulled. Joins take their scans' row ids directly, and UPDATE
+// and DELETE use the row ids alone. Operators read tables the caller has
+// latched for the life of the tree.
+
+class Operator;
+using OperatorPtr = std::unique_ptr<Operator>;
+
+class Operator
+{
+public:
+    virtual ~Operator() = default;
+
+    const std::vector<ResultColumn> &columns() const { return output; }
+
+    // Replace batch with the next rows, at most max_rows; an empty batch
+    // means the operator is done
+    void next(RowBatch &batch, size_t max_rows = DEFAULT_BATCH_ROWS)
+    {
+        batch.size = 0;
+        fill(batch, max_rows);
+    }
+
+    // Rows still to come, or UNKNOWN_ROWS
+    virtual size_t row_count() const { return UNKNOWN_ROWS; }
+
+    // One line about this node, e.g. "Filter (2 conditions)"
+    virtual std::string describe() const = 0;
+
+    // This node and its inputs, one per line, inputs indented below
+    std::string explain(int depth = 0) const;
+
+protected:
+    std::vector<ResultColumn> output;
+    std::vector<Operator *> inputs; // Owned by the derived class
+
+    // Append up to max_rows rows to the empty batch; none once done
+    virtual void fill(RowBatch &batch, size_t max_rows) = 0;
+};
+
+// ------------------- Scans -------------------
+// Rows of one table in storage order, as the `fetch` columns
+class ScanOperator : public Operator
+{
+public:
+    const Table &table() const { return source; }
+
+    const std::vector<int> &row_ids() const { return rows; }
+
+    // Hand the row ids over, for callers that only need those
+    std::vector<int> take_row_ids() { return std::move(rows); }
+
+    size_t row_count() const override { return rows.size() - pos; }
+
+protected:
+    ScanOperator(const Table &table, std::vector<int> fetch);
+
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    const Table &source;
+    std::vector<int> fetch;
+    std::vector<int> rows;
+    size_t pos = 0;
+    bool whole_rows = false; // Fetch every column with one get_row
+};
+
+// Every live row passing the predicate; columnar tables filter whole blocks
+class TableScan : public ScanOperator
+{
+public:
+    TableScan(const Table &table, std::vector<int> fetch, const Predicate &pred,
+              ThreadPool &pool, size_t morsel_rows);
+
+    std::string describe() const override;
+
+private:
+    bool filtered;
+};
+
+// Candidates from the primary key or a secondary index, re-checked against
+// the residual predicate
+class IndexScan : public ScanOperator
+{
+public:
+    IndexScan(const Table &table, std::vector<int> fetch, const AccessPath &path,
+              const Predicate &residual, ThreadPool &pool, size_t morsel_rows);
+
+    std::string describe() const override;
+
+private:
+    std::string path_text;
+};
+
+// Rows in primary-key order, walking the key index's leaf chain from the
+// start of the access path's key range and stopping at its end. Rows are
+// found as they are pulled, so a LIMIT above stops the walk early.
+class OrderedIndexScan : public Operator
+{
+public:
+    OrderedIndexScan(const Table &table, std::vector<int> fetch, const AccessPath &path,
+                     const Predicate &residual);
+
+    size_t row_count() const override;
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    const Table &source;
+    std::vector<int> fetch;
+    Predicate residual;
+    std::string path_text;
+    bool finished = false;
+    size_t emitted = 0;
+    bool whole_table = false; // Every row comes out, so the count is known
+    bool whole_rows = false;  // Fetch every column with one get_row
+
+    // Position and end of the walk on the INT key or on key bytes
+    std::optional<BPlusTree::Cursor> int_cursor;
+    int max_key = INT_MAX;
+    std::optional<BasicBPlusTree<std::string>::Cursor> bytes_cursor;
+    std::string key_max;
+    bool point = false; // key_min is an exact key
+};
+
+// ------------------- Row Operators -------------------
+// A column of the input, or a constant, compared with each row
+struct FilterCondition
+{
+    int column = -1;
+    CompareOp op = CompareOp::EQ;
+    Value value;
+    bool or_before = false; // Joined to the previous condition by OR
+};
+
+// Rows passing the conditions; AND binds tighter than OR, as in WHERE.
+// Constants are converted to their column's type and compared as the
+// scans' predicates compare them.
+class Filter : public Operator
+{
+public:
+    Filter(OperatorPtr input, std::vector<FilterCondition> conditions);
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    OperatorPtr child;
+    std::vector<FilterCondition> conditions;
+    std::vector<CompiledCondition> compiled;
+    std::vector<bool> convertible; // False where no row can match
+    RowBatch in;
+    size_t in_pos = 0;
+
+    bool passes(const std::vector<Value> &row) const;
+};
+
+// The given input columns, in the given order, under the given names
+class Project : public Operator
+{
+public:
+    Project(OperatorPtr input, std::vector<int> columns, std::vector<std::string> names);
+
+    size_t row_count() const override { return child->row_count(); }
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    OperatorPtr child;
+    std::vector<int> picks;
+    RowBatch in;
+};
+
+// ------------------- Joins -------------------
+// A column of the join output: the side it comes from and its ordinal there
+struct JoinColumn
+{
+    bool left = true;
+    int column = 0;
+    std::string name;
+};
+
+// Equi-join of two scans on one column each. choose_join picks a hash,
+// index nested-loop or merge join from the inputs; output values are
+// fetched from the matching row pairs a batch at a time.
+class EquiJoin : public Operator
+{
+public:
+    EquiJoin(std::unique_ptr<ScanOperator> left, std::unique_ptr<ScanOperator> right,
+             int left_column, int right_column, std::vector<JoinColumn> columns, ThreadPool &pool);
+
+    size_t row_count() const override { return pairs.size() - pos; }
+
+    std::string describe() const override;
+
+    // Strategy line printed with the results
+    const std::string &strategy() const { return strategy_text; }
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    std::unique_ptr<ScanOperator> left;
+    std::unique_ptr<ScanOperator> right;
+    std::vector<JoinColumn> picks;
+    std::string strategy_text;
+    JoinPairs pairs;
+    size_t pos = 0;
+};
+
+// ------------------- Sort and Limit -------------------
+struct SortKey
+{
+    int column = 0;
+    bool descending = false;
+};
+
+// Input rows ordered by the keys; ties keep their input order. With `keep`
+// set only the first keep rows are wanted, and a bounded heap of that many
+// replaces sorting everything. A full sort orders row ids by a 64-bit
+// prefix of the first key, reading rows only on equal prefixes; large ones
+// sort runs on the pool and merge them pairwise.
+class Sort : public Operator
+{
+public:
+    Sort(OperatorPtr input, std::vector<SortKey> keys, size_t keep = UNKNOWN_ROWS,
+         std::shared_ptr<ThreadPool> pool = nullptr);
+
+    size_t row_count() const override;
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    OperatorPtr child;
+    std::vector<SortKey> keys;
+    size_t keep;
+    std::shared_ptr<ThreadPool> pool;
+    std::vector<std::vector<Value>> sorted;
+    bool done = false;
+    size_t pos = 0;
+
+    // Whether a sorts before b on the keys
+    bool before(const std::vector<Value> &a, const std::vector<Value> &b) const;
+
+    void top_k();
+
+    void full_sort();
+};
+
+// Rows a sort run covers before the sort goes parallel
+constexpr size_t PARALLEL_SORT_MIN_ROWS = size_t(1) << 15;
+
+// At most `limit` rows after skipping `offset`; stops pulling its input
+// once it has them
+class Limit : public Operator
+{
+public:
+    Limit(OperatorPtr input, size_t limit, size_t offset = 0);
+
+    size_t row_count() const override;
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    OperatorPtr child;
+    size_t limit;
+    size_t offset;
+    size_t skipped = 0;
+    size_t returned = 0;
+    RowBatch in;
+};
+
+// ------------------- Aggregation -------------------
+const char *aggregate_name(AggregateFunction function);
+
+struct AggregateSpec
+{
+    AggregateFunction function = AggregateFunction::COUNT;
+    int column = -1; // -1 for COUNT(*)
+    std::string name;
+};
+
+// One row per distinct value of the group columns, in order of first
+// appearance: the group values, then one value per aggregate. Without group
+// columns there is exactly one row, even for no input; there are no NULLs,
+// so aggregates over no rows are 0 (or '' for MIN and MAX of strings).
+// COUNT and SUM of INT are INT, AVG is FLOAT, the rest keep their column's
+// type.
+class Aggregate : public Operator
+{
+public:
+    Aggregate(OperatorPtr input, std::vector<int> group_columns, std::vector<AggregateSpec> aggregates);
+
+    size_t row_count() const override;
+
+    std::string describe() const override;
+
+private:
+    void fill(RowBatch &batch, size_t max_rows) override;
+
+    OperatorPtr child;
+    std::vector<int> group_columns;
+    std::vector<AggregateSpec> aggregates;
+    std::vector<std::vector<Value>> results;
+    bool done = false;
+    size_t pos = 0;
+
+    void run();
+};
+
+#endif // OPERATOR_H
@@ -0,0 +1,84 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include "Database.h"
+#include "SimdKernels.h"
+
+// ------------------- Compiled WHERE Predicates -------------------
+bool parse_compare_op(const std::string &op, CompareOp &out);
+
+// A single comparison with its column ordinal resolved and the constant
+// already converted to the column's type
+struct CompiledCondition
+{
+    int column = -1;
+    ColumnType type = ColumnType::INT;
+    CompareOp op = CompareOp::EQ;
+    int int_value = 0;
+    float float_value = 0.0f;
+    std::string string_value;
+};
+
+// Fill out with the constant converted to `type`; false when it does not
+// convert, in which case nothing can match
+bool compile_condition(int column, ColumnType type, CompareOp op, const Value &value, CompiledCondition &out);
+
+// A cell against a compiled condition; float equality is within 1e-6
+bool condition_matches(const CompiledCondition &cond, const Value &cell);
+
+struct PredicateNode
+{
+    enum Kind
+    {
+        LEAF,
+        AND,
+        OR,
+        ALWAYS_FALSE // Unknown column, operator or unconvertible constant
+    };
+
+    Kind kind = LEAF;
+    int condition = -1;        // LEAF: index into Predicate::conditions
+    std::vector<int> children; // AND/OR: indices into Predicate::nodes
+};
+
+// WHERE clause compiled once per query into an AND/OR tree. AND binds
+// tighter than OR, so "a OR b AND c" is evaluated as "a OR (b AND c)".
+class Predicate
+{
+public:
+    static Predicate compile(const Table &table, const std::vector<Condition> &conditions);
+
+    // A predicate compiled from no conditions accepts every row
+    bool empty() const { return root == -1; }
+
+    bool matches(const Table &table, size_t row) const
+    {
+        return root == -1 || eval_node(root, table, row);
+    }
+
+    // Rows per filter_block call; one selection bitmap word per 64 rows
+    static constexpr size_t BLOCK_ROWS = 1024;
+
+    // Evaluate rows [start, start + count) into a selection bitmap. start must
+    // be a multiple of 64 and count at most BLOCK_ROWS. Numeric conditions
+    // on columnar tables run as SIMD kernels, everything else row by row.
+    void filter_block(const Table &table, size_t start, size_t count, uint64_t *out) const;
+
+private:
+    std::vector<CompiledCondition> conditions;
+    std::vector<PredicateNode> nodes;
+    int root = -1;
+
+    int add_leaf(const Table &table, const Condition &cond);
+
+    bool eval_node(int node_idx, const Table &table, size_t row) const;
+
+    static bool eval_condition(const CompiledCondition &cond, const Table &table, size_t row);
+
+    void filter_node(int node_idx, const Table &table, size_t start, size_t count, uint64_t *out) const;
+
+    static void filter_condition(const CompiledCondition &cond, const Table &table,
+                                 size_t start, size_t count, uint64_t *out);
+};
+
+#endif // PREDICATE_H
@@ -0,0 +1,86 @@
+#ifndef RESULTCURSOR_H
+#define RESULTCURSOR_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "Table.h"
+
+// ------------------- Result Cursor -------------------
+// Pull-based access to a query's result: callers ask for rows a batch at a
+// time and get typed values, without anything being formatted. The cursor
+// keeps the tables it reads latched for reading until it is exhausted,
+// closed or destroyed, so writers to them wait for it.
+
+// Rows per batch unless the caller asks for another size
+constexpr size_t DEFAULT_BATCH_ROWS = 1024;
+
+// Rows the printer buffers to size its columns
+constexpr size_t PRINT_WINDOW_ROWS = 4096;
+
+// Row count of a result that is only known once it has been read
+constexpr size_t UNKNOWN_ROWS = size_t(-1);
+
+struct ResultColumn
+{
+    std::string name;
+    ColumnType type = ColumnType::INT;
+    bool key = false; // Part of the primary key; printed with a *
+};
+
+// Up to a batch of result rows, one value per column. Row vectors are kept
+// between calls so refilling a batch reuses their storage.
+struct RowBatch
+{
+    std::vector<std::vector<Value>> rows;
+    size_t size = 0; // Rows in use; rows beyond it are spare
+
+    // Clear and hand out the next row, sized for `columns` values
+    std::vector<Value> &add_row(size_t columns);
+};
+
+class ResultCursor
+{
+public:
+    // Fills the batch with at most max_rows rows; an empty batch ends the result
+    using Source = std::function<void(RowBatch &batch, size_t max_rows)>;
+
+    ResultCursor(std::vector<ResultColumn> columns, std::string plan, size_t rows, Source source,
+                 std::vector<std::shared_lock<std::shared_mutex>> latches);
+
+    ResultCursor(ResultCursor &&) = default;
+    ResultCursor &operator=(ResultCursor &&) = default;
+
+    const std::vector<ResultColumn> &columns() const { return result_columns; }
+
+    // How the result is computed, e.g. "Access path: FULL SCAN"
+    const std::string &plan() const { return plan_text; }
+
+    // Rows in the whole result, or UNKNOWN_ROWS
+    size_t row_count() const { return total_rows; }
+
+    // Next batch of at most max_rows rows; false once every row was returned
+    bool next(RowBatch &batch, size_t max_rows = DEFAULT_BATCH_ROWS);
+
+    // Stop early and release the tables
+    void close();
+
+private:
+    std::vector<ResultColumn> result_columns;
+    std::string plan_text;
+    size_t total_rows = 0;
+    Source source;
+    std::vector<std::shared_lock<std::shared_mutex>> latches;
+};
+
+// The REPL's table output: plan, row count, header and aligned rows. Column
+// widths come from the header and the first window of rows; a longer value
+// further down widens its column from there on. Output is written a window
+// at a time; when the row count is unknown and the rows overflow the first
+// window, the count is printed after the rows instead of in the heading.
+void print_result(ResultCursor &cursor, std::ostream &out, size_t window_rows = PRINT_WINDOW_ROWS);
+
+#endif // RESULTCURSOR_H
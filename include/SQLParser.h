@@ -10,13 +10,29 @@ public:
 private:
     void parse_create(std::stringstream &ss, Database &db);
 
+    void parse_create_index(std::stringstream &ss, Database &db, const std::string &index_name);
+
     void parse_insert(std::stringstream &ss, Database &db);
 
-    std::vector<Condition> parse_where_clause(std::stringstream &ss, Database &db, const std::string &table_name);
+    // Values of one parenthesised INSERT tuple, converted to the column types
+    std::vector<Value> parse_tuple(const std::string &tuple, const Table &table, Database &db);
+
+    // Conditions on table_name's columns, or in a join on either table's
+    std::vector<Condition> parse_where_clause(std::stringstream &ss, Database &db, const std::string &table_name,
+                                              const std::string &join_table = "");
 
-    void parse_select(std::stringstream &ss, Database &db);
+    // SELECT, or EXPLAIN SELECT when explain is set
+    void parse_select(std::stringstream &ss, Database &db, bool explain = false);
 
     void parse_update(std::stringstream &ss, Database &db);
 
     void parse_delete(std::stringstream &ss, Database &db);
+
+    void parse_vacuum(std::stringstream &ss, Database &db);
+
+    void parse_copy(std::stringstream &ss, Database &db);
+
+    void parse_show(std::stringstream &ss, Database &db);
+
+    void parse_set(std::stringstream &ss, Database &db);
 };
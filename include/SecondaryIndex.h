@@ -0,0 +1,82 @@
+#ifndef SECONDARYINDEX_H
+#define SECONDARYINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BPlusTree.h"
+#include "HashIndex.h"
+
+// ------------------- Secondary Indexes -------------------
+// One tree entry per row: the column value normalized to an order-preserving
+// int64 (see index_key_of in Table.h), tie-broken by the row's slot so equal
+// values stay distinct keys
+struct IndexEntry
+{
+    int64_t key;
+    int32_t row;
+
+    bool operator<(const IndexEntry &other) const
+    {
+        return key < other.key || (key == other.key && row < other.row);
+    }
+};
+
+// Structure behind a secondary index: USING BTREE (the default) answers
+// equality and ranges, USING HASH answers equality only, in O(1)
+enum class IndexKind
+{
+    BTREE,
+    HASH
+};
+
+// Non-unique index on one column, created with CREATE INDEX
+class SecondaryIndex
+{
+public:
+    SecondaryIndex(std::string index_name, size_t column_index, bool exact_keys,
+                   IndexKind index_kind = IndexKind::BTREE)
+        : name(std::move(index_name)), column(column_index), exact(exact_keys), kind(index_kind) {}
+
+    std::string name;
+    size_t column;
+    // INT keys are the values themselves. FLOAT and STRING keys only keep
+    // order (a STRING key is its first 8 bytes), so rows found through them
+    // must be re-checked against the original condition.
+    bool exact;
+    IndexKind kind;
+
+    void insert(int64_t key, int row);
+
+    void remove(int64_t key, int row);
+
+    // Whether lookup() can answer [min_key, max_key]: hash indexes only
+    // take a single key
+    bool supports(int64_t min_key, int64_t max_key) const
+    {
+        return kind == IndexKind::BTREE || min_key >= max_key;
+    }
+
+    // Any row with this key; false when there is none
+    bool find(int64_t key, int &row) const;
+
+    // Rows whose key lies in [min_key, max_key], in slot order
+    std::vector<int> lookup(int64_t min_key, int64_t max_key) const;
+
+    // Replace the contents; entries may arrive in any order
+    void rebuild(std::vector<IndexEntry> entries);
+
+    size_t size() const { return kind == IndexKind::HASH ? hash.size() : tree.size(); }
+
+    BPlusTreeStats stats() const { return tree.stats(); }
+
+    HashIndexStats hash_stats() const { return hash.stats(); }
+
+private:
+    BasicBPlusTree<IndexEntry> tree; // USING BTREE
+    HashIndex hash;                  // USING HASH
+};
+
+extern template class BasicBPlusTree<IndexEntry, int, std::less<IndexEntry>, BPLUS_DEFAULT_ORDER>;
+
+#endif // SECONDARYINDEX_H
@@ -0,0 +1,50 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------- SIMD Kernels -------------------
+enum class CompareOp
+{
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+};
+
+// Filter kernels write a selection bitmap: bit (i % 64) of word (i / 64) is
+// set when row i passes. Bits past n in the last word are cleared.
+enum class SimdLevel
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Best level supported by this CPU, detected once
+SimdLevel detect_simd_level();
+
+// Level the kernels dispatch to; defaults to detect_simd_level()
+SimdLevel active_simd_level();
+
+// Force a level (clamped to what the CPU supports), e.g. for benchmarking
+void set_simd_level(SimdLevel level);
+
+const char *simd_level_name(SimdLevel level);
+
+void filter_int32(const int32_t *data, size_t n, CompareOp op, int32_t value, uint64_t *out);
+
+// EQ/NE use the same 1e-6 tolerance as the scalar predicate path
+void filter_float(const float *data, size_t n, CompareOp op, float value, uint64_t *out);
+
+// In-node key search over a sorted array: index of the first key >= key
+// (lower) or > key (upper). Counts qualifying keys 8 (AVX2) or 4 (SSE2) at
+// a time and stops at the first block that is not entirely below the key.
+int search_lower_bound_i32(const int32_t *keys, int count, int32_t key);
+
+int search_upper_bound_i32(const int32_t *keys, int count, int32_t key);
+
+#endif // SIMDKERNELS_H
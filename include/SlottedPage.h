@@ -0,0 +1,181 @@
+#ifndef SLOTTEDPAGE_H
+#define SLOTTEDPAGE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BufferPool.h"
+
+// ------------------- Slotted Page -------------------
+// Variable-length records in one buffer pool page. A small header and the
+// slot array grow from the front, record bytes from the back:
+//
+//   [slot count][free end][dead bytes][slot 0][slot 1]...  free  ...[records]
+//
+// A slot holds its record's offset and length; length 0 marks a deleted
+// record, whose slot may be reused. Space freed by deletes and shrinking
+// updates is reclaimed by squeezing the records together when an insert
+// needs it, so a record id (page, slot) never changes while the record
+// lives on the page.
+
+// Where a record lives
+struct RecordId
+{
+    uint32_t page = INVALID_PAGE;
+    uint16_t slot = 0;
+};
+
+class SlottedPage
+{
+public:
+    explicit SlottedPage(char *page_bytes) : page(page_bytes) {}
+
+    // Read-only view: only the const members may be called on it
+    explicit SlottedPage(const char *page_bytes) : page(const_cast<char *>(page_bytes)) {}
+
+    // Largest record a page can hold
+    static constexpr size_t MAX_RECORD = PAGE_SIZE - 3 * sizeof(uint16_t) - 2 * sizeof(uint16_t);
+
+    // Format an empty page
+    void init()
+    {
+        set(SLOT_COUNT, 0);
+        set(FREE_END, static_cast<uint16_t>(PAGE_SIZE));
+        set(DEAD_BYTES, 0);
+    }
+
+    uint16_t slot_count() const { return get(SLOT_COUNT); }
+
+    // Bytes an insert could use, counting dead ones reclaimed by compaction
+    size_t free_space() const
+    {
+        return get(FREE_END) - slots_end() + get(DEAD_BYTES);
+    }
+
+    // Store a record; returns its slot, or -1 when the page is too full
+    int insert(std::string_view record)
+    {
+        if (record.empty() || record.size() > MAX_RECORD)
+            return -1;
+        int slot = -1;
+        for (uint16_t s = 0; s < slot_count(); s++)
+        {
+            if (slot_length(s) == 0)
+            {
+                slot = s;
+                break;
+            }
+        }
+        size_t slot_bytes = slot == -1 ? SLOT_BYTES : 0;
+        if (free_space() < record.size() + slot_bytes)
+            return -1;
+        if (get(FREE_END) - slots_end() < record.size() + slot_bytes)
+            compact();
+        if (slot == -1)
+        {
+            slot = slot_count();
+            set(SLOT_COUNT, slot + 1);
+        }
+        place(slot, record);
+        return slot;
+    }
+
+    std::string_view get_record(uint16_t slot) const
+    {
+        return std::string_view(page + slot_offset(slot), slot_length(slot));
+    }
+
+    void erase(uint16_t slot)
+    {
+        set(DEAD_BYTES, get(DEAD_BYTES) + slot_length(slot));
+        set_slot(slot, 0, 0);
+    }
+
+    // Replace a record in place; false (page unchanged) when the page
+    // cannot hold the new version
+    bool update(uint16_t slot, std::string_view record)
+    {
+        uint16_t old_length = slot_length(slot);
+        if (record.size() <= old_length)
+        {
+            std::memcpy(page + slot_offset(slot), record.data(), record.size());
+            set(DEAD_BYTES, get(DEAD_BYTES) + old_length - record.size());
+            set_slot(slot, slot_offset(slot), record.size());
+            return true;
+        }
+        if (free_space() + old_length < record.size() || record.size() > MAX_RECORD)
+            return false;
+        erase(slot);
+        if (get(FREE_END) - slots_end() < record.size())
+            compact();
+        place(slot, record);
+        return true;
+    }
+
+private:
+    // Header fields, as uint16_t indexes
+    static constexpr size_t SLOT_COUNT = 0;
+    static constexpr size_t FREE_END = 1;
+    static constexpr size_t DEAD_BYTES = 2;
+    static constexpr size_t HEADER_BYTES = 3 * sizeof(uint16_t);
+    static constexpr size_t SLOT_BYTES = 2 * sizeof(uint16_t);
+
+    char *page;
+
+    uint16_t get(size_t field) const
+    {
+        uint16_t value;
+        std::memcpy(&value, page + field * sizeof(uint16_t), sizeof(value));
+        return value;
+    }
+
+    void set(size_t field, size_t value)
+    {
+        uint16_t v = static_cast<uint16_t>(value);
+        std::memcpy(page + field * sizeof(uint16_t), &v, sizeof(v));
+    }
+
+    size_t slots_end() const { return HEADER_BYTES + slot_count() * SLOT_BYTES; }
+
+    uint16_t slot_offset(uint16_t slot) const { return get(HEADER_BYTES / 2 + 2 * slot); }
+
+    uint16_t slot_length(uint16_t slot) const { return get(HEADER_BYTES / 2 + 2 * slot + 1); }
+
+    void set_slot(uint16_t slot, size_t offset, size_t length)
+    {
+        set(HEADER_BYTES / 2 + 2 * slot, offset);
+        set(HEADER_BYTES / 2 + 2 * slot + 1, length);
+    }
+
+    // Copy a record into the contiguous free space, for a slot that is
+    // already counted
+    void place(uint16_t slot, std::string_view record)
+    {
+        size_t offset = get(FREE_END) - record.size();
+        std::memcpy(page + offset, record.data(), record.size());
+        set(FREE_END, offset);
+        set_slot(slot, offset, record.size());
+    }
+
+    // Move every live record to the back of the page, dropping dead bytes
+    void compact()
+    {
+        std::vector<char> copy(page, page + PAGE_SIZE);
+        size_t end = PAGE_SIZE;
+        for (uint16_t s = 0; s < slot_count(); s++)
+        {
+            uint16_t length = slot_length(s);
+            if (length == 0)
+                continue;
+            end -= length;
+            std::memcpy(page + end, copy.data() + slot_offset(s), length);
+            set_slot(s, end, length);
+        }
+        set(FREE_END, end);
+        set(DEAD_BYTES, 0);
+    }
+};
+
+#endif // SLOTTEDPAGE_H
@@ -0,0 +1,201 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <shared_mutex>
+#include "BPlusTree.h"
+#include "SecondaryIndex.h"
+#include "SlottedPage.h"
+
+// ------------------- Table Storage -------------------
+using Value = std::variant<int, float, std::string>;
+
+std::ostream &operator<<(std::ostream &os, const Value &val);
+
+enum class ColumnType
+{
+    INT,
+    FLOAT,
+    STRING
+};
+
+ColumnType column_type_of(const std::string &type);
+
+// Order-preserving int64 key of a value in a column of the given type, as
+// stored by secondary indexes. INT keys are exact; FLOAT keys follow the
+// float's bit pattern; STRING keys keep only the first 8 bytes.
+int64_t index_key_of(const Value &value, ColumnType type);
+
+// Append an order-preserving, prefix-free encoding of a value, so that the
+// concatenated encodings of several columns compare bytewise like the
+// tuple of values. Backs primary keys other than a single INT column.
+void append_key_bytes(std::string &out, const Value &value, ColumnType type);
+
+struct Column
+{
+    std::string name;
+    std::string type;
+    bool indexed;
+};
+
+// Physical layout of a table, fixed at CREATE time
+enum class StorageLayout
+{
+    ROW,      // One std::vector<Value> per row
+    COLUMNAR, // One typed ColumnVector per column
+    PAGED     // Rows as records in slotted pages of the buffer pool
+};
+
+// Contiguous typed storage for one column. Strings share a single byte
+// arena: string i spans lengths[i] bytes from offsets[i]. UPDATE overwrites
+// a string in place when the new one fits and appends it otherwise, so the
+// arena can hold bytes no string uses; erase() and VACUUM pack it again. A
+// cleared validity bit marks a cell whose value did not convert to the
+// column type.
+struct ColumnVector
+{
+    ColumnType type = ColumnType::INT;
+    std::vector<int32_t> ints;
+    std::vector<float> floats;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::string bytes;
+    size_t unused_bytes = 0; // Arena bytes no string refers to
+    bool packed = true;      // Strings lie back to back in row order
+    std::vector<uint64_t> validity;
+    size_t size = 0;
+
+    bool is_valid(size_t row) const
+    {
+        return (validity[row >> 6] >> (row & 63)) & 1;
+    }
+
+    std::string_view get_string(size_t row) const
+    {
+        return std::string_view(bytes.data() + offsets[row], lengths[row]);
+    }
+
+    void append(const Value &val);
+
+    Value get(size_t row) const;
+
+    // Overwrite the given rows (ascending) with one value
+    void assign(const std::vector<int> &rows, const Value &val);
+
+    // Remove the given rows (ascending) in a single compaction pass
+    void erase(const std::vector<int> &rows);
+
+    size_t memory_bytes() const;
+
+private:
+    void set_valid(size_t row, bool valid);
+
+    // Add a string at the end of the arena as row's value
+    void append_string(size_t row, std::string_view text);
+};
+
+// Rows live in slots whose position is a stable row id: the primary-key
+// index maps keys to slots, and deleting rows never moves the others.
+// A deleted slot becomes a tombstone (cleared bit in `live`). ROW tables
+// reuse tombstones for new rows through `free_slots`; compact() squeezes
+// all of them out and renumbers the survivors.
+struct Table
+{
+    std::string name;
+    std::vector<Column> columns;
+    StorageLayout layout = StorageLayout::ROW;
+    std::vector<std::vector<Value>> rows; // ROW layout
+    std::vector<ColumnVector> column_data; // COLUMNAR layout
+    BufferPool *pool = nullptr;            // PAGED layout: where the pages live,
+    std::vector<RecordId> records;         // each slot's record,
+    std::vector<uint32_t> pages;           // every page holding them,
+    uint32_t fill_page = INVALID_PAGE;     // and the one new rows go to
+    std::vector<uint64_t> live;            // Bit per slot, set while the row exists
+    std::vector<int> free_slots;           // ROW layout tombstones ready for reuse
+    size_t live_rows = 0;
+    std::vector<int> key_columns;          // Primary-key columns, in key order
+    BPlusTree index;                       // Primary key that is a single INT column
+    BasicBPlusTree<std::string> key_index; // Any other primary key, on key_of() bytes
+    std::vector<SecondaryIndex> secondary_indexes;
+
+    // Guards everything above except name, columns and layout, which are
+    // fixed at CREATE TABLE. Queries hold it shared; DML, VACUUM and CREATE
+    // INDEX hold it exclusively, so the indexes need no latches of their own.
+    mutable std::shared_mutex latch;
+
+    // Tombstones tolerated before a delete compacts the table on its own:
+    // more than the live rows, and at least this many
+    static constexpr size_t COMPACT_MIN_DEAD = 1024;
+
+    // Set up per-column storage once columns and layout are known
+    void init_storage();
+
+    // True when the primary key lives in `index` rather than `key_index`
+    bool int_key() const;
+
+    // Encoded primary key of a row about to be stored / of a stored slot
+    std::string key_of(const std::vector<Value> &row) const;
+
+    std::string key_of(size_t slot) const;
+
+    // Slots in use, live or dead; row ids range over [0, slot_count())
+    size_t slot_count() const
+    {
+        return layout == StorageLayout::COLUMNAR ? (column_data.empty() ? 0 : column_data[0].size)
+               : layout == StorageLayout::PAGED  ? records.size()
+                                                 : rows.size();
+    }
+
+    size_t row_count() const { return live_rows; }
+
+    size_t dead_slots() const { return slot_count() - live_rows; }
+
+    bool is_live(size_t slot) const { return (live[slot >> 6] >> (slot & 63)) & 1; }
+
+    bool needs_compaction() const
+    {
+        return dead_slots() >= COMPACT_MIN_DEAD && dead_slots() > live_rows;
+    }
+
+    Value get_value(size_t row, size_t col) const
+    {
+        return layout == StorageLayout::COLUMNAR ? column_data[col].get(row)
+               : layout == StorageLayout::PAGED  ? paged_value(row, col)
+                                                 : rows[row][col];
+    }
+
+    std::vector<Value> get_row(size_t row) const;
+
+    // Throws if append_row could not store the row, e.g. a PAGED row too
+    // large for a page, so a batch can be checked before any of it goes in
+    void check_row_fits(const std::vector<Value> &values) const;
+
+    // Returns the slot of the new row
+    size_t append_row(const std::vector<Value> &values);
+
+    void update_rows(const std::vector<int> &row_ids, size_t col, const Value &val);
+
+    // Tombstone the given live slots; O(1) per row
+    void erase_rows(const std::vector<int> &row_ids);
+
+    // Drop every tombstone in one pass, renumbering the remaining rows in
+    // slot order. Returns the number of slots reclaimed; any index over the
+    // old slots must be rebuilt.
+    size_t compact();
+
+private:
+    void set_live(size_t slot, bool on);
+
+    // PAGED layout: read one cell, and store an encoded row on the fill
+    // page (or a fresh one once it is full)
+    Value paged_value(size_t row, size_t col) const;
+
+    RecordId store_record(const std::string &record);
+};
+
+#endif // TABLE_H
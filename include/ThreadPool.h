@@ -0,0 +1,69 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------- Thread Pool -------------------
+// Fixed set of worker threads for morsel-driven loops. run() splits its
+// tasks into one contiguous range per participant; each participant claims
+// tasks from the front of its own range and, once that is drained, steals
+// from the others' ranges, so skewed tasks still spread over every thread.
+// The calling thread takes part as participant 0.
+class ThreadPool
+{
+public:
+    // Threads in total, counting the caller; at least 1
+    explicit ThreadPool(size_t threads = default_threads());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // One per hardware thread
+    static size_t default_threads();
+
+    size_t thread_count() const { return workers.size() + 1; }
+
+    // Call fn(task, participant) for every task in [0, tasks) and return
+    // once all have finished. The first exception thrown by fn is rethrown
+    // here. Callers on other threads may run() at the same time; while the
+    // workers are taken, a caller runs its tasks alone as participant 0.
+    // Not reentrant: fn must not call run() on the same pool.
+    void run(size_t tasks, const std::function<void(size_t, size_t)> &fn);
+
+private:
+    // Tasks [next, end) not yet claimed from one participant's share
+    struct alignas(64) Range
+    {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<Range[]> ranges; // thread_count() entries
+
+    std::mutex owner; // Held by the caller whose job the workers are on
+    std::mutex mutex;
+    std::condition_variable wake; // A new job or shutdown
+    std::condition_variable done; // The last worker finished the job
+    const std::function<void(size_t, size_t)> *job = nullptr;
+    size_t generation = 0; // Jobs started so far
+    size_t busy = 0;       // Workers still inside the current job
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void worker_loop(size_t participant);
+
+    // Claim and run tasks until every range is drained
+    void work(size_t participant);
+};
+
+#endif // THREADPOOL_H
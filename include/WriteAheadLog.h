@@ -0,0 +1,110 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ------------------- Write-Ahead Log -------------------
+// Append-only file of opaque records, each framed as [u32 length][u32
+// CRC-32][payload], after a header naming the log's generation. A
+// checkpoint starts the next generation, which tells recovery whether a
+// log predates the checkpoint it finds.
+
+// What a scan of an existing log found
+struct WalContents
+{
+    uint64_t generation = 0;
+    std::vector<std::string> records;
+    size_t valid_bytes = 0; // Header plus every complete record
+    bool torn = false;      // Bytes past valid_bytes were cut off
+};
+
+class WriteAheadLog
+{
+public:
+    // Read the records of the log at path, stopping at the first torn or
+    // corrupt one; a missing file scans as empty
+    static WalContents scan(const std::string &path);
+
+    // Open the log for appending after its first valid_bytes (cutting off
+    // anything later), or start a fresh one when valid_bytes is 0
+    WriteAheadLog(const std::string &path, uint64_t generation, size_t valid_bytes);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Queue a record; returns the log position commit() waits for
+    uint64_t append(const std::string &record);
+
+    // Group commit: return once position lsn is durable. The first waiter
+    // writes and syncs everything queued so far while later ones queue up
+    // behind it, so one fdatasync covers every commit that arrived
+    // meanwhile. With a sync interval set, commits return as soon as their
+    // records reach the OS and a background thread syncs every interval.
+    void commit(uint64_t lsn);
+
+    // 0 syncs on every commit; otherwise the most milliseconds a committed
+    // record may wait for its fdatasync
+    void set_sync_interval(unsigned milliseconds);
+
+    // Replace the log with an empty one of the given generation, once a
+    // checkpoint holds everything logged so far
+    void restart(uint64_t next_generation);
+
+    uint64_t generation() const;
+
+    // Records appended since the log was opened or restarted
+    uint64_t records() const;
+
+    // fdatasyncs issued so far
+    uint64_t syncs() const;
+
+private:
+    std::string path;
+    int fd = -1;
+    uint64_t current_generation;
+
+    mutable std::mutex mutex;
+    std::condition_variable flushed; // A flush finished
+    std::condition_variable tick;    // Interval changed or shutting down
+    std::string pending;             // Appended, not yet written
+    uint64_t appended = 0;           // Positions count bytes ever appended
+    uint64_t written = 0;
+    uint64_t durable = 0;
+    bool flushing = false;
+    unsigned sync_interval = 0;
+    bool stopping = false;
+    std::string failure; // Set when a write or sync failed
+    uint64_t record_count = 0;
+    uint64_t sync_count = 0;
+    std::thread syncer;
+
+    // Write everything pending, and fdatasync when sync is set. Called
+    // with the lock held; drops it while doing I/O.
+    void flush(std::unique_lock<std::mutex> &lock, bool sync);
+
+    void syncer_loop();
+};
+
+// ------------------- File Helpers -------------------
+// Shared with Checkpoint.cpp; failures throw naming the path
+
+// Write every byte, retrying short writes
+void write_all(int fd, const char *data, size_t length, const std::string &path);
+
+// fdatasync an open file
+void sync_fd(int fd, const std::string &path);
+
+// Durably sync a file or directory
+void sync_path(const std::string &path);
+
+// Directory holding path, for syncing a rename into it
+std::string directory_of(const std::string &path);
+
+#endif // WRITEAHEADLOG_H
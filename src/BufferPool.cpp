@@ -0,0 +1,285 @@
+#include "BufferPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+static std::runtime_error page_error(const char *what, uint32_t page_id)
+{
+    return std::runtime_error(std::string(what) + " page " + std::to_string(page_id) + ": " +
+                              std::strerror(errno));
+}
+
+// ------------------- PageGuard -------------------
+PageGuard::PageGuard(PageGuard &&other) noexcept
+    : pool(other.pool), frame(other.frame), page(other.page), bytes(other.bytes), dirty(other.dirty)
+{
+    other.pool = nullptr;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        pool = other.pool;
+        frame = other.frame;
+        page = other.page;
+        bytes = other.bytes;
+        dirty = other.dirty;
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+PageGuard::~PageGuard()
+{
+    release();
+}
+
+char *PageGuard::mutable_data()
+{
+    dirty = true;
+    return bytes;
+}
+
+void PageGuard::release()
+{
+    if (pool)
+        pool->unpin(frame, dirty);
+    pool = nullptr;
+}
+
+// ------------------- BufferPool -------------------
+BufferPool::BufferPool(size_t capacity_pages) : capacity(std::max(capacity_pages, MIN_POOL_PAGES)) {}
+
+BufferPool::~BufferPool()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+void BufferPool::set_directory(const std::string &dir)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0)
+        throw std::runtime_error("The spill file is already open");
+    directory = dir;
+}
+
+void BufferPool::open_file()
+{
+    std::string dir = directory;
+    if (dir.empty())
+    {
+        const char *tmp = std::getenv("TMPDIR");
+        dir = tmp && *tmp ? tmp : "/tmp";
+    }
+    std::string name = dir + "/nexusprime-pages-XXXXXX";
+    fd = ::mkstemp(name.data());
+    if (fd < 0)
+        throw std::runtime_error("Cannot create a spill file in " + dir + ": " + std::strerror(errno));
+    // Nothing outlives the process, so the name is not needed
+    ::unlink(name.c_str());
+}
+
+// Misses read and write under the pool mutex: simple, and pages of a
+// table that fits in its frames are never read back at all
+size_t BufferPool::claim_frame()
+{
+    if (resident < capacity)
+    {
+        size_t index;
+        if (!empty_frames.empty())
+        {
+            index = empty_frames.back();
+            empty_frames.pop_back();
+        }
+        else
+        {
+            index = frames.size();
+            frames.emplace_back();
+            frame_bytes.emplace_back();
+        }
+        if (!frame_bytes[index])
+            frame_bytes[index].reset(new char[PAGE_SIZE]);
+        resident++;
+        return index;
+    }
+
+    // Two sweeps: the first may only clear reference bits
+    for (size_t step = 0; step < 2 * frames.size(); step++)
+    {
+        size_t index = clock_hand;
+        clock_hand = (clock_hand + 1) % frames.size();
+        Frame &f = frames[index];
+        if (f.page == INVALID_PAGE || f.pins > 0)
+            continue;
+        if (f.referenced)
+        {
+            f.referenced = false;
+            continue;
+        }
+        evict(index);
+        counters.evictions++;
+        resident++;
+        return index;
+    }
+    throw std::runtime_error("Buffer pool exhausted: all " + std::to_string(resident) + " frames are pinned");
+}
+
+void BufferPool::evict(size_t frame_index)
+{
+    Frame &f = frames[frame_index];
+    if (f.dirty)
+    {
+        const char *data = frame_bytes[frame_index].get();
+        off_t offset = off_t(f.page) * PAGE_SIZE;
+        size_t done = 0;
+        while (done < PAGE_SIZE)
+        {
+            ssize_t n = ::pwrite(fd, data + done, PAGE_SIZE - done, offset + done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                throw page_error("Cannot write", f.page);
+            done += n;
+        }
+        counters.writebacks++;
+    }
+    page_table.erase(f.page);
+    f = Frame();
+    resident--;
+}
+
+PageGuard BufferPool::fetch(uint32_t page_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = page_table.find(page_id);
+    if (found != page_table.end())
+    {
+        Frame &f = frames[found->second];
+        f.pins++;
+        f.referenced = true;
+        counters.hits++;
+        return PageGuard(this, found->second, page_id, frame_bytes[found->second].get());
+    }
+
+    if (page_id >= next_page)
+        throw std::runtime_error("No such page: " + std::to_string(page_id));
+    counters.misses++;
+    size_t index = claim_frame();
+    char *data = frame_bytes[index].get();
+    size_t done = 0;
+    while (done < PAGE_SIZE)
+    {
+        ssize_t n = ::pread(fd, data + done, PAGE_SIZE - done, off_t(page_id) * PAGE_SIZE + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            auto error = page_error("Cannot read", page_id);
+            resident--;
+            empty_frames.push_back(index);
+            throw error;
+        }
+        if (n == 0)
+        {
+            // Never written back: the page was still all zeroes
+            std::memset(data + done, 0, PAGE_SIZE - done);
+            break;
+        }
+        done += n;
+    }
+    Frame &f = frames[index];
+    f.page = page_id;
+    f.pins = 1;
+    f.referenced = true;
+    page_table[page_id] = index;
+    return PageGuard(this, index, page_id, data);
+}
+
+PageGuard BufferPool::allocate()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0)
+        open_file();
+    size_t index = claim_frame();
+    uint32_t page_id;
+    if (!free_ids.empty())
+    {
+        page_id = free_ids.back();
+        free_ids.pop_back();
+    }
+    else
+    {
+        page_id = next_page++;
+    }
+    char *data = frame_bytes[index].get();
+    std::memset(data, 0, PAGE_SIZE);
+    Frame &f = frames[index];
+    f.page = page_id;
+    f.pins = 1;
+    f.referenced = true;
+    f.dirty = true;
+    page_table[page_id] = index;
+    return PageGuard(this, index, page_id, data);
+}
+
+void BufferPool::free_page(uint32_t page_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = page_table.find(page_id);
+    if (found != page_table.end())
+    {
+        size_t index = found->second;
+        if (frames[index].pins > 0)
+            throw std::runtime_error("Cannot free pinned page " + std::to_string(page_id));
+        page_table.erase(found);
+        frames[index] = Frame();
+        resident--;
+        empty_frames.push_back(index);
+    }
+    free_ids.push_back(page_id);
+}
+
+void BufferPool::unpin(size_t frame_index, bool dirty)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Frame &f = frames[frame_index];
+    f.pins--;
+    f.dirty = f.dirty || dirty;
+}
+
+void BufferPool::set_capacity(size_t pages)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = std::max(pages, MIN_POOL_PAGES);
+    for (size_t index = 0; index < frames.size() && resident > capacity; index++)
+    {
+        if (frames[index].page == INVALID_PAGE || frames[index].pins > 0)
+            continue;
+        evict(index);
+        counters.evictions++;
+        frame_bytes[index].reset();
+        empty_frames.push_back(index);
+    }
+}
+
+BufferPoolStats BufferPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    BufferPoolStats out = counters;
+    out.capacity = capacity;
+    out.resident = resident;
+    for (const auto &f : frames)
+    {
+        out.pinned += f.pins > 0;
+        out.dirty += f.page != INVALID_PAGE && f.dirty;
+    }
+    out.file_pages = next_page;
+    out.free_pages = free_ids.size();
+    return out;
+}
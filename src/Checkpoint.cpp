@@ -0,0 +1,444 @@
+#include "Checkpoint.h"
+#include "BinaryCodec.h"
+#include "WriteAheadLog.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char CHECKPOINT_MAGIC[8] = {'N', 'X', 'C', 'K', 'P', 'T', '0', '2'};
+static constexpr uint64_t CHECKPOINT_END = 0x444E45544B43584EULL; // "NXCKTEND"
+
+// Buffered writes are flushed once this many bytes pile up; column arrays
+// bypass the buffer
+static constexpr size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+// ------------------- Writing -------------------
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(int file, const std::string &file_path) : fd(file), path(file_path) {}
+
+    BinaryWriter &out()
+    {
+        if (buffer.size() >= WRITE_BUFFER_BYTES)
+            flush();
+        return writer;
+    }
+
+    template <typename T>
+    void put_array(const T *data, uint64_t count)
+    {
+        writer.put<uint64_t>(count);
+        flush();
+        write_all(fd, reinterpret_cast<const char *>(data), count * sizeof(T), path);
+        written += count * sizeof(T);
+    }
+
+    void flush()
+    {
+        write_all(fd, buffer.data(), buffer.size(), path);
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    size_t size() const { return written + buffer.size(); }
+
+private:
+    int fd;
+    std::string path;
+    std::string buffer;
+    BinaryWriter writer{buffer};
+    size_t written = 0;
+};
+
+// Live rows of a column, renumbered densely
+static ColumnVector gather_live(const ColumnVector &cv, const std::vector<int> &slots)
+{
+    ColumnVector out;
+    out.type = cv.type;
+    out.size = slots.size();
+    out.validity.assign((slots.size() + 63) / 64, 0);
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        size_t row = slots[i];
+        if (cv.is_valid(row))
+            out.validity[i >> 6] |= uint64_t(1) << (i & 63);
+        if (cv.type == ColumnType::INT)
+            out.ints.push_back(cv.ints[row]);
+        else if (cv.type == ColumnType::FLOAT)
+            out.floats.push_back(cv.floats[row]);
+        else
+        {
+            std::string_view text = cv.get_string(row);
+            out.offsets.push_back(out.bytes.size());
+            out.lengths.push_back(text.size());
+            out.bytes += text;
+        }
+    }
+    return out;
+}
+
+static void write_column(SnapshotWriter &file, const ColumnVector &cv)
+{
+    file.out().put<uint8_t>(static_cast<uint8_t>(cv.type));
+    if (cv.type == ColumnType::INT)
+        file.put_array(cv.ints.data(), cv.size);
+    else if (cv.type == ColumnType::FLOAT)
+        file.put_array(cv.floats.data(), cv.size);
+    else
+    {
+        // Packed, so the lengths place every string
+        file.put_array(cv.lengths.data(), cv.size);
+        file.put_array(cv.bytes.data(), cv.bytes.size());
+    }
+    file.put_array(cv.validity.data(), (cv.size + 63) / 64);
+}
+
+static void write_table(SnapshotWriter &file, const Table &table)
+{
+    BinaryWriter &out = file.out();
+    out.put_string(table.name);
+    out.put<uint8_t>(static_cast<uint8_t>(table.layout));
+    out.put<uint32_t>(table.columns.size());
+    for (const auto &col : table.columns)
+    {
+        out.put_string(col.name);
+        out.put_string(col.type);
+        out.put<uint8_t>(col.indexed);
+    }
+    out.put<uint32_t>(table.key_columns.size());
+    for (int col : table.key_columns)
+        out.put<int32_t>(col);
+    out.put<uint32_t>(table.secondary_indexes.size());
+    for (const auto &index : table.secondary_indexes)
+    {
+        out.put_string(index.name);
+        out.put<uint32_t>(index.column);
+        out.put<uint8_t>(static_cast<uint8_t>(index.kind));
+    }
+
+    // Tombstones are dropped, so stored rows are renumbered in slot order
+    std::vector<int> slots;
+    std::vector<int> new_row(table.slot_count(), -1);
+    slots.reserve(table.row_count());
+    for (size_t slot = 0; slot < table.slot_count(); slot++)
+    {
+        if (!table.is_live(slot))
+            continue;
+        new_row[slot] = slots.size();
+        slots.push_back(slot);
+    }
+    out.put<uint64_t>(slots.size());
+
+    if (table.layout == StorageLayout::COLUMNAR)
+    {
+        for (const auto &cv : table.column_data)
+        {
+            if (table.dead_slots() == 0 && cv.packed)
+                write_column(file, cv);
+            else
+                write_column(file, gather_live(cv, slots));
+        }
+    }
+    else
+    {
+        for (int slot : slots)
+        {
+            BinaryWriter &row_out = file.out();
+            if (table.layout == StorageLayout::PAGED)
+            {
+                for (const auto &val : table.get_row(slot))
+                    row_out.put_value(val);
+                continue;
+            }
+            for (const auto &val : table.rows[slot])
+                row_out.put_value(val);
+        }
+    }
+
+    // Primary-key entries in key order, so loading needs no sort
+    if (table.key_columns.empty())
+        return;
+    if (table.int_key())
+    {
+        std::vector<int32_t> keys, rows;
+        keys.reserve(table.index.size());
+        rows.reserve(table.index.size());
+        for (auto it = table.index.begin(); it.valid(); it.next())
+        {
+            keys.push_back(it.key());
+            rows.push_back(new_row[it.value()]);
+        }
+        file.put_array(keys.data(), keys.size());
+        file.put_array(rows.data(), rows.size());
+        return;
+    }
+    file.out().put<uint64_t>(table.key_index.size());
+    for (auto it = table.key_index.begin(); it.valid(); it.next())
+    {
+        BinaryWriter &entry_out = file.out();
+        entry_out.put_string(it.key());
+        entry_out.put<int32_t>(new_row[it.value()]);
+    }
+}
+
+size_t write_checkpoint(const std::string &path, const std::vector<const Table *> &tables,
+                        uint64_t wal_generation)
+{
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot create " + temp + ": " + std::strerror(errno));
+
+    size_t bytes = 0;
+    try
+    {
+        SnapshotWriter file(fd, temp);
+        BinaryWriter &out = file.out();
+        out.put_bytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        out.put<uint64_t>(wal_generation);
+        out.put<uint32_t>(tables.size());
+        for (const Table *table : tables)
+            write_table(file, *table);
+        file.out().put<uint64_t>(CHECKPOINT_END);
+        file.flush();
+        bytes = file.size();
+        sync_fd(fd, temp);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        ::unlink(temp.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(temp.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Cannot replace " + path + ": " + std::strerror(errno));
+    sync_path(directory_of(path));
+    return bytes;
+}
+
+// ------------------- Loading -------------------
+MappedFile::MappedFile(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+    }
+    length = info.st_size;
+    if (length > 0)
+    {
+        base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            base = nullptr;
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        // Loading reads the file front to back exactly once
+        ::madvise(base, length, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (base)
+        ::munmap(base, length);
+}
+
+template <typename T>
+static void read_array(BinaryReader &in, std::vector<T> &out)
+{
+    uint64_t count = in.get<uint64_t>();
+    if (count > SIZE_MAX / sizeof(T))
+        throw std::runtime_error("Truncated data");
+    const char *data = in.take(count * sizeof(T));
+    out.resize(count);
+    std::memcpy(out.data(), data, count * sizeof(T));
+}
+
+static void read_column(BinaryReader &in, ColumnVector &cv, size_t rows)
+{
+    if (in.get<uint8_t>() != static_cast<uint8_t>(cv.type))
+        throw std::runtime_error("Column type mismatch");
+    if (cv.type == ColumnType::INT)
+        read_array(in, cv.ints);
+    else if (cv.type == ColumnType::FLOAT)
+        read_array(in, cv.floats);
+    else
+    {
+        read_array(in, cv.lengths);
+        uint64_t count = in.get<uint64_t>();
+        cv.bytes.assign(in.take(count), count);
+        uint64_t offset = 0;
+        for (uint32_t length : cv.lengths)
+        {
+            cv.offsets.push_back(offset);
+            offset += length;
+        }
+        if (offset != cv.bytes.size())
+            throw std::runtime_error("Corrupt column data");
+    }
+    read_array(in, cv.validity);
+    cv.size = rows;
+
+    size_t values = cv.type == ColumnType::INT ? cv.ints.size()
+                    : cv.type == ColumnType::FLOAT ? cv.floats.size()
+                    : cv.lengths.size();
+    if (values != rows || cv.validity.size() != (rows + 63) / 64)
+        throw std::runtime_error("Corrupt column data");
+}
+
+static std::unique_ptr<Table> read_table(BinaryReader &in, BufferPool &pool)
+{
+    auto table = std::make_unique<Table>();
+    table->pool = &pool;
+    table->name = in.get_string();
+    table->layout = static_cast<StorageLayout>(in.get<uint8_t>());
+    uint32_t column_count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < column_count; i++)
+    {
+        Column col;
+        col.name = in.get_string();
+        col.type = in.get_string();
+        col.indexed = in.get<uint8_t>();
+        table->columns.push_back(std::move(col));
+    }
+    uint32_t key_count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < key_count; i++)
+        table->key_columns.push_back(in.get<int32_t>());
+
+    struct IndexSpec
+    {
+        std::string name;
+        uint32_t column;
+        IndexKind kind;
+    };
+    std::vector<IndexSpec> specs(in.get<uint32_t>());
+    for (auto &spec : specs)
+    {
+        spec.name = in.get_string();
+        spec.column = in.get<uint32_t>();
+        spec.kind = static_cast<IndexKind>(in.get<uint8_t>());
+        if (spec.column >= column_count)
+            throw std::runtime_error("Corrupt index definition");
+    }
+    for (int col : table->key_columns)
+    {
+        if (col < 0 || col >= int(column_count))
+            throw std::runtime_error("Corrupt primary key definition");
+    }
+
+    table->init_storage();
+    uint64_t rows = in.get<uint64_t>();
+    if (table->layout == StorageLayout::COLUMNAR)
+    {
+        for (auto &cv : table->column_data)
+            read_column(in, cv, rows);
+    }
+    else if (table->layout == StorageLayout::PAGED)
+    {
+        for (uint64_t r = 0; r < rows; r++)
+        {
+            std::vector<Value> row;
+            row.reserve(column_count);
+            for (uint32_t c = 0; c < column_count; c++)
+                row.push_back(in.get_value());
+            table->append_row(row);
+        }
+    }
+    else
+    {
+        table->rows.resize(rows);
+        for (auto &row : table->rows)
+        {
+            row.reserve(column_count);
+            for (uint32_t c = 0; c < column_count; c++)
+                row.push_back(in.get_value());
+        }
+    }
+    if (table->layout != StorageLayout::PAGED)
+    {
+        table->live_rows = rows;
+        table->live.assign((rows + 63) / 64, 0);
+        for (size_t slot = 0; slot < rows; slot++)
+            table->live[slot >> 6] |= uint64_t(1) << (slot & 63);
+    }
+
+    if (!table->key_columns.empty() && table->int_key())
+    {
+        std::vector<int32_t> keys, slots;
+        read_array(in, keys);
+        read_array(in, slots);
+        if (keys.size() != slots.size())
+            throw std::runtime_error("Corrupt primary key data");
+        std::vector<std::pair<int, int>> entries;
+        entries.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+            entries.push_back({keys[i], slots[i]});
+        table->index.bulk_load(entries);
+    }
+    else if (!table->key_columns.empty())
+    {
+        std::vector<std::pair<std::string, int>> entries(in.get<uint64_t>());
+        for (auto &entry : entries)
+        {
+            entry.first = in.get_string();
+            entry.second = in.get<int32_t>();
+        }
+        table->key_index.bulk_load(entries);
+    }
+
+    // Secondary indexes are rebuilt from the columns they cover
+    for (const auto &spec : specs)
+    {
+        ColumnType type = column_type_of(table->columns[spec.column].type);
+        SecondaryIndex index(spec.name, spec.column, type == ColumnType::INT, spec.kind);
+        std::vector<IndexEntry> entries;
+        entries.reserve(rows);
+        for (size_t i = 0; i < rows; i++)
+            entries.push_back({index_key_of(table->get_value(i, spec.column), type), static_cast<int32_t>(i)});
+        index.rebuild(std::move(entries));
+        table->secondary_indexes.push_back(std::move(index));
+    }
+    return table;
+}
+
+CheckpointContents load_checkpoint(const std::string &path, BufferPool &pool)
+{
+    CheckpointContents contents;
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 && errno == ENOENT)
+        return contents;
+
+    MappedFile file(path);
+    contents.bytes = file.size();
+    try
+    {
+        BinaryReader in(file.data(), file.size());
+        if (std::memcmp(in.take(sizeof(CHECKPOINT_MAGIC)), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+            throw std::runtime_error("bad magic");
+        contents.wal_generation = in.get<uint64_t>();
+        uint32_t table_count = in.get<uint32_t>();
+        for (uint32_t i = 0; i < table_count; i++)
+            contents.tables.push_back(read_table(in, pool));
+        if (in.get<uint64_t>() != CHECKPOINT_END || !in.done())
+            throw std::runtime_error("missing end marker");
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error("Corrupt checkpoint " + path + ": " + e.what());
+    }
+    return contents;
+}
@@ -0,0 +1,186 @@
+#include "CsvReader.h"
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+std::vector<std::pair<size_t, size_t>> split_csv(const char *data, size_t size, size_t target_bytes)
+{
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+    while (begin < size)
+    {
+        size_t end = size;
+        if (size - begin > target_bytes)
+        {
+            const void *newline = std::memchr(data + begin + target_bytes, '\n', size - begin - target_bytes);
+            end = newline ? static_cast<const char *>(newline) - data + 1 : size;
+        }
+        ranges.push_back({begin, end});
+        begin = end;
+    }
+    return ranges;
+}
+
+static std::string_view trim_spaces(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        text.remove_suffix(1);
+    return text;
+}
+
+// Whole-field number conversion; false on anything but a number in range
+static bool parse_int(std::string_view text, int &out)
+{
+    text = trim_spaces(text);
+    if (!text.empty() && text.front() == '+')
+        text.remove_prefix(1);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+static bool parse_float(std::string_view text, float &out)
+{
+    text = trim_spaces(text);
+    if (!text.empty() && text.front() == '+')
+        text.remove_prefix(1);
+    if (text.empty())
+        return false;
+#if defined(__cpp_lib_to_chars)
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size();
+#else
+    // No floating-point from_chars: strtof wants a terminated copy
+    char buffer[64];
+    if (text.size() >= sizeof(buffer))
+        return false;
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    char *end;
+    errno = 0;
+    out = std::strtof(buffer, &end);
+    return errno == 0 && end == buffer + text.size();
+#endif
+}
+
+CsvBatch parse_csv(const char *begin, const char *end, const std::vector<ColumnType> &types, char delimiter)
+{
+    CsvBatch batch;
+    std::string unquoted;
+    std::vector<Value> row;
+    row.reserve(types.size());
+
+    const char *line = begin;
+    while (line < end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        const char *line_end = newline ? newline : end;
+        const char *next_line = newline ? newline + 1 : end;
+        batch.lines++;
+        if (line_end > line && line_end[-1] == '\r')
+            line_end--;
+        if (line_end == line)
+        {
+            line = next_line;
+            continue;
+        }
+
+        auto fail = [&](const std::string &why)
+        {
+            batch.error_line = batch.lines;
+            batch.error = why;
+        };
+
+        row.clear();
+        const char *pos = line;
+        for (size_t col = 0; col < types.size(); col++)
+        {
+            if (col > 0)
+            {
+                if (pos >= line_end || *pos != delimiter)
+                {
+                    fail("expected " + std::to_string(types.size()) + " fields, found " + std::to_string(col));
+                    return batch;
+                }
+                pos++;
+            }
+
+            std::string_view field;
+            if (pos < line_end && *pos == '"')
+            {
+                // Quoted: runs to the quote not doubled, "" is a quote
+                unquoted.clear();
+                pos++;
+                bool closed = false;
+                while (pos < line_end)
+                {
+                    const char *quote = static_cast<const char *>(std::memchr(pos, '"', line_end - pos));
+                    if (!quote)
+                        break;
+                    unquoted.append(pos, quote);
+                    if (quote + 1 < line_end && quote[1] == '"')
+                    {
+                        unquoted += '"';
+                        pos = quote + 2;
+                        continue;
+                    }
+                    pos = quote + 1;
+                    closed = true;
+                    break;
+                }
+                if (!closed)
+                {
+                    fail("unterminated quoted field");
+                    return batch;
+                }
+                field = unquoted;
+            }
+            else
+            {
+                const char *stop = static_cast<const char *>(std::memchr(pos, delimiter, line_end - pos));
+                if (!stop)
+                    stop = line_end;
+                field = std::string_view(pos, stop - pos);
+                pos = stop;
+            }
+
+            switch (types[col])
+            {
+            case ColumnType::INT:
+            {
+                int num;
+                if (!parse_int(field, num))
+                {
+                    fail("invalid INT '" + std::string(field) + "' in column " + std::to_string(col + 1));
+                    return batch;
+                }
+                row.emplace_back(num);
+                break;
+            }
+            case ColumnType::FLOAT:
+            {
+                float num;
+                if (!parse_float(field, num))
+                {
+                    fail("invalid FLOAT '" + std::string(field) + "' in column " + std::to_string(col + 1));
+                    return batch;
+                }
+                row.emplace_back(num);
+                break;
+            }
+            default:
+                row.emplace_back(std::string(field));
+            }
+        }
+        if (pos != line_end)
+        {
+            fail("more than " + std::to_string(types.size()) + " fields");
+            return batch;
+        }
+        batch.rows.push_back(row);
+        line = next_line;
+    }
+    return batch;
+}
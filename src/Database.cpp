@@ -1,8 +1,148 @@
 #include "Database.h"
+#include "Predicate.h"
+#include "Join.h"
+#include "BinaryCodec.h"
+#include "Checkpoint.h"
+#include "Operator.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <sys/stat.h>
 
-int Database::get_col_index(const std::string &table_name, const std::string &col_name)
+// Files open() keeps in the data directory
+static const char *const CHECKPOINT_FILE = "checkpoint.nxc";
+static const char *const WAL_FILE = "wal.log";
+
+// Results reach cout a window at a time; one printer at a time keeps
+// concurrent statements from interleaving their rows
+static std::mutex output_mutex;
+
+// ------------------- Change Records -------------------
+// A logged change is the statement that made it: an op, the table name and
+// the statement's arguments. Replaying them in log order against the
+// checkpoint rebuilds the same contents, whatever slots rows land in.
+enum class WalOp : uint8_t
+{
+    CREATE_TABLE,
+    CREATE_INDEX,
+    INSERT,
+    UPDATE,
+    DELETE,
+    VACUUM
+};
+
+static std::string change_record(WalOp op, const std::string &table_name)
+{
+    std::string record;
+    BinaryWriter out(record);
+    out.put(op);
+    out.put_string(table_name);
+    return record;
+}
+
+static void put_conditions(BinaryWriter &out, const std::vector<Condition> &conditions)
+{
+    out.put<uint32_t>(conditions.size());
+    for (const auto &cond : conditions)
+    {
+        out.put_string(cond.column);
+        out.put_string(cond.op);
+        out.put_value(cond.value);
+        out.put_string(cond.logical_op);
+    }
+}
+
+static std::vector<Condition> get_conditions(BinaryReader &in)
+{
+    std::vector<Condition> conditions(in.get<uint32_t>());
+    for (auto &cond : conditions)
+    {
+        cond.column = in.get_string();
+        cond.op = in.get_string();
+        cond.value = in.get_value();
+        cond.logical_op = in.get_string();
+    }
+    return conditions;
+}
+
+static std::string create_table_record(const std::string &name, const std::vector<Column> &columns,
+                                       StorageLayout layout, const std::vector<std::string> &primary_key)
+{
+    std::string record = change_record(WalOp::CREATE_TABLE, name);
+    BinaryWriter out(record);
+    out.put<uint8_t>(static_cast<uint8_t>(layout));
+    out.put<uint32_t>(columns.size());
+    for (const auto &col : columns)
+    {
+        out.put_string(col.name);
+        out.put_string(col.type);
+        out.put<uint8_t>(col.indexed);
+    }
+    out.put<uint32_t>(primary_key.size());
+    for (const auto &key : primary_key)
+        out.put_string(key);
+    return record;
+}
+
+static std::string create_index_record(const std::string &index_name, const std::string &table_name,
+                                       const std::string &column_name, IndexKind kind)
+{
+    std::string record = change_record(WalOp::CREATE_INDEX, table_name);
+    BinaryWriter out(record);
+    out.put_string(index_name);
+    out.put_string(column_name);
+    out.put<uint8_t>(static_cast<uint8_t>(kind));
+    return record;
+}
+
+static std::string insert_record(const std::string &table_name, const std::vector<std::vector<Value>> &rows)
 {
-    auto &cols = tables[table_name]->columns;
+    std::string record = change_record(WalOp::INSERT, table_name);
+    BinaryWriter out(record);
+    out.put<uint64_t>(rows.size());
+    for (const auto &row : rows)
+    {
+        out.put<uint32_t>(row.size());
+        for (const auto &val : row)
+            out.put_value(val);
+    }
+    return record;
+}
+
+// Rows per logged INSERT record
+static constexpr size_t INSERT_RECORD_ROWS = 1 << 16;
+
+// Bytes of CSV each COPY parse task takes
+static constexpr size_t COPY_CHUNK_BYTES = 4 << 20;
+
+static std::string update_record(const std::string &table_name,
+                                 const std::vector<std::pair<std::string, Value>> &updates,
+                                 const std::vector<Condition> &conditions)
+{
+    std::string record = change_record(WalOp::UPDATE, table_name);
+    BinaryWriter out(record);
+    out.put<uint32_t>(updates.size());
+    for (const auto &update : updates)
+    {
+        out.put_string(update.first);
+        out.put_value(update.second);
+    }
+    put_conditions(out, conditions);
+    return record;
+}
+
+static std::string delete_record(const std::string &table_name, const std::vector<Condition> &conditions)
+{
+    std::string record = change_record(WalOp::DELETE, table_name);
+    BinaryWriter out(record);
+    put_conditions(out, conditions);
+    return record;
+}
+
+int Database::get_col_index(const Table &table, const std::string &col_name)
+{
+    const auto &cols = table.columns;
     for (size_t i = 0; i < cols.size(); i++)
         if (cols[i].name == col_name)
             return i;
@@ -57,6 +197,8 @@ void Database::determine_range(const Condition &cond, int &min_key, int &max_key
         }
     }
 
+    // Open bounds are widened by one; guard the INT_MAX/INT_MIN edges so an
+    // unsatisfiable bound yields an empty interval instead of overflowing
     if (cond.op == "=")
     {
         min_key = value;
@@ -64,8 +206,8 @@ void Database::determine_range(const Condition &cond, int &min_key, int &max_key
     }
     else if (cond.op == ">")
     {
-        min_key = value + 1;
-        max_key = INT_MAX;
+        min_key = value == INT_MAX ? INT_MAX : value + 1;
+        max_key = value == INT_MAX ? INT_MIN : INT_MAX;
     }
     else if (cond.op == ">=")
     {
@@ -74,8 +216,8 @@ void Database::determine_range(const Condition &cond, int &min_key, int &max_key
     }
     else if (cond.op == "<")
     {
-        min_key = INT_MIN;
-        max_key = value - 1;
+        min_key = value == INT_MIN ? INT_MAX : INT_MIN;
+        max_key = value == INT_MIN ? INT_MIN : value - 1;
     }
     else if (cond.op == "<=")
     {
@@ -84,156 +226,450 @@ void Database::determine_range(const Condition &cond, int &min_key, int &max_key
     }
 }
 
-bool Database::evaluate_condition(const std::vector<Value> &row,
-                        const Condition &cond, const Table &table)
+void Database::determine_secondary_range(const Condition &cond, ColumnType type,
+                                         int64_t &min_key, int64_t &max_key)
 {
-    int col_idx = get_col_index(table.name, cond.column);
-    if (col_idx == -1)
+    if (type == ColumnType::INT)
+    {
+        int lo = INT_MIN;
+        int hi = INT_MAX;
+        determine_range(cond, lo, hi);
+        min_key = lo;
+        max_key = hi;
+        return;
+    }
+
+    // FLOAT and STRING keys only preserve order, so bounds are inclusive and
+    // the condition itself is re-checked on every row found
+    int64_t key = index_key_of(cond.value, type);
+    if (cond.op == "=" && type == ColumnType::FLOAT)
+    {
+        // Float equality tolerates 1e-6, so widen the probe to match
+        float value = std::holds_alternative<float>(cond.value) ? std::get<float>(cond.value)
+                      : std::holds_alternative<int>(cond.value) ? std::get<int>(cond.value)
+                                                                : 0.0f;
+        if (std::holds_alternative<std::string>(cond.value))
+            return; // Unparseable constant: leave the interval unbounded
+        min_key = index_key_of(std::nextafter(static_cast<float>(value - 1e-6), -INFINITY), type);
+        max_key = index_key_of(std::nextafter(static_cast<float>(value + 1e-6), INFINITY), type);
+    }
+    else if (cond.op == "=")
+    {
+        min_key = key;
+        max_key = key;
+    }
+    else if (cond.op == ">" || cond.op == ">=")
+    {
+        min_key = key;
+    }
+    else if (cond.op == "<" || cond.op == "<=")
+    {
+        max_key = key;
+    }
+}
+
+// Smallest byte string above every string that starts with prefix; false
+// when there is none (the prefix is all 0xFF bytes)
+static bool prefix_successor(std::string &prefix)
+{
+    while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF)
+        prefix.pop_back();
+    if (prefix.empty())
         return false;
+    prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+    return true;
+}
 
-    const Column &col = table.columns[col_idx];
-    const Value &row_val = row[col_idx];
-    const Value &cond_val = cond.value;
+AccessPath Database::plan_key_path(const Table &table, const std::vector<Condition> &conditions)
+{
+    AccessPath path;
+    path.residual = conditions; // The byte range only narrows the scan
 
-    try
+    auto range_op = [](const Condition &cond)
     {
-        if (col.type == "INT")
+        return cond.op == "=" || cond.op == "<" || cond.op == "<=" || cond.op == ">" || cond.op == ">=";
+    };
+
+    // Key bytes shared by every match, from the leading equalities
+    std::string prefix;
+    std::string columns;
+    size_t fixed_columns = 0;
+    bool ranged = false;
+    bool empty = false;
+    std::string lo;
+    std::string hi;
+    bool bounded = false; // hi is set; otherwise the range is open above
+
+    for (int col_idx : table.key_columns)
+    {
+        const Column &col = table.columns[col_idx];
+        ColumnType type = column_type_of(col.type);
+        auto bytes_of = [&](const Value &value)
+        {
+            std::string bytes = prefix;
+            append_key_bytes(bytes, value, type);
+            return bytes;
+        };
+
+        // This column's interval, within the keys that start with prefix
+        lo = prefix;
+        hi = prefix;
+        bounded = prefix_successor(hi);
+        auto raise_lo = [&](const std::string &bytes)
+        {
+            lo = std::max(lo, bytes);
+        };
+        auto lower_hi = [&](const std::string &bytes)
         {
-            int row_num = std::get<int>(row_val);
-            int cond_num = 0;
+            if (!bounded || bytes < hi)
+                hi = bytes;
+            bounded = true;
+        };
 
-            if (std::holds_alternative<int>(cond_val))
+        bool fixed = false;
+        std::string fixed_bytes;
+        for (const auto &cond : conditions)
+        {
+            if (cond.column != col.name || !range_op(cond))
+                continue;
+            if (cond.op == "=" && type != ColumnType::FLOAT)
             {
-                cond_num = std::get<int>(cond_val);
+                std::string bytes = bytes_of(cond.value);
+                empty = empty || (fixed && bytes != fixed_bytes);
+                fixed = true;
+                fixed_bytes = bytes;
+                continue;
             }
-            else if (std::holds_alternative<float>(cond_val))
+
+            std::string bytes;
+            ranged = true;
+            if (cond.op == "=")
             {
-                cond_num = static_cast<int>(std::get<float>(cond_val));
+                // Float equality tolerates 1e-6, so scan the whole window
+                float value = std::holds_alternative<float>(cond.value) ? std::get<float>(cond.value)
+                              : std::holds_alternative<int>(cond.value) ? std::get<int>(cond.value)
+                                                                        : 0.0f;
+                raise_lo(bytes_of(std::nextafter(static_cast<float>(value - 1e-6), -INFINITY)));
+                bytes = bytes_of(std::nextafter(static_cast<float>(value + 1e-6), INFINITY));
+                if (prefix_successor(bytes))
+                    lower_hi(bytes);
             }
-            else
+            else if (cond.op == ">=")
             {
-                cond_num = std::stoi(std::get<std::string>(cond_val));
+                raise_lo(bytes_of(cond.value));
             }
-
-            if (cond.op == "=")
-                return row_num == cond_num;
-            if (cond.op == "!=")
-                return row_num != cond_num;
-            if (cond.op == ">")
-                return row_num > cond_num;
-            if (cond.op == "<")
-                return row_num < cond_num;
-            if (cond.op == ">=")
-                return row_num >= cond_num;
-            if (cond.op == "<=")
-                return row_num <= cond_num;
-        }
-        else if (col.type == "FLOAT")
-        {
-            float row_num = std::holds_alternative<int>(row_val)
-                                ? static_cast<float>(std::get<int>(row_val))
-                                : std::get<float>(row_val);
-            float cond_num = 0;
-
-            if (std::holds_alternative<int>(cond_val))
+            else if (cond.op == ">")
             {
-                cond_num = static_cast<float>(std::get<int>(cond_val));
+                bytes = bytes_of(cond.value);
+                if (prefix_successor(bytes))
+                    raise_lo(bytes);
+                else
+                    empty = true;
             }
-            else if (std::holds_alternative<float>(cond_val))
+            else if (cond.op == "<")
             {
-                cond_num = std::get<float>(cond_val);
+                lower_hi(bytes_of(cond.value));
             }
-            else
+            else // <=
             {
-                cond_num = std::stof(std::get<std::string>(cond_val));
+                bytes = bytes_of(cond.value);
+                if (prefix_successor(bytes))
+                    lower_hi(bytes);
             }
-
-            if (cond.op == "=")
-                return std::abs(row_num - cond_num) < 1e-6;
-            if (cond.op == "!=")
-                return std::abs(row_num - cond_num) >= 1e-6;
-            if (cond.op == ">")
-                return row_num > cond_num;
-            if (cond.op == "<")
-                return row_num < cond_num;
-            if (cond.op == ">=")
-                return row_num >= cond_num;
-            if (cond.op == "<=")
-                return row_num <= cond_num;
         }
-        else
-        { // STRING
 
-            std::string row_str = std::get<std::string>(row_val);
-            std::string cond_str;
+        if (!fixed && !ranged)
+            break;
+        columns += (columns.empty() ? "" : ", ") + col.name;
+        if (!fixed)
+            break;
 
-            // Extract condition value as string
-            if (std::holds_alternative<std::string>(cond_val))
-            {
-                cond_str = std::get<std::string>(cond_val);
-            }
+        // An equality pins this column; any range on it stays residual
+        ranged = false;
+        prefix = fixed_bytes;
+        fixed_columns++;
+    }
+
+    if (columns.empty())
+        return path;
+
+    path.key_bytes = true;
+    path.column = "(" + columns + ")";
+    if (fixed_columns == table.key_columns.size())
+    {
+        path.type = empty ? AccessPathType::EMPTY : AccessPathType::INDEX_POINT;
+        path.key_min = prefix;
+        return path;
+    }
+    if (!ranged)
+    {
+        lo = prefix;
+        hi = prefix;
+        bounded = prefix_successor(hi);
+    }
+    path.key_min = lo;
+    path.key_max = bounded ? hi : "";
+    path.type = empty || (bounded && lo >= hi) ? AccessPathType::EMPTY : AccessPathType::INDEX_RANGE;
+    return path;
+}
+
+void Database::maintain_secondary(Table &table, const std::vector<int> &rows, bool add,
+                                  const std::vector<bool> *columns)
+{
+    for (auto &index : table.secondary_indexes)
+    {
+        if (columns && !(*columns)[index.column])
+            continue;
+        ColumnType type = column_type_of(table.columns[index.column].type);
+        for (int row : rows)
+        {
+            int64_t key = index_key_of(table.get_value(row, index.column), type);
+            if (add)
+                index.insert(key, row);
             else
-            {
-                std::stringstream ss;
-                ss << cond_val;
-                cond_str = ss.str();
-            }
+                index.remove(key, row);
+        }
+    }
+}
 
-            // Use Database::trim instead of a lambda
-            row_str = Database::trim(row_str);
-            cond_str = Database::trim(cond_str);
+void Database::rebuild_index(Table &table)
+{
+    for (auto &index : table.secondary_indexes)
+    {
+        ColumnType type = column_type_of(table.columns[index.column].type);
+        std::vector<IndexEntry> entries;
+        entries.reserve(table.row_count());
+        for (size_t i = 0; i < table.slot_count(); i++)
+        {
+            if (table.is_live(i))
+                entries.push_back({index_key_of(table.get_value(i, index.column), type), static_cast<int32_t>(i)});
+        }
+        index.rebuild(std::move(entries));
+    }
 
-            // Debug output
-            std::cerr << "DEBUG: Comparing '" << row_str << "' vs '" << cond_str << "'\n";
+    table.index = BPlusTree();
+    table.key_index = BasicBPlusTree<std::string>();
+    if (table.key_columns.empty())
+        return;
 
-            if (cond.op == "=")
-                return row_str == cond_str;
-            if (cond.op == "!=")
-                return row_str != cond_str;
-            if (cond.op == ">")
-                return row_str > cond_str;
-            if (cond.op == "<")
-                return row_str < cond_str;
+    if (!table.int_key())
+    {
+        std::vector<std::pair<std::string, int>> entries;
+        entries.reserve(table.row_count());
+        for (size_t i = 0; i < table.slot_count(); i++)
+        {
+            if (table.is_live(i))
+                entries.push_back({table.key_of(i), static_cast<int>(i)});
         }
+        std::sort(entries.begin(), entries.end());
+        table.key_index.bulk_load(entries);
+        return;
     }
-    catch (...)
+
+    int pk_col = table.key_columns[0];
+    std::vector<std::pair<int, int>> entries;
+    entries.reserve(table.row_count());
+    for (size_t i = 0; i < table.slot_count(); i++)
     {
-        return false;
+        if (!table.is_live(i))
+            continue;
+        Value pk_val = table.get_value(i, pk_col);
+        if (std::holds_alternative<int>(pk_val))
+            entries.push_back({std::get<int>(pk_val), static_cast<int>(i)});
     }
-    return false;
+    std::sort(entries.begin(), entries.end());
+    table.index.bulk_load(entries);
 }
 
-std::vector<int> Database::find_matching_rows(Table &table,
-                                    const std::vector<Condition> &conditions)
+std::string AccessPath::describe() const
 {
-    std::vector<int> matches;
-    if (conditions.empty())
+    if (secondary && type != AccessPathType::EMPTY)
     {
-        for (size_t i = 0; i < table.rows.size(); i++)
-            matches.push_back(i);
-        return matches;
+        if (secondary->kind == IndexKind::HASH)
+        {
+            std::string out = "HASH INDEX LOOKUP on " + secondary->name + " (" + column + ")";
+            if (secondary->exact)
+                out += " = " + std::to_string(secondary_min);
+            return out;
+        }
+
+        std::string out = std::string("SECONDARY INDEX ") +
+                          (type == AccessPathType::INDEX_POINT ? "LOOKUP" : "RANGE SCAN") + " on " +
+                          secondary->name + " (" + column + ")";
+        if (secondary->exact)
+            out += " [" + std::to_string(secondary_min) + ", " + std::to_string(secondary_max) + "]";
+        return out;
     }
 
-    for (size_t i = 0; i < table.rows.size(); i++)
+    if (key_bytes && type == AccessPathType::INDEX_POINT)
+        return "INDEX POINT LOOKUP on " + column;
+    if (key_bytes && type == AccessPathType::INDEX_RANGE)
+        return "INDEX RANGE SCAN on " + column;
+
+    switch (type)
+    {
+    case AccessPathType::INDEX_POINT:
+        return "INDEX POINT LOOKUP on " + column + " = " + std::to_string(min_key);
+    case AccessPathType::INDEX_RANGE:
+        return "INDEX RANGE SCAN on " + column + " [" + std::to_string(min_key) +
+               ", " + std::to_string(max_key) + "]";
+    case AccessPathType::EMPTY:
+        return "EMPTY (" + column + " interval is empty)";
+    default:
+        return "FULL SCAN";
+    }
+}
+
+AccessPath Database::plan_access_path(const Table &table,
+                                      const std::vector<Condition> &conditions)
+{
+    AccessPath path;
+    path.residual = conditions;
+
+    // Only a pure conjunction can be narrowed by a single key interval
+    for (size_t i = 1; i < conditions.size(); i++)
     {
-        bool result = evaluate_condition(table.rows[i], conditions[0], table);
-        for (size_t j = 1; j < conditions.size(); j++)
+        if (conditions[i].logical_op == "OR")
+            return path;
+    }
+
+    // Candidates rank by how narrow and cheap their probe is likely to be:
+    // an empty interval, a hash lookup, a primary-key point, a secondary
+    // equality, a primary-key range, then a secondary range
+    AccessPath best = path;
+    int best_rank = 6;
+
+    // A single INT primary key is probed by value; any other key by bytes
+    int pk_col = table.int_key() ? table.key_columns[0] : -1;
+    if (pk_col == -1 && !table.key_columns.empty())
+    {
+        AccessPath key_path = plan_key_path(table, conditions);
+        if (key_path.type != AccessPathType::FULL_SCAN)
+        {
+            best_rank = key_path.type == AccessPathType::EMPTY ? 0 : key_path.type == AccessPathType::INDEX_POINT ? 2 : 4;
+            best = key_path;
+        }
+    }
+
+    auto range_op = [](const Condition &cond)
+    {
+        return cond.op == "=" || cond.op == "<" || cond.op == "<=" || cond.op == ">" || cond.op == ">=";
+    };
+
+    if (pk_col != -1)
+    {
+        const std::string &pk_name = table.columns[pk_col].name;
+        int min_key = INT_MIN;
+        int max_key = INT_MAX;
+        bool sargable = false;
+        std::vector<Condition> residual;
+
+        for (const auto &cond : conditions)
         {
-            bool current = evaluate_condition(table.rows[i], conditions[j], table);
-            const std::string &op = conditions[j].logical_op; // Use current condition's logical_op
-            if (op == "OR")
+            if (cond.column != pk_name || !range_op(cond))
             {
-                result = result || current;
+                residual.push_back(cond);
+                continue;
             }
+
+            int lo = INT_MIN;
+            int hi = INT_MAX;
+            determine_range(cond, lo, hi);
+            min_key = std::max(min_key, lo);
+            max_key = std::min(max_key, hi);
+            sargable = true;
+        }
+
+        if (sargable)
+        {
+            AccessPath pk_path;
+            pk_path.column = pk_name;
+            pk_path.min_key = min_key;
+            pk_path.max_key = max_key;
+            pk_path.residual = residual;
+            if (min_key > max_key)
+                pk_path.type = AccessPathType::EMPTY;
+            else if (min_key == max_key)
+                pk_path.type = AccessPathType::INDEX_POINT;
             else
+                pk_path.type = AccessPathType::INDEX_RANGE;
+            best_rank = pk_path.type == AccessPathType::EMPTY ? 0 : pk_path.type == AccessPathType::INDEX_POINT ? 2 : 4;
+            best = pk_path;
+        }
+    }
+
+    for (const auto &index : table.secondary_indexes)
+    {
+        const Column &col = table.columns[index.column];
+        ColumnType type = column_type_of(col.type);
+        int64_t min_key = INT64_MIN;
+        int64_t max_key = INT64_MAX;
+        bool sargable = false;
+        bool equality = false;
+        std::vector<Condition> residual;
+
+        for (const auto &cond : conditions)
+        {
+            if (cond.column != col.name || !range_op(cond))
             {
-                result = result && current;
+                residual.push_back(cond);
+                continue;
             }
+
+            int64_t lo = INT64_MIN;
+            int64_t hi = INT64_MAX;
+            determine_secondary_range(cond, type, lo, hi);
+            min_key = std::max(min_key, lo);
+            max_key = std::min(max_key, hi);
+            sargable = true;
+            equality = equality || cond.op == "=";
+            if (!index.exact)
+                residual.push_back(cond);
         }
-        if (result)
-            matches.push_back(i);
+
+        bool hash = index.kind == IndexKind::HASH;
+        if (!sargable || !index.supports(min_key, max_key))
+            continue;
+        int rank = min_key > max_key ? 0 : hash ? 1 : equality ? 3 : 5;
+        if (rank >= best_rank)
+            continue;
+
+        AccessPath sec_path;
+        sec_path.column = col.name;
+        sec_path.secondary = &index;
+        sec_path.secondary_min = min_key;
+        sec_path.secondary_max = max_key;
+        sec_path.residual = residual;
+        sec_path.type = rank == 0               ? AccessPathType::EMPTY
+                        : equality || hash ? AccessPathType::INDEX_POINT
+                                           : AccessPathType::INDEX_RANGE;
+        best_rank = rank;
+        best = sec_path;
     }
-    return matches;
+
+    return best;
+}
+
+std::unique_ptr<ScanOperator> Database::make_scan(const Table &table, const std::vector<Condition> &conditions,
+                                                  std::vector<int> fetch, AccessPath *chosen)
+{
+    AccessPath path = plan_access_path(table, conditions);
+    if (chosen)
+        *chosen = path;
+
+    // Compile the residual conditions once; the loops only run the program
+    Predicate pred = Predicate::compile(table, path.residual);
+    std::shared_ptr<ThreadPool> workers = scan_pool();
+    if (path.type == AccessPathType::FULL_SCAN)
+        return std::make_unique<TableScan>(table, std::move(fetch), pred, *workers, morsel_rows);
+    return std::make_unique<IndexScan>(table, std::move(fetch), path, pred, *workers, morsel_rows);
+}
+
+std::vector<int> Database::find_matching_rows(Table &table,
+                                    const std::vector<Condition> &conditions,
+                                    AccessPath *chosen)
+{
+    return make_scan(table, conditions, {}, chosen)->take_row_ids();
 }
 
 std::string Database::trim(const std::string &s)
@@ -244,14 +680,29 @@ std::string Database::trim(const std::string &s)
 }
 Table * Database::get_table(const std::string &name)
 {
-    if (tables.find(name) != tables.end())
-        return tables[name].get();
-    return nullptr;
+    std::shared_lock<std::shared_mutex> catalog(catalog_latch);
+    auto it = tables.find(name);
+    return it == tables.end() ? nullptr : it->second.get();
+}
+
+Table &Database::table_named(const std::string &name)
+{
+    Table *table = get_table(name);
+    if (!table)
+        throw std::runtime_error("Table not found: " + name);
+    return *table;
+}
+
+std::shared_ptr<ThreadPool> Database::scan_pool() const
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return pool;
 }
 
 int Database::public_get_col_index(const std::string &table_name, const std::string &col_name)
 {
-    return get_col_index(table_name, col_name);
+    Table *table = get_table(table_name);
+    return table ? get_col_index(*table, col_name) : -1;
 }
 
 Value Database::public_parse_value(const std::string &str, const std::string &type)
@@ -259,11 +710,69 @@ Value Database::public_parse_value(const std::string &str, const std::string &ty
     return parse_value(str, type);
 }
 
-void Database::create_table(const std::string &name, const std::vector<Column> &columns)
+void Database::create_table(const std::string &name, const std::vector<Column> &columns,
+                            StorageLayout layout, const std::vector<std::string> &primary_key)
 {
-    tables[name] = std::make_unique<Table>();
-    tables[name]->name = name;
-    tables[name]->columns = columns;
+    auto table = std::make_unique<Table>();
+    table->name = name;
+    table->columns = columns;
+    table->layout = layout;
+
+    // A PRIMARY KEY (...) clause fixes the key order; otherwise the columns
+    // marked PRIMARY KEY form the key in declaration order
+    for (const auto &col : table->columns)
+    {
+        if (col.indexed && !primary_key.empty() &&
+            std::find(primary_key.begin(), primary_key.end(), col.name) == primary_key.end())
+            throw std::runtime_error("Conflicting PRIMARY KEY definitions");
+    }
+    for (const auto &key_name : primary_key)
+    {
+        auto col = std::find_if(table->columns.begin(), table->columns.end(),
+                                [&](const Column &c) { return c.name == key_name; });
+        if (col == table->columns.end())
+            throw std::runtime_error("Invalid column in PRIMARY KEY: " + key_name);
+        int col_idx = col - table->columns.begin();
+        if (std::find(table->key_columns.begin(), table->key_columns.end(), col_idx) != table->key_columns.end())
+            throw std::runtime_error("Duplicate column in PRIMARY KEY: " + key_name);
+        col->indexed = true;
+        table->key_columns.push_back(col_idx);
+    }
+    for (size_t i = 0; i < table->columns.size() && primary_key.empty(); i++)
+    {
+        if (table->columns[i].indexed)
+            table->key_columns.push_back(i);
+    }
+
+    table->init_storage();
+    if (layout == StorageLayout::PAGED)
+        table->pool = buffer_pool.get();
+
+    // Statements hold on to Table pointers, so a name is never rebound
+    std::unique_lock<std::shared_mutex> catalog(catalog_latch);
+    if (!tables.emplace(name, std::move(table)).second)
+        throw std::runtime_error("Table already exists: " + name);
+    uint64_t lsn = wal ? log_change(create_table_record(name, columns, layout, primary_key)) : 0;
+    catalog.unlock();
+    commit_change(lsn);
+}
+
+ResultCursor Database::open_join(const std::string &table1_name,
+                                const std::string &table2_name,
+                                const std::vector<Condition> &join_conditions,
+                                const std::vector<Condition> &where_conditions,
+                                const std::vector<std::string> &selected_columns,
+                                bool select_all)
+{
+    SelectQuery query;
+    query.table = table1_name;
+    query.join_table = table2_name;
+    query.join = join_conditions.at(0);
+    query.where = where_conditions;
+    query.select_all = select_all;
+    for (const auto &col_name : selected_columns)
+        query.items.push_back({col_name, false, AggregateFunction::COUNT, col_name});
+    return open_query(query);
 }
 
 void Database::select_join(const std::string &table1_name,
@@ -273,340 +782,807 @@ void Database::select_join(const std::string &table1_name,
                  const std::vector<std::string> &selected_columns,
                  bool select_all)
 {
-    Table *table1 = get_table(table1_name);
-    Table *table2 = get_table(table2_name);
-    if (!table1 || !table2)
-        return;
+    ResultCursor cursor = open_join(table1_name, table2_name, join_conditions, where_conditions,
+                                    selected_columns, select_all);
+    std::lock_guard<std::mutex> lock(output_mutex);
+    print_result(cursor, std::cout);
+}
 
-    // Get join column indices using proper table names
-    const auto &jc = join_conditions[0];
-    int col1_idx = get_col_index(jc.left_table, jc.left_col);
-    int col2_idx = get_col_index(jc.right_table, jc.right_col);
+// Index key for a value of a single INT primary-key column
+static int index_key(const Value &value)
+{
+    if (std::holds_alternative<int>(value))
+        return std::get<int>(value);
+    if (std::holds_alternative<float>(value))
+        return static_cast<int>(std::get<float>(value));
+    return std::stoi(std::get<std::string>(value));
+}
 
-    if (col1_idx == -1 || col2_idx == -1)
+// Check that none of a batch's primary keys is already in the index or
+// repeated within the batch. Keys held by the sorted slots in `replaced`
+// are leaving the index, so they do not count as taken.
+template <typename Index, typename Key>
+static void check_new_keys(const Index &index, const std::vector<Key> &keys,
+                           const std::vector<int> &replaced = {})
+{
+    for (const auto &key : keys)
     {
-        std::cerr << "Join columns not found: "
-                  << jc.left_table << "." << jc.left_col << " vs "
-                  << jc.right_table << "." << jc.right_col << "\n";
-        return;
+        int existing;
+        if (index.find(key, existing) && !std::binary_search(replaced.begin(), replaced.end(), existing))
+            throw std::runtime_error("Duplicate primary key");
     }
+    std::vector<Key> sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    if (std::adjacent_find(sorted_keys.begin(), sorted_keys.end()) != sorted_keys.end())
+        throw std::runtime_error("Duplicate primary key");
+}
 
-    std::vector<std::vector<Value>> results;
+void Database::update(const std::string &table_name,
+            const std::vector<std::pair<std::string, Value>> &updates,
+            const std::vector<Condition> &conditions)
+{
+    auto &table = table_named(table_name);
+    std::unique_lock<std::shared_mutex> latch(table.latch);
 
-    // Nested loop join implementation
-    for (size_t i = 0; i < table1->rows.size(); i++)
+    // Safety: ensure all update and condition columns exist
+    for (auto &upd : updates)
     {
-        const Value &join_val = table1->rows[i][col1_idx];
-        for (size_t j = 0; j < table2->rows.size(); j++)
+        int ci = get_col_index(table, upd.first);
+        if (ci == -1)
         {
-            if (table2->rows[j][col2_idx] == join_val)
-            {
-                auto combined_row = table1->rows[i];
-                combined_row.insert(combined_row.end(),
-                                    table2->rows[j].begin(),
-                                    table2->rows[j].end());
-
-                // Apply WHERE conditions
-                bool valid = true;
-                for (const auto &cond : where_conditions)
-                {
-                    if (!evaluate_condition(combined_row, cond, *table1))
-                    {
-                        valid = false;
-                        break;
-                    }
-                }
-                if (valid)
-                    results.push_back(combined_row);
-            }
+            throw std::runtime_error("Invalid column in UPDATE: " + upd.first);
         }
     }
-
-    // In Database::select_join method - replace the output section with:
-    // Calculate column widths
-    std::vector<size_t> col_widths;
-
-    if (select_all)
+    for (auto &cond : conditions)
     {
-        // For all columns in both tables
-        for (const auto &col : table1->columns)
+        int col_idx = get_col_index(table, cond.column);
+        if (col_idx == -1)
         {
-            size_t width = (table1->name + "." + col.name).length();
-            for (const auto &row : results)
-            {
-                std::stringstream ss;
-                ss << row[get_col_index(table1->name, col.name)];
-                width = std::max(width, ss.str().length());
-            }
-            col_widths.push_back(width + 2);
-        }
-        for (const auto &col : table2->columns)
-        {
-            size_t width = (table2->name + "." + col.name).length();
-            for (const auto &row : results)
-            {
-                std::stringstream ss;
-                ss << row[table1->columns.size() + get_col_index(table2->name, col.name)];
-                width = std::max(width, ss.str().length());
-            }
-            col_widths.push_back(width + 2);
+            throw std::runtime_error("Invalid column in UPDATE WHERE: " + cond.column);
         }
     }
-    else
+    auto matches = find_matching_rows(table, conditions);
+
+    // Rows move in the primary index when any SET column is a key column
+    bool key_changed = false;
+    for (const auto &update : updates)
     {
-        // For selected columns
-        for (const auto &col_name : selected_columns)
-        {
-            size_t width = col_name.length();
-            size_t dot_pos = col_name.find('.');
-            std::string table_part = col_name.substr(0, dot_pos);
-            std::string field_part = col_name.substr(dot_pos + 1);
+        int col_idx = get_col_index(table, update.first);
+        if (col_idx != -1 && table.columns[col_idx].indexed)
+            key_changed = true;
+    }
 
-            for (const auto &row : results)
+    // Work out every row's new key and check them all before touching
+    // storage, so a statement that would repeat a key changes nothing
+    std::vector<int> keys;
+    std::vector<std::string> key_bytes;
+    if (key_changed)
+    {
+        std::vector<int> replaced = matches;
+        std::sort(replaced.begin(), replaced.end());
+        try
+        {
+            std::vector<Value> key_row(table.columns.size());
+            for (int idx : matches)
             {
-                int idx = -1;
-                if (table_part == table1->name)
+                for (int col : table.key_columns)
+                    key_row[col] = table.get_value(idx, col);
+                for (const auto &update : updates)
                 {
-                    idx = get_col_index(table_part, field_part);
+                    int col_idx = get_col_index(table, update.first);
+                    if (table.columns[col_idx].indexed)
+                        key_row[col_idx] = update.second;
                 }
+                if (table.int_key())
+                    keys.push_back(index_key(key_row[table.key_columns[0]]));
                 else
-                {
-                    idx = table1->columns.size() + get_col_index(table_part, field_part);
-                }
-
-                if (idx != -1)
-                {
-                    std::stringstream ss;
-                    ss << row[idx];
-                    width = std::max(width, ss.str().length());
-                }
+                    key_bytes.push_back(table.key_of(key_row));
             }
-            col_widths.push_back(width + 2);
+            if (table.int_key())
+                check_new_keys(table.index, keys, replaced);
+            else
+                check_new_keys(table.key_index, key_bytes, replaced);
         }
-    }
-
-    // Print headers
-    std::cout << "\nResults (" << results.size() << " rows):\n";
-    if (select_all)
-    {
-        for (size_t i = 0; i < table1->columns.size(); i++)
+        catch (const std::exception &e)
         {
-            std::cout << std::left << std::setw(col_widths[i])
-                      << table1->name + "." + table1->columns[i].name;
+            throw std::runtime_error(std::string("Index error: ") + e.what());
         }
-        for (size_t i = 0; i < table2->columns.size(); i++)
+
+        for (int idx : matches)
         {
-            std::cout << std::left << std::setw(col_widths[table1->columns.size() + i])
-                      << table2->name + "." + table2->columns[i].name;
+            if (table.int_key())
+                table.index.remove(index_key(table.get_value(idx, table.key_columns[0])));
+            else
+                table.key_index.remove(table.key_of(idx));
         }
     }
-    else
+
+    // Entries of secondary indexes on SET columns move with their values
+    std::vector<bool> touched(table.columns.size(), false);
+    for (const auto &update : updates)
+        touched[get_col_index(table, update.first)] = true;
+    maintain_secondary(table, matches, false, &touched);
+
+    // Each SET assigns a constant, so apply it column by column
+    for (const auto &update : updates)
     {
-        for (size_t i = 0; i < selected_columns.size(); i++)
+        int col_idx = get_col_index(table, update.first);
+        if (col_idx != -1)
+            table.update_rows(matches, col_idx, update.second);
+    }
+    maintain_secondary(table, matches, true, &touched);
+
+    for (size_t i = 0; i < keys.size(); i++)
+        table.index.insert(keys[i], matches[i]);
+    for (size_t i = 0; i < key_bytes.size(); i++)
+        table.key_index.insert(std::move(key_bytes[i]), matches[i]);
+
+    uint64_t lsn = wal ? log_change(update_record(table_name, updates, conditions)) : 0;
+    latch.unlock();
+    commit_change(lsn);
+}
+
+void Database::delete_rows(const std::string &table_name,
+                 const std::vector<Condition> &conditions)
+{
+    auto &table = table_named(table_name);
+    std::unique_lock<std::shared_mutex> latch(table.latch);
+
+    // Safety: ensure all condition columns exist
+    for (auto &cond : conditions)
+    {
+        int col_idx = get_col_index(table, cond.column);
+        if (col_idx == -1)
         {
-            std::cout << std::left << std::setw(col_widths[i]) << selected_columns[i];
+            throw std::runtime_error("Invalid column in DELETE WHERE: " + cond.column);
         }
     }
-    std::cout << "\n"
-              << std::string(std::accumulate(col_widths.begin(), col_widths.end(), 0), '-') << "\n";
+    auto matches = find_matching_rows(table, conditions);
 
-    // Print rows
-    for (const auto &row : results)
+    // Slots are stable, so only the deleted rows' keys leave the index
+    if (table.int_key())
     {
-        for (size_t i = 0; i < row.size(); i++)
+        for (int row : matches)
         {
-            if (i < col_widths.size())
-            {
-                std::cout << std::left << std::setw(col_widths[i]) << row[i];
-            }
+            Value pk_val = table.get_value(row, table.key_columns[0]);
+            if (std::holds_alternative<int>(pk_val))
+                table.index.remove(std::get<int>(pk_val));
         }
-        std::cout << "\n";
     }
+    else if (!table.key_columns.empty())
+    {
+        for (int row : matches)
+            table.key_index.remove(table.key_of(row));
+    }
+    maintain_secondary(table, matches, false);
+    table.erase_rows(matches);
+
+    if (table.needs_compaction())
+        compact_table(table);
+
+    uint64_t lsn = wal ? log_change(delete_record(table_name, conditions)) : 0;
+    latch.unlock();
+    commit_change(lsn);
 }
 
-void Database::update(const std::string &table_name,
-            const std::vector<std::pair<std::string, Value>> &updates,
-            const std::vector<Condition> &conditions)
+size_t Database::compact_table(Table &table)
 {
-    auto &table = *tables[table_name];
-    auto matches = find_matching_rows(table, conditions);
+    size_t reclaimed = table.compact();
+    if (reclaimed > 0)
+        rebuild_index(table);
+    return reclaimed;
+}
 
-    // Safety: ensure all update columns exist
-    for (auto &upd : updates)
+void Database::set_threads(size_t threads)
+{
+    if (threads == 0 || threads > 1024)
+        throw std::runtime_error("THREADS must be between 1 and 1024");
+    auto fresh = std::make_shared<ThreadPool>(threads);
     {
-        int ci = get_col_index(table_name, upd.first);
-        if (ci == -1)
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        pool.swap(fresh);
+    }
+    std::cout << "Threads: " << threads << "\n";
+}
+
+void Database::set_buffer_pool_size(size_t megabytes)
+{
+    if (megabytes == 0)
+        throw std::runtime_error("BUFFER_POOL_MB must be at least 1");
+    buffer_pool->set_capacity(megabytes * (1 << 20) / PAGE_SIZE);
+    std::cout << "Buffer pool: " << buffer_pool->stats().capacity << " pages of " << PAGE_SIZE << " bytes\n";
+}
+
+void Database::show_buffer_pool()
+{
+    BufferPoolStats stats = buffer_pool->stats();
+    uint64_t lookups = stats.hits + stats.misses;
+    std::ostringstream text;
+    text << "Buffer pool: " << stats.resident << " of " << stats.capacity << " frames resident ("
+         << stats.pinned << " pinned, " << stats.dirty << " dirty)\n"
+         << "  Spill file: " << stats.file_pages << " pages, " << stats.free_pages << " free\n"
+         << "  Hits: " << stats.hits << ", misses: " << stats.misses;
+    if (lookups > 0)
+        text << " (" << std::fixed << std::setprecision(1) << 100.0 * stats.hits / lookups << "% hit rate)";
+    text << "\n  Evictions: " << stats.evictions << ", write-backs: " << stats.writebacks << "\n";
+    std::cout << text.str();
+}
+
+void Database::set_morsel_size(size_t rows)
+{
+    if (rows == 0)
+        throw std::runtime_error("MORSEL_SIZE must be at least 1");
+    rows = (rows + Predicate::BLOCK_ROWS - 1) / Predicate::BLOCK_ROWS * Predicate::BLOCK_ROWS;
+    morsel_rows = rows;
+    std::cout << "Morsel size: " << rows << " rows\n";
+}
+
+void Database::vacuum(const std::string &table_name)
+{
+    auto &table = table_named(table_name);
+    std::unique_lock<std::shared_mutex> latch(table.latch);
+    size_t reclaimed = compact_table(table);
+    uint64_t lsn = wal ? log_change(change_record(WalOp::VACUUM, table_name)) : 0;
+    latch.unlock();
+    commit_change(lsn);
+    std::cout << "Vacuumed " << table_name << ": " << reclaimed << " slots reclaimed\n";
+}
+
+void Database::create_index(const std::string &index_name, const std::string &table_name,
+                            const std::string &column_name, IndexKind kind)
+{
+    // Exclusive catalog latch keeps index names unique across tables
+    std::unique_lock<std::shared_mutex> catalog(catalog_latch);
+    auto found = tables.find(table_name);
+    if (found == tables.end())
+        throw std::runtime_error("Table not found: " + table_name);
+    Table *table = found->second.get();
+    std::unique_lock<std::shared_mutex> latch(table->latch);
+    int col_idx = get_col_index(*table, column_name);
+    if (col_idx == -1)
+        throw std::runtime_error("Invalid column in CREATE INDEX: " + column_name);
+    for (const auto &entry : tables)
+    {
+        for (const auto &index : entry.second->secondary_indexes)
         {
-            throw std::runtime_error("Invalid column in UPDATE: " + upd.first);
+            if (index.name == index_name)
+                throw std::runtime_error("Index already exists: " + index_name);
         }
     }
 
-    int pk_col = -1;
-    for (const auto &update : updates)
+    ColumnType type = column_type_of(table->columns[col_idx].type);
+    SecondaryIndex index(index_name, col_idx, type == ColumnType::INT, kind);
+    std::vector<IndexEntry> entries;
+    entries.reserve(table->row_count());
+    for (size_t i = 0; i < table->slot_count(); i++)
     {
-        int col_idx = get_col_index(table_name, update.first);
-        if (col_idx != -1 && table.columns[col_idx].indexed)
+        if (table->is_live(i))
+            entries.push_back({index_key_of(table->get_value(i, col_idx), type), static_cast<int32_t>(i)});
+    }
+    index.rebuild(std::move(entries));
+    table->secondary_indexes.push_back(std::move(index));
+
+    uint64_t lsn = wal ? log_change(create_index_record(index_name, table_name, column_name, kind)) : 0;
+    latch.unlock();
+    catalog.unlock();
+    commit_change(lsn);
+}
+
+void Database::show_index(const std::string &table_name)
+{
+    Table *table = get_table(table_name);
+    if (!table)
+        throw std::runtime_error("Table not found: " + table_name);
+    std::shared_lock<std::shared_mutex> latch(table->latch);
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    auto print = [&](const std::string &label, const BPlusTreeStats &stats)
+    {
+        out << label << ": " << stats.entries << " keys, height " << stats.height << "\n"
+            << "  leaves:         " << stats.leaves << " (" << stats.leaf_fill * 100 << "% full)\n"
+            << "  internal nodes: " << stats.internals << " (" << stats.internal_fill * 100 << "% full)\n"
+            << "  pool memory:    " << stats.reserved_bytes / 1024 << " KiB\n";
+        if (stats.key_bytes > 0)
+            out << "  key bytes:      " << stats.key_bytes / 1024 << " KiB\n";
+    };
+
+    if (table->int_key())
+    {
+        print("Index on " + table_name + "." + table->columns[table->key_columns[0]].name, table->index.stats());
+    }
+    else if (!table->key_columns.empty())
+    {
+        std::string names;
+        for (int col : table->key_columns)
+            names += (names.empty() ? "" : ", ") + table->columns[col].name;
+        bool composite = table->key_columns.size() > 1;
+        print("Index on " + table_name + (composite ? "(" + names + ")" : "." + names), table->key_index.stats());
+    }
+    for (const auto &index : table->secondary_indexes)
+    {
+        std::string label = "Index " + index.name + " on " + table_name + "." + table->columns[index.column].name;
+        if (index.kind == IndexKind::BTREE)
         {
-            pk_col = col_idx;
-            break;
+            print(label, index.stats());
+            continue;
         }
+        HashIndexStats stats = index.hash_stats();
+        out << label << " (hash): " << stats.entries << " entries, " << stats.keys << " keys\n"
+            << "  slots:          " << stats.capacity << " (" << stats.load * 100 << "% full)\n"
+            << "  longest probe:  " << stats.max_probe << "\n"
+            << "  memory:         " << stats.reserved_bytes / 1024 << " KiB\n";
+    }
+
+    if (out.tellp() == 0)
+        out << table_name << " has no index\n";
+    std::cout << out.str();
+}
+
+void Database::insert_into(const std::string &table_name, const std::vector<Value> &values)
+{
+    insert_many(table_name, {values});
+}
+
+// Small batches go through ordinary inserts. Once the batch is at least as
+// large as the index, merging both key streams and rebuilding bottom-up is
+// cheaper than splitting nodes one key at a time.
+template <typename Index, typename Key>
+static void add_index_entries(Index &index, std::vector<std::pair<Key, int>> &new_entries)
+{
+    if (new_entries.empty())
+        return;
+    std::sort(new_entries.begin(), new_entries.end());
+
+    if (new_entries.size() < index.size())
+    {
+        for (const auto &entry : new_entries)
+            index.insert(entry.first, entry.second);
+        return;
+    }
+
+    std::vector<std::pair<Key, int>> merged;
+    merged.reserve(index.size() + new_entries.size());
+    auto incoming = new_entries.begin();
+    for (auto it = index.begin(); it.valid(); it.next())
+    {
+        for (; incoming != new_entries.end() && incoming->first < it.key(); ++incoming)
+            merged.push_back(std::move(*incoming));
+        merged.push_back({Key(it.key()), it.value()});
+    }
+    merged.insert(merged.end(), std::make_move_iterator(incoming), std::make_move_iterator(new_entries.end()));
+    index.bulk_load(merged);
+}
+
+void Database::insert_many(const std::string &table_name, const std::vector<std::vector<Value>> &rows)
+{
+    auto &table = table_named(table_name);
+    std::unique_lock<std::shared_mutex> latch(table.latch);
+    bool keyed = !table.key_columns.empty();
+    bool int_key = table.int_key();
+
+    // A hash index on an INT primary key answers the duplicate check in O(1)
+    const SecondaryIndex *pk_hash = nullptr;
+    for (const auto &index : table.secondary_indexes)
+    {
+        if (int_key && index.kind == IndexKind::HASH && int(index.column) == table.key_columns[0])
+            pk_hash = &index;
     }
 
-    for (int idx : matches)
+    // Check the primary key constraint and the row sizes for the whole batch
+    // before touching storage, so a rejected batch leaves the table unchanged
+    for (const auto &row : rows)
+        table.check_row_fits(row);
+    std::vector<int> keys;
+    std::vector<std::string> key_bytes;
+    if (keyed)
     {
-        if (pk_col != -1)
+        try
         {
-            Value old_pk = table.rows[idx][pk_col];
-            try
+            for (const auto &row : rows)
             {
-                int old_key = std::get<int>(old_pk);
-                table.index.remove(old_key);
-            }
-            catch (...)
-            {
-                std::cerr << "Error removing old key\n";
+                if (int_key)
+                    keys.push_back(index_key(row[table.key_columns[0]]));
+                else
+                    key_bytes.push_back(table.key_of(row));
             }
+            if (int_key && pk_hash)
+                check_new_keys(*pk_hash, keys);
+            else if (int_key)
+                check_new_keys(table.index, keys);
+            else
+                check_new_keys(table.key_index, key_bytes);
         }
-
-        for (const auto &update : updates)
+        catch (const std::exception &e)
         {
-            int col_idx = get_col_index(table_name, update.first);
-            if (col_idx != -1)
-            {
-                table.rows[idx][col_idx] = update.second;
-            }
+            throw std::runtime_error(std::string("Index error: ") + e.what());
         }
+    }
+
+    // Rows may land in reused slots, so pair keys with slots as they go in
+    std::vector<int> slots;
+    slots.reserve(rows.size());
+    for (const auto &row : rows)
+        slots.push_back(table.append_row(row));
+    maintain_secondary(table, slots, true);
+
+    if (int_key)
+    {
+        std::vector<std::pair<int, int>> new_entries;
+        new_entries.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+            new_entries.push_back({keys[i], slots[i]});
+        add_index_entries(table.index, new_entries);
+    }
+    else if (keyed)
+    {
+        std::vector<std::pair<std::string, int>> new_entries;
+        new_entries.reserve(key_bytes.size());
+        for (size_t i = 0; i < key_bytes.size(); i++)
+            new_entries.push_back({std::move(key_bytes[i]), slots[i]});
+        add_index_entries(table.key_index, new_entries);
+    }
+
+    // Record lengths are 32-bit, so a bulk load logs a run of records
+    uint64_t lsn = 0;
+    for (size_t begin = 0; wal && begin < rows.size(); begin += INSERT_RECORD_ROWS)
+    {
+        size_t end = std::min(rows.size(), begin + INSERT_RECORD_ROWS);
+        lsn = log_change(insert_record(table_name, {rows.begin() + begin, rows.begin() + end}));
+    }
+    latch.unlock();
+    commit_change(lsn);
+}
+
+void Database::copy_from(const std::string &table_name, const std::string &path, const CsvOptions &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ColumnType> types;
+    {
+        auto &table = table_named(table_name);
+        std::shared_lock<std::shared_mutex> latch(table.latch);
+        for (const auto &col : table.columns)
+            types.push_back(column_type_of(col.type));
+    }
 
-        if (pk_col != -1)
+    MappedFile file(path);
+    const char *data = file.data();
+    size_t size = file.size();
+    size_t skipped = 0;
+    if (options.header && size > 0)
+    {
+        const void *newline = std::memchr(data, '\n', size);
+        skipped = newline ? static_cast<const char *>(newline) - data + 1 : size;
+    }
+
+    // Chunks end on line boundaries and parse on the scan workers; each
+    // keeps its rows so they go in in file order
+    auto ranges = split_csv(data + skipped, size - skipped, COPY_CHUNK_BYTES);
+    std::vector<CsvBatch> batches(ranges.size());
+    scan_pool()->run(ranges.size(), [&](size_t task, size_t)
+                     {
+                         batches[task] = parse_csv(data + skipped + ranges[task].first,
+                                                   data + skipped + ranges[task].second,
+                                                   types, options.delimiter);
+                     });
+
+    size_t line = options.header && skipped > 0 ? 1 : 0;
+    size_t total = 0;
+    for (const auto &batch : batches)
+    {
+        if (!batch.error.empty())
+            throw std::runtime_error(path + " line " + std::to_string(line + batch.error_line) + ": " + batch.error);
+        line += batch.lines;
+        total += batch.rows.size();
+    }
+    std::vector<std::vector<Value>> rows;
+    rows.reserve(total);
+    for (auto &batch : batches)
+    {
+        std::move(batch.rows.begin(), batch.rows.end(), std::back_inserter(rows));
+        batch.rows = {};
+    }
+
+    // One batch: the key check covers the whole file and large loads build
+    // the index bottom-up
+    insert_many(table_name, rows);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Copied " << rows.size() << " rows from " << path << " in "
+              << static_cast<long long>(seconds * 1000) << " ms";
+    if (seconds > 0)
+        std::cout << " (" << static_cast<long long>(rows.size() / seconds) << " rows/s)";
+    std::cout << "\n";
+}
+
+// Where a column named in a query comes from: (left table?, ordinal), or
+// (true, -1) when neither table has it. Qualified names pick their table;
+// bare names try the left table first.
+static std::pair<bool, int> resolve_column(const std::string &name, const Table &left, const Table *right)
+{
+    size_t dot = name.find('.');
+    std::string table_part = dot == std::string::npos ? "" : name.substr(0, dot);
+    std::string column = dot == std::string::npos ? name : name.substr(dot + 1);
+    for (bool is_left : {true, false})
+    {
+        const Table *table = is_left ? &left : right;
+        if (!table || (!table_part.empty() && table_part != table->name))
+            continue;
+        for (size_t i = 0; i < table->columns.size(); i++)
         {
-            Value new_pk = table.rows[idx][pk_col];
-            try
-            {
-                int new_key = std::get<int>(new_pk);
-                table.index.insert(new_key, idx);
-            }
-            catch (...)
-            {
-                std::cerr << "Error inserting new key\n";
-            }
+            if (table->columns[i].name == column)
+                return {is_left, int(i)};
         }
     }
+    return {true, -1};
 }
 
-void Database::delete_rows(const std::string &table_name,
-                 const std::vector<Condition> &conditions)
+std::unique_ptr<Operator> Database::plan_query(const SelectQuery &query,
+                                               std::vector<std::shared_lock<std::shared_mutex>> &latches,
+                                               std::string &plan_line)
 {
-    auto &table = *tables[table_name];
+    Table *left = &table_named(query.table);
+    Table *right = query.join_table.empty() ? nullptr : &table_named(query.join_table);
 
-    // Safety: ensure all condition columns exist
-    for (auto &cond : conditions)
+    // Latch both tables in address order; a self-join latches once
+    Table *first = right ? std::min(left, right) : left;
+    latches.emplace_back(first->latch);
+    if (right && left != right)
+        latches.emplace_back(std::max(left, right)->latch);
+
+    // Columns the plan reads, as (left?, ordinal), in output order of the
+    // scan or join; `slot` finds or adds one
+    std::vector<std::pair<bool, int>> needed;
+    std::vector<std::string> needed_names;
+    auto slot = [&](const std::string &name, const char *what)
     {
-        int col_idx = get_col_index(table_name, cond.column);
-        if (col_idx == -1)
+        auto source = resolve_column(name, *left, right);
+        if (source.second == -1)
+            throw std::runtime_error(std::string("Invalid column in ") + what + ": " + name);
+        auto found = std::find(needed.begin(), needed.end(), source);
+        if (found != needed.end())
+            return int(found - needed.begin());
+        needed.push_back(source);
+        const Table &table = source.first ? *left : *right;
+        needed_names.push_back(right ? table.name + "." + table.columns[source.second].name : name);
+        return int(needed.size() - 1);
+    };
+
+    if (query.select_all)
+    {
+        // Added directly: in a self-join both sides have every name
+        for (bool is_left : {true, false})
         {
-            throw std::runtime_error("Invalid column in DELETE WHERE: " + cond.column);
+            const Table *table = is_left ? left : right;
+            for (size_t i = 0; table && i < table->columns.size(); i++)
+            {
+                needed.push_back({is_left, int(i)});
+                needed_names.push_back((right ? table->name + "." : "") + table->columns[i].name);
+            }
         }
     }
-    auto matches = find_matching_rows(table, conditions);
 
-    int pk_col = -1;
-    for (size_t i = 0; i < table.columns.size(); i++)
+    // Aggregates and group columns point into the scan or join output
+    bool aggregated = !query.group_by.empty();
+    std::vector<int> item_slots;
+    std::vector<AggregateSpec> aggregates;
+    for (const auto &item : query.items)
     {
-        if (table.columns[i].indexed)
+        aggregated = aggregated || item.aggregate;
+        if (item.aggregate)
         {
-            pk_col = i;
-            break;
+            int column = item.column == "*" ? -1 : slot(item.column, "SELECT");
+            aggregates.push_back({item.function, column, item.name});
+            item_slots.push_back(-1);
+        }
+        else
+        {
+            item_slots.push_back(slot(item.column, "SELECT"));
         }
     }
+    std::vector<int> group_slots;
+    for (const auto &col_name : query.group_by)
+        group_slots.push_back(slot(col_name, "GROUP BY"));
+    if (aggregated && query.select_all)
+        throw std::runtime_error("SELECT * cannot be combined with aggregates or GROUP BY");
 
-    std::sort(matches.rbegin(), matches.rend());
-    for (int idx : matches)
+    // Without aggregates ORDER BY keys are scan or join columns; with them
+    // they are matched against the aggregate's output further down
+    std::vector<SortKey> sort_keys;
+    for (const auto &order : query.order_by)
+        sort_keys.push_back({aggregated ? -1 : slot(order.column, "ORDER BY"), order.descending});
+
+    // WHERE goes to the scans, by bare column name. In a join an AND-only
+    // clause is split between the two; with OR it is checked on the joined
+    // rows instead. Unknown columns stay with the left scan, where they
+    // reject every row.
+    bool any_or = false;
+    for (size_t i = 1; i < query.where.size(); i++)
+        any_or = any_or || query.where[i].logical_op == "OR";
+    std::vector<Condition> left_where, right_where;
+    std::vector<FilterCondition> filter;
+    for (const auto &cond : query.where)
     {
-        if (pk_col != -1)
+        auto source = resolve_column(cond.column, *left, right);
+        if (right && any_or)
         {
-            Value pk_val = table.rows[idx][pk_col];
-            try
-            {
-                int key = std::get<int>(pk_val);
-                table.index.remove(key);
-            }
-            catch (...)
-            {
-                std::cerr << "Error removing key from index\n";
-            }
+            CompareOp op;
+            if (source.second == -1 || !parse_compare_op(cond.op, op))
+                throw std::runtime_error("Invalid condition in WHERE: " + cond.column + " " + cond.op);
+            filter.push_back({slot(cond.column, "WHERE"), op, cond.value, cond.logical_op == "OR"});
+            continue;
         }
-        table.rows.erase(table.rows.begin() + idx);
+        Condition pushed = cond;
+        if (source.second != -1)
+            pushed.column = (source.first ? left : right)->columns[source.second].name;
+        (source.first ? left_where : right_where).push_back(pushed);
     }
-}
 
-void Database::insert_into(const std::string &table_name, const std::vector<Value> &values)
-{
-    auto &table = *tables[table_name];
+    std::unique_ptr<Operator> root;
+    if (!right)
+    {
+        std::vector<int> fetch;
+        for (const auto &source : needed)
+            fetch.push_back(source.second);
 
-    // Check primary key constraint
-    for (size_t i = 0; i < table.columns.size(); i++)
+        // Ascending keys that lead the primary key are already in key
+        // order: walk the key index instead of sorting, unless a secondary
+        // index narrows the rows better
+        bool key_order = !aggregated && !sort_keys.empty() && sort_keys.size() <= left->key_columns.size();
+        for (size_t k = 0; key_order && k < sort_keys.size(); k++)
+        {
+            key_order = !sort_keys[k].descending &&
+                        needed[sort_keys[k].column] == std::make_pair(true, left->key_columns[k]);
+        }
+        AccessPath path = plan_access_path(*left, left_where);
+        if (key_order && !path.secondary)
+        {
+            std::string key_names;
+            for (size_t k = 0; k < left->key_columns.size(); k++)
+                key_names += (k == 0 ? "" : ", ") + left->columns[left->key_columns[k]].name;
+            plan_line = "Access path: KEY ORDER SCAN on " + key_names;
+            if (path.type != AccessPathType::FULL_SCAN)
+                plan_line += " within " + path.describe();
+            root = std::make_unique<OrderedIndexScan>(*left, std::move(fetch), path,
+                                                      Predicate::compile(*left, path.residual));
+            sort_keys.clear();
+        }
+        else
+        {
+            root = make_scan(*left, left_where, std::move(fetch), &path);
+            plan_line = "Access path: " + path.describe();
+        }
+    }
+    else
     {
-        if (table.columns[i].indexed)
+        const Condition &jc = query.join;
+        auto column_of = [&](const std::string &table_name, const std::string &col_name)
         {
-            int key = 0;
-            try
-            {
-                if (std::holds_alternative<int>(values[i]))
-                {
-                    key = std::get<int>(values[i]);
-                }
-                else if (std::holds_alternative<float>(values[i]))
-                {
-                    key = static_cast<int>(std::get<float>(values[i]));
-                }
-                else
-                {
-                    key = std::stoi(std::get<std::string>(values[i]));
-                }
+            if (table_name == left->name)
+                return get_col_index(*left, col_name);
+            return table_name == right->name ? get_col_index(*right, col_name) : -1;
+        };
+        int left_key = column_of(jc.left_table, jc.left_col);
+        int right_key = column_of(jc.right_table, jc.right_col);
+        if (left_key == -1 || right_key == -1)
+        {
+            throw std::runtime_error("Join columns not found: " + jc.left_table + "." + jc.left_col + " vs " +
+                                     jc.right_table + "." + jc.right_col);
+        }
+        // ON may name the tables in either order
+        if (jc.left_table != left->name)
+            std::swap(left_key, right_key);
 
-                if (!table.index.search(key).empty())
-                {
-                    throw std::runtime_error("Duplicate primary key");
-                }
-            }
-            catch (const std::exception &e)
+        std::vector<JoinColumn> columns;
+        for (size_t i = 0; i < needed.size(); i++)
+            columns.push_back({needed[i].first, needed[i].second, needed_names[i]});
+        auto join = std::make_unique<EquiJoin>(make_scan(*left, left_where, {}), make_scan(*right, right_where, {}),
+                                               left_key, right_key, std::move(columns),
+                                               *scan_pool());
+        plan_line = "Join strategy: " + join->strategy();
+        root = std::move(join);
+        if (!filter.empty())
+            root = std::make_unique<Filter>(std::move(root), std::move(filter));
+    }
+
+    if (aggregated)
+    {
+        // Aggregate emits the group columns, then the aggregates
+        root = std::make_unique<Aggregate>(std::move(root), group_slots, std::move(aggregates));
+        size_t next_aggregate = group_slots.size();
+        for (size_t i = 0; i < query.items.size(); i++)
+        {
+            if (query.items[i].aggregate)
             {
-                throw std::runtime_error(std::string("Index error: ") + e.what());
+                item_slots[i] = next_aggregate++;
+                continue;
             }
+            auto group = std::find(group_slots.begin(), group_slots.end(), item_slots[i]);
+            if (group == group_slots.end())
+                throw std::runtime_error("Column " + query.items[i].column + " must appear in GROUP BY");
+            item_slots[i] = group - group_slots.begin();
         }
-    }
 
-    table.rows.push_back(values);
-    int row_index = table.rows.size() - 1;
-
-    for (size_t i = 0; i < table.columns.size(); i++)
-    {
-        if (table.columns[i].indexed)
+        // An aggregate key names a select item; a column must be grouped
+        for (size_t k = 0; k < sort_keys.size(); k++)
         {
-            try
+            const std::string &name = query.order_by[k].column;
+            for (size_t i = 0; i < query.items.size() && sort_keys[k].column == -1; i++)
             {
-                int key = 0;
-                if (std::holds_alternative<int>(values[i]))
-                {
-                    key = std::get<int>(values[i]);
-                }
-                else if (std::holds_alternative<float>(values[i]))
-                {
-                    key = static_cast<int>(std::get<float>(values[i]));
-                }
-                else
-                {
-                    key = std::stoi(std::get<std::string>(values[i]));
-                }
-                table.index.insert(key, row_index);
+                if (query.items[i].aggregate && query.items[i].name == name)
+                    sort_keys[k].column = item_slots[i];
             }
-            catch (...)
+            auto source = resolve_column(name, *left, right);
+            for (size_t g = 0; g < group_slots.size() && sort_keys[k].column == -1; g++)
             {
-                std::cerr << "Index update failed\n";
+                if (source.second != -1 && needed[group_slots[g]] == source)
+                    sort_keys[k].column = g;
             }
-            break;
+            if (sort_keys[k].column == -1)
+                throw std::runtime_error("ORDER BY " + name + " must be an aggregate or a GROUP BY column");
         }
     }
+
+    // With a LIMIT only the first limit + offset rows need ordering
+    if (!sort_keys.empty())
+    {
+        size_t keep = query.limit == NO_LIMIT || query.limit > NO_LIMIT - query.offset
+                          ? UNKNOWN_ROWS
+                          : query.limit + query.offset;
+        root = std::make_unique<Sort>(std::move(root), std::move(sort_keys), keep, scan_pool());
+    }
+    if (query.limit != NO_LIMIT || query.offset > 0)
+        root = std::make_unique<Limit>(std::move(root), query.limit, query.offset);
+    if (query.select_all)
+        return root;
+
+    std::vector<std::string> names;
+    for (const auto &item : query.items)
+        names.push_back(item.name);
+    return std::make_unique<Project>(std::move(root), std::move(item_slots), std::move(names));
+}
+
+ResultCursor Database::open_query(const SelectQuery &query)
+{
+    std::vector<std::shared_lock<std::shared_mutex>> latches;
+    std::string plan_line;
+    std::shared_ptr<Operator> root = plan_query(query, latches, plan_line);
+    size_t rows = root->row_count();
+    std::vector<ResultColumn> columns = root->columns();
+    ResultCursor::Source source = [root](RowBatch &batch, size_t max_rows)
+    { root->next(batch, max_rows); };
+    return ResultCursor(std::move(columns), plan_line, rows, std::move(source), std::move(latches));
+}
+
+ResultCursor Database::open_select(const std::string &table_name,
+                                  const std::vector<Condition> &conditions,
+                                  const std::vector<std::string> &selected_columns,
+                                  bool select_all)
+{
+    SelectQuery query;
+    query.table = table_name;
+    query.where = conditions;
+    query.select_all = select_all;
+    for (const auto &col_name : selected_columns)
+        query.items.push_back({col_name, false, AggregateFunction::COUNT, col_name});
+    return open_query(query);
+}
+
+void Database::select(const SelectQuery &query)
+{
+    ResultCursor cursor = open_query(query);
+    std::lock_guard<std::mutex> lock(output_mutex);
+    print_result(cursor, std::cout);
+}
+
+void Database::explain(const SelectQuery &query)
+{
+    std::vector<std::shared_lock<std::shared_mutex>> latches;
+    std::string plan_line;
+    std::unique_ptr<Operator> root = plan_query(query, latches, plan_line);
+    std::string text = "\n" + plan_line + "\n" + root->explain();
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cout << text;
 }
 
 void Database::select(const std::string &table_name,
@@ -614,115 +1590,180 @@ void Database::select(const std::string &table_name,
             const std::vector<std::string> &selected_columns,
             bool select_all)
 {
-    auto &table = *tables[table_name];
-    if (!select_all)
-    {
-        // Safety: ensure all requested columns exist
-        for (auto &col_name : selected_columns)
-        {
-            if (get_col_index(table_name, col_name) == -1)
-            {
-                throw std::runtime_error("Invalid column in SELECT: " + col_name);
-            }
-        }
-    }
-    std::vector<int> result_rows = find_matching_rows(table, conditions);
+    ResultCursor cursor = open_select(table_name, conditions, selected_columns, select_all);
+    std::lock_guard<std::mutex> lock(output_mutex);
+    print_result(cursor, std::cout);
+}
 
-    // In Database::select method - replace the output section with:
-    std::vector<size_t> col_widths;
+// ------------------- Durability -------------------
+uint64_t Database::log_change(const std::string &record)
+{
+    return wal->append(record);
+}
+
+void Database::commit_change(uint64_t lsn)
+{
+    if (wal && lsn > 0)
+        wal->commit(lsn);
+}
 
-    // Calculate column widths
-    if (select_all)
+void Database::apply_change(const std::string &record)
+{
+    BinaryReader in(record.data(), record.size());
+    WalOp op = in.get<WalOp>();
+    std::string table_name = in.get_string();
+    switch (op)
     {
-        for (const auto &col : table.columns)
+    case WalOp::CREATE_TABLE:
+    {
+        auto layout = static_cast<StorageLayout>(in.get<uint8_t>());
+        std::vector<Column> columns(in.get<uint32_t>());
+        for (auto &col : columns)
         {
-            size_t width = col.name.length() + (col.indexed ? 1 : 0); // Account for *
-            for (const auto &row : table.rows)
-            {
-                std::stringstream ss;
-                ss << row[get_col_index(table.name, col.name)];
-                width = std::max(width, ss.str().length());
-            }
-            col_widths.push_back(width + 2); // Add padding
+            col.name = in.get_string();
+            col.type = in.get_string();
+            col.indexed = in.get<uint8_t>();
         }
+        std::vector<std::string> primary_key(in.get<uint32_t>());
+        for (auto &key : primary_key)
+            key = in.get_string();
+        create_table(table_name, columns, layout, primary_key);
+        break;
     }
-    else
+    case WalOp::CREATE_INDEX:
     {
-        for (const auto &col_name : selected_columns)
-        {
-            size_t width = col_name.length();
-            int col_idx = get_col_index(table.name, col_name);
-            if (col_idx != -1)
-            {
-                for (const auto &row : table.rows)
-                {
-                    std::stringstream ss;
-                    ss << row[col_idx];
-                    width = std::max(width, ss.str().length());
-                }
-            }
-            col_widths.push_back(width + 2); // Add padding
-        }
+        std::string index_name = in.get_string();
+        std::string column_name = in.get_string();
+        auto kind = static_cast<IndexKind>(in.get<uint8_t>());
+        create_index(index_name, table_name, column_name, kind);
+        break;
     }
-
-    // Print headers
-    std::cout << "\nResults (" << result_rows.size() << " rows):\n";
-    if (select_all)
+    case WalOp::INSERT:
     {
-        for (size_t i = 0; i < table.columns.size(); i++)
+        std::vector<std::vector<Value>> rows(in.get<uint64_t>());
+        for (auto &row : rows)
         {
-            std::cout << std::left << std::setw(col_widths[i])
-                      << table.columns[i].name + (table.columns[i].indexed ? "*" : "");
+            row.resize(in.get<uint32_t>());
+            for (auto &val : row)
+                val = in.get_value();
         }
+        insert_many(table_name, rows);
+        break;
     }
-    else
+    case WalOp::UPDATE:
     {
-        for (size_t i = 0; i < selected_columns.size(); i++)
+        std::vector<std::pair<std::string, Value>> updates(in.get<uint32_t>());
+        for (auto &update : updates)
         {
-            std::cout << std::left << std::setw(col_widths[i]) << selected_columns[i];
+            update.first = in.get_string();
+            update.second = in.get_value();
         }
+        update(table_name, updates, get_conditions(in));
+        break;
+    }
+    case WalOp::DELETE:
+        delete_rows(table_name, get_conditions(in));
+        break;
+    case WalOp::VACUUM:
+    {
+        // Quietly, unlike the VACUUM statement
+        auto &table = table_named(table_name);
+        std::unique_lock<std::shared_mutex> latch(table.latch);
+        compact_table(table);
+        break;
+    }
+    default:
+        throw std::runtime_error("Unknown log record");
+    }
+}
+
+void Database::open(const std::string &directory)
+{
+    if (wal || !tables.empty())
+        throw std::runtime_error("A database can only be opened while empty");
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+        throw std::runtime_error("Cannot create " + directory + ": " + std::strerror(errno));
+    auto start = std::chrono::steady_clock::now();
+
+    // PAGED tables spill next to the log rather than into /tmp
+    buffer_pool->set_directory(directory);
+    CheckpointContents snapshot = load_checkpoint(directory + "/" + CHECKPOINT_FILE, *buffer_pool);
+    size_t loaded_rows = 0;
+    for (auto &table : snapshot.tables)
+    {
+        loaded_rows += table->row_count();
+        std::string name = table->name;
+        tables.emplace(name, std::move(table));
     }
-    std::cout << "\n"
-              << std::string(std::accumulate(col_widths.begin(), col_widths.end(), 0), '-') << "\n";
 
-    // Print rows
-    for (int idx : result_rows)
+    // A log older than the checkpoint was cut short by a crash before it
+    // could restart, and the checkpoint already holds all of it
+    std::string log_path = directory + "/" + WAL_FILE;
+    WalContents log = WriteAheadLog::scan(log_path);
+    bool current = log.valid_bytes > 0 && log.generation == snapshot.wal_generation;
+    if (log.valid_bytes > 0 && log.generation > snapshot.wal_generation)
+        throw std::runtime_error("Log " + log_path + " is newer than the checkpoint");
+    if (current)
     {
-        if (select_all)
+        for (size_t i = 0; i < log.records.size(); i++)
         {
-            for (size_t i = 0; i < table.columns.size(); i++)
+            try
             {
-                std::cout << std::left << std::setw(col_widths[i]) << table.rows[idx][i];
+                apply_change(log.records[i]);
             }
-        }
-        else
-        {
-            for (size_t i = 0; i < selected_columns.size(); i++)
+            catch (const std::exception &e)
             {
-                int col_idx = get_col_index(table.name, selected_columns[i]);
-                if (col_idx != -1)
-                {
-                    std::cout << std::left << std::setw(col_widths[i]) << table.rows[idx][col_idx];
-                }
+                throw std::runtime_error("Cannot replay log record " + std::to_string(i) + ": " + e.what());
             }
         }
-        std::cout << "\n";
     }
+    wal = std::make_unique<WriteAheadLog>(log_path, snapshot.wal_generation, current ? log.valid_bytes : 0);
+    data_dir = directory;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Opened " << directory << ": " << tables.size() << " tables, "
+              << loaded_rows << " rows from checkpoint, "
+              << (current ? log.records.size() : 0) << " log records replayed"
+              << (log.torn ? " (torn tail dropped)" : "") << " in " << ms << " ms\n";
 }
 
-std::ostream &operator<<(std::ostream &os, const Value &val)
+void Database::checkpoint()
 {
-    if (std::holds_alternative<int>(val))
-    {
-        os << std::get<int>(val);
-    }
-    else if (std::holds_alternative<float>(val))
+    if (!wal)
+        throw std::runtime_error("CHECKPOINT needs a data directory");
+    auto start = std::chrono::steady_clock::now();
+
+    // Statements log while holding their latch, so with the catalog and
+    // every table latched nothing can reach the log until it restarts
+    std::unique_lock<std::shared_mutex> catalog(catalog_latch);
+    std::vector<const Table *> snapshot;
+    for (const auto &entry : tables)
+        snapshot.push_back(entry.second.get());
+    std::sort(snapshot.begin(), snapshot.end());
+    std::vector<std::shared_lock<std::shared_mutex>> latches;
+    size_t rows = 0;
+    for (const Table *table : snapshot)
     {
-        os << std::get<float>(val);
+        latches.emplace_back(table->latch);
+        rows += table->row_count();
     }
+
+    uint64_t generation = wal->generation() + 1;
+    size_t bytes = write_checkpoint(data_dir + "/" + CHECKPOINT_FILE, snapshot, generation);
+    wal->restart(generation);
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Checkpoint: " << snapshot.size() << " tables, " << rows << " rows, "
+              << bytes << " bytes in " << ms << " ms\n";
+}
+
+void Database::set_wal_sync(unsigned milliseconds)
+{
+    if (!wal)
+        throw std::runtime_error("WAL_SYNC_MS needs a data directory");
+    wal->set_sync_interval(milliseconds);
+    if (milliseconds == 0)
+        std::cout << "WAL sync: every commit\n";
     else
-    {
-        os << std::get<std::string>(val);
-    }
-    return os;
-}
\ No newline at end of file
+        std::cout << "WAL sync: every " << milliseconds << " ms\n";
+}
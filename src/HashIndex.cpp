@@ -0,0 +1,192 @@
+#include "HashIndex.h"
+#include <algorithm>
+
+size_t HashIndex::probe(int64_t key) const
+{
+    size_t mask = slots.size() - 1;
+    size_t i = home(key);
+    while (slots[i].row != EMPTY && slots[i].key != key)
+        i = (i + 1) & mask;
+    return i;
+}
+
+void HashIndex::place(const Slot &slot)
+{
+    size_t mask = slots.size() - 1;
+    size_t i = home(slot.key);
+    while (slots[i].row != EMPTY)
+        i = (i + 1) & mask;
+    slots[i] = slot;
+}
+
+void HashIndex::grow(size_t capacity)
+{
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    for (const Slot &slot : old)
+    {
+        if (slot.row != EMPTY)
+            place(slot);
+    }
+}
+
+void HashIndex::add_to_list(int32_t list, int32_t row)
+{
+    if (position.size() <= size_t(row))
+        position.resize(std::max(position.size() * 2, size_t(row) + 1));
+    position[row] = lists[list].size();
+    lists[list].push_back(row);
+}
+
+void HashIndex::insert(int64_t key, int32_t row)
+{
+    if ((keys + 1) * 2 > slots.size())
+        grow(std::max(MIN_CAPACITY, slots.size() * 2));
+    count++;
+    Slot &slot = slots[probe(key)];
+    if (slot.row == EMPTY)
+    {
+        slot = {key, row, -1};
+        keys++;
+        return;
+    }
+    if (slot.row != LISTED)
+    {
+        // A second row: move the key to a posting list
+        if (free_lists.empty())
+        {
+            free_lists.push_back(lists.size());
+            lists.emplace_back();
+        }
+        slot.list = free_lists.back();
+        free_lists.pop_back();
+        add_to_list(slot.list, slot.row);
+        slot.row = LISTED;
+    }
+    add_to_list(slot.list, row);
+}
+
+void HashIndex::remove(int64_t key, int32_t row)
+{
+    if (slots.empty())
+        return;
+    size_t i = probe(key);
+    Slot &slot = slots[i];
+    if (slot.row == EMPTY)
+        return;
+    if (slot.row != LISTED)
+    {
+        if (slot.row != row)
+            return;
+        erase_slot(i);
+        count--;
+        return;
+    }
+
+    // Swap the row with the list's last and pop it. A row indexed under
+    // two keys at once has the position of the later one, so a stale
+    // position falls back to searching the list.
+    std::vector<int32_t> &rows = lists[slot.list];
+    size_t at = size_t(row) < position.size() ? position[row] : rows.size();
+    if (at >= rows.size() || rows[at] != row)
+        at = std::find(rows.begin(), rows.end(), row) - rows.begin();
+    if (at == rows.size())
+        return;
+    int32_t last = rows.back();
+    rows[at] = last;
+    position[last] = at;
+    rows.pop_back();
+    count--;
+    if (rows.size() > 1)
+        return;
+
+    // Back to one row: it goes back into the slot
+    slot.row = rows[0];
+    rows.clear();
+    rows.shrink_to_fit();
+    free_lists.push_back(slot.list);
+    slot.list = -1;
+}
+
+void HashIndex::erase_slot(size_t i)
+{
+    // Backward-shift: pull later slots of the run into the hole unless
+    // their home slot lies cyclically after the hole
+    size_t mask = slots.size() - 1;
+    for (size_t j = (i + 1) & mask; slots[j].row != EMPTY; j = (j + 1) & mask)
+    {
+        size_t h = home(slots[j].key);
+        bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+        if (!stays)
+        {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i].row = EMPTY;
+    slots[i].list = -1;
+    keys--;
+}
+
+bool HashIndex::find(int64_t key, int &row) const
+{
+    if (slots.empty())
+        return false;
+    const Slot &slot = slots[probe(key)];
+    if (slot.row == EMPTY)
+        return false;
+    row = slot.row == LISTED ? lists[slot.list][0] : slot.row;
+    return true;
+}
+
+std::vector<int> HashIndex::lookup(int64_t key) const
+{
+    std::vector<int> rows;
+    if (slots.empty())
+        return rows;
+    const Slot &slot = slots[probe(key)];
+    if (slot.row == LISTED)
+    {
+        rows.assign(lists[slot.list].begin(), lists[slot.list].end());
+        std::sort(rows.begin(), rows.end());
+    }
+    else if (slot.row != EMPTY)
+    {
+        rows.push_back(slot.row);
+    }
+    return rows;
+}
+
+void HashIndex::reset(size_t entries)
+{
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < entries * 2)
+        capacity *= 2;
+    slots.assign(capacity, Slot());
+    lists.clear();
+    free_lists.clear();
+    position.clear();
+    keys = 0;
+    count = 0;
+}
+
+HashIndexStats HashIndex::stats() const
+{
+    HashIndexStats out;
+    out.entries = count;
+    out.keys = keys;
+    out.capacity = slots.size();
+    out.reserved_bytes = slots.capacity() * sizeof(Slot) + position.capacity() * sizeof(uint32_t);
+    for (const auto &list : lists)
+        out.reserved_bytes += list.capacity() * sizeof(int32_t);
+    if (slots.empty())
+        return out;
+    out.load = double(keys) / slots.size();
+    size_t mask = slots.size() - 1;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i].row != EMPTY)
+            out.max_probe = std::max(out.max_probe, (i - home(slots[i].key)) & mask);
+    }
+    return out;
+}
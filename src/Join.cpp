@@ -0,0 +1,539 @@
+#include "Join.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+static inline uint64_t mix_hash(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline uint64_t hash_key(int64_t key)
+{
+    return mix_hash(static_cast<uint64_t>(key));
+}
+
+static inline uint64_t hash_key(double key)
+{
+    if (key == 0.0)
+        key = 0.0; // -0.0 and 0.0 are equal, so they must hash alike
+    uint64_t bits;
+    std::memcpy(&bits, &key, sizeof(bits));
+    return mix_hash(bits);
+}
+
+static inline uint64_t hash_key(std::string_view key)
+{
+    return mix_hash(std::hash<std::string_view>{}(key));
+}
+
+// Join keys of input rows [begin, end), written to out[begin, end)
+template <typename Key>
+static void extract_key_range(const JoinInput &input, size_t begin, size_t end, Key *out);
+
+template <>
+void extract_key_range<int64_t>(const JoinInput &input, size_t begin, size_t end, int64_t *out)
+{
+    const Table &table = *input.table;
+    const std::vector<int> &rows = *input.rows;
+    if (table.layout == StorageLayout::COLUMNAR)
+    {
+        const ColumnVector &cv = table.column_data[input.column];
+        for (size_t i = begin; i < end; i++)
+            out[i] = cv.ints[rows[i]];
+        return;
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        Value paged_cell;
+        if (table.layout == StorageLayout::PAGED)
+            paged_cell = table.get_value(rows[i], input.column);
+        const Value &cell = table.layout == StorageLayout::PAGED ? paged_cell : table.rows[rows[i]][input.column];
+        out[i] = std::holds_alternative<int>(cell) ? std::get<int>(cell)
+                                                   : static_cast<int64_t>(std::get<float>(cell));
+    }
+}
+
+template <>
+void extract_key_range<double>(const JoinInput &input, size_t begin, size_t end, double *out)
+{
+    const Table &table = *input.table;
+    const std::vector<int> &rows = *input.rows;
+    if (table.layout == StorageLayout::COLUMNAR)
+    {
+        const ColumnVector &cv = table.column_data[input.column];
+        for (size_t i = begin; i < end; i++)
+            out[i] = cv.type == ColumnType::INT ? double(cv.ints[rows[i]]) : double(cv.floats[rows[i]]);
+        return;
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        Value paged_cell;
+        if (table.layout == StorageLayout::PAGED)
+            paged_cell = table.get_value(rows[i], input.column);
+        const Value &cell = table.layout == StorageLayout::PAGED ? paged_cell : table.rows[rows[i]][input.column];
+        out[i] = std::holds_alternative<int>(cell) ? double(std::get<int>(cell)) : double(std::get<float>(cell));
+    }
+}
+
+template <>
+void extract_key_range<std::string_view>(const JoinInput &input, size_t begin, size_t end, std::string_view *out)
+{
+    const Table &table = *input.table;
+    const std::vector<int> &rows = *input.rows;
+    if (input.strings)
+    {
+        for (size_t i = begin; i < end; i++)
+            out[i] = (*input.strings)[i];
+        return;
+    }
+    if (table.layout == StorageLayout::COLUMNAR)
+    {
+        const ColumnVector &cv = table.column_data[input.column];
+        for (size_t i = begin; i < end; i++)
+            out[i] = cv.get_string(rows[i]);
+        return;
+    }
+    for (size_t i = begin; i < end; i++)
+        out[i] = std::get<std::string>(table.rows[rows[i]][input.column]);
+}
+
+// A numeric input without the rows whose key cell holds no number: a
+// COLUMNAR cell that did not convert, or a string in a ROW or PAGED table.
+// Those join nothing, so they are dropped before the keys are read. The
+// input is returned as is when every row qualifies.
+static JoinInput numeric_key_rows(const JoinInput &input, std::vector<int> &kept)
+{
+    const Table &table = *input.table;
+    const std::vector<int> &rows = *input.rows;
+    auto numeric = [&](int row)
+    {
+        if (table.layout == StorageLayout::COLUMNAR)
+            return table.column_data[input.column].is_valid(row);
+        if (table.layout == StorageLayout::PAGED)
+            return !std::holds_alternative<std::string>(table.get_value(row, input.column));
+        return !std::holds_alternative<std::string>(table.rows[row][input.column]);
+    };
+
+    size_t first_bad = 0;
+    while (first_bad < rows.size() && numeric(rows[first_bad]))
+        first_bad++;
+    if (first_bad == rows.size())
+        return input;
+    kept.assign(rows.begin(), rows.begin() + first_bad);
+    for (size_t i = first_bad + 1; i < rows.size(); i++)
+    {
+        if (numeric(rows[i]))
+            kept.push_back(rows[i]);
+    }
+    JoinInput filtered = input;
+    filtered.rows = &kept;
+    return filtered;
+}
+
+// Join keys of one input, read once into a contiguous array
+template <typename Key>
+static std::vector<Key> extract_keys(const JoinInput &input)
+{
+    std::vector<Key> keys(input.rows->size());
+    extract_key_range<Key>(input, 0, keys.size(), keys.data());
+    return keys;
+}
+
+// Bucket-chained table over the build keys: heads[bucket] is the first
+// build slot, next[slot] the following one, -1 ends a chain.
+template <typename Key>
+static JoinPairs hash_join_keys(const JoinInput &build, const JoinInput &probe, bool build_is_left)
+{
+    JoinPairs pairs;
+    std::vector<Key> build_keys = extract_keys<Key>(build);
+    std::vector<Key> probe_keys = extract_keys<Key>(probe);
+    if (build_keys.empty() || probe_keys.empty())
+        return pairs;
+
+    size_t buckets = 1;
+    while (buckets < build_keys.size() * 2)
+        buckets <<= 1;
+    const uint64_t mask = buckets - 1;
+
+    std::vector<int> heads(buckets, -1);
+    std::vector<int> next(build_keys.size(), -1);
+    std::vector<uint64_t> hashes(build_keys.size());
+
+    // Insert back to front so each chain lists build rows in input order
+    for (size_t i = build_keys.size(); i-- > 0;)
+    {
+        hashes[i] = hash_key(build_keys[i]);
+        size_t bucket = hashes[i] & mask;
+        next[i] = heads[bucket];
+        heads[bucket] = i;
+    }
+
+    const std::vector<int> &build_rows = *build.rows;
+    const std::vector<int> &probe_rows = *probe.rows;
+    for (size_t p = 0; p < probe_keys.size(); p++)
+    {
+        uint64_t h = hash_key(probe_keys[p]);
+        for (int slot = heads[h & mask]; slot != -1; slot = next[slot])
+        {
+            if (hashes[slot] != h || !(build_keys[slot] == probe_keys[p]))
+                continue;
+            if (build_is_left)
+                pairs.emplace_back(build_rows[slot], probe_rows[p]);
+            else
+                pairs.emplace_back(probe_rows[p], build_rows[slot]);
+        }
+    }
+    return pairs;
+}
+
+// One input scattered into 2^bits hash partitions: entries of partition p
+// occupy [offsets[p], offsets[p + 1]) and keep their input order
+template <typename Key>
+struct PartitionedInput
+{
+    std::vector<Key> keys;
+    std::vector<uint64_t> hashes;
+    std::vector<int> rows;
+    std::vector<size_t> offsets;
+};
+
+// Two passes over morsels of the input: hash and count per partition, then
+// scatter to offsets from a partition-major prefix sum of the counts
+template <typename Key>
+static PartitionedInput<Key> partition_input(const JoinInput &input, int bits, ThreadPool &pool)
+{
+    const size_t n = input.rows->size();
+    const size_t partitions = size_t(1) << bits;
+    const size_t morsels = (n + JOIN_MORSEL_ROWS - 1) / JOIN_MORSEL_ROWS;
+    auto partition_of = [bits](uint64_t hash) { return hash >> (64 - bits); };
+
+    std::vector<Key> keys(n);
+    std::vector<uint64_t> hashes(n);
+    std::vector<size_t> counts(morsels * partitions, 0);
+    pool.run(morsels, [&](size_t m, size_t)
+             {
+                 size_t begin = m * JOIN_MORSEL_ROWS;
+                 size_t end = std::min(n, begin + JOIN_MORSEL_ROWS);
+                 extract_key_range<Key>(input, begin, end, keys.data());
+                 size_t *count = &counts[m * partitions];
+                 for (size_t i = begin; i < end; i++)
+                 {
+                     hashes[i] = hash_key(keys[i]);
+                     count[partition_of(hashes[i])]++;
+                 }
+             });
+
+    // counts[m][p] becomes morsel m's first write position in partition p
+    PartitionedInput<Key> out;
+    out.offsets.resize(partitions + 1);
+    size_t total = 0;
+    for (size_t p = 0; p < partitions; p++)
+    {
+        out.offsets[p] = total;
+        for (size_t m = 0; m < morsels; m++)
+        {
+            size_t count = counts[m * partitions + p];
+            counts[m * partitions + p] = total;
+            total += count;
+        }
+    }
+    out.offsets[partitions] = total;
+
+    out.keys.resize(n);
+    out.hashes.resize(n);
+    out.rows.resize(n);
+    pool.run(morsels, [&](size_t m, size_t)
+             {
+                 size_t begin = m * JOIN_MORSEL_ROWS;
+                 size_t end = std::min(n, begin + JOIN_MORSEL_ROWS);
+                 size_t *cursor = &counts[m * partitions];
+                 for (size_t i = begin; i < end; i++)
+                 {
+                     size_t dst = cursor[partition_of(hashes[i])]++;
+                     out.keys[dst] = keys[i];
+                     out.hashes[dst] = hashes[i];
+                     out.rows[dst] = (*input.rows)[i];
+                 }
+             });
+    return out;
+}
+
+// Radix-partitioned hash join: both sides are split on the high hash bits
+// into partitions whose build side fits in cache, then each partition is
+// built and probed as one pool task into its own output vector. Outputs are
+// concatenated in partition order, so no task ever shares a buffer.
+template <typename Key>
+static JoinPairs partitioned_hash_join(const JoinInput &build, const JoinInput &probe, bool build_is_left,
+                                       ThreadPool &pool)
+{
+    if (build.rows->empty() || probe.rows->empty())
+        return {};
+
+    int bits = 1;
+    while (bits < JOIN_MAX_RADIX_BITS && (build.rows->size() >> bits) > JOIN_PARTITION_ROWS)
+        bits++;
+    const size_t partitions = size_t(1) << bits;
+    PartitionedInput<Key> b = partition_input<Key>(build, bits, pool);
+    PartitionedInput<Key> p = partition_input<Key>(probe, bits, pool);
+
+    // Chain tables are reused by whichever participant runs a partition
+    std::vector<std::vector<int>> heads(pool.thread_count());
+    std::vector<std::vector<int>> next(pool.thread_count());
+    std::vector<JoinPairs> outputs(partitions);
+    pool.run(partitions, [&](size_t part, size_t participant)
+             {
+                 const size_t b0 = b.offsets[part];
+                 const size_t b_count = b.offsets[part + 1] - b0;
+                 if (b_count == 0 || p.offsets[part] == p.offsets[part + 1])
+                     return;
+
+                 size_t buckets = 1;
+                 while (buckets < b_count * 2)
+                     buckets <<= 1;
+                 const uint64_t mask = buckets - 1;
+                 std::vector<int> &head = heads[participant];
+                 std::vector<int> &chain = next[participant];
+                 head.assign(buckets, -1);
+                 chain.resize(b_count);
+                 for (size_t i = b_count; i-- > 0;)
+                 {
+                     size_t bucket = b.hashes[b0 + i] & mask;
+                     chain[i] = head[bucket];
+                     head[bucket] = i;
+                 }
+
+                 JoinPairs &pairs = outputs[part];
+                 for (size_t q = p.offsets[part]; q < p.offsets[part + 1]; q++)
+                 {
+                     uint64_t h = p.hashes[q];
+                     for (int slot = head[h & mask]; slot != -1; slot = chain[slot])
+                     {
+                         if (b.hashes[b0 + slot] != h || !(b.keys[b0 + slot] == p.keys[q]))
+                             continue;
+                         if (build_is_left)
+                             pairs.emplace_back(b.rows[b0 + slot], p.rows[q]);
+                         else
+                             pairs.emplace_back(p.rows[q], b.rows[b0 + slot]);
+                     }
+                 }
+             });
+
+    std::vector<size_t> starts(partitions + 1, 0);
+    for (size_t part = 0; part < partitions; part++)
+        starts[part + 1] = starts[part] + outputs[part].size();
+    JoinPairs pairs(starts[partitions]);
+    pool.run(partitions, [&](size_t part, size_t)
+             { std::copy(outputs[part].begin(), outputs[part].end(), pairs.begin() + starts[part]); });
+    return pairs;
+}
+
+bool partitioned_join(const JoinInput &left, const JoinInput &right, const ThreadPool *pool)
+{
+    return pool && pool->thread_count() > 1 && left.rows->size() + right.rows->size() >= PARALLEL_JOIN_MIN_ROWS;
+}
+
+JoinPairs hash_join(const JoinInput &left_input, const JoinInput &right_input, ThreadPool *pool)
+{
+    ColumnType left_type = column_type_of(left_input.table->columns[left_input.column].type);
+    ColumnType right_type = column_type_of(right_input.table->columns[right_input.column].type);
+
+    std::vector<int> left_kept, right_kept;
+    bool numeric = left_type != ColumnType::STRING && right_type != ColumnType::STRING;
+    JoinInput left = numeric ? numeric_key_rows(left_input, left_kept) : left_input;
+    JoinInput right = numeric ? numeric_key_rows(right_input, right_kept) : right_input;
+
+    bool build_is_left = left.rows->size() < right.rows->size();
+    const JoinInput &build = build_is_left ? left : right;
+    const JoinInput &probe = build_is_left ? right : left;
+
+    bool parallel = partitioned_join(left, right, pool);
+
+    if (left_type == ColumnType::STRING || right_type == ColumnType::STRING)
+    {
+        if (left_type != right_type)
+            return {};
+        // Keys are viewed in place, but a PAGED table's page can be evicted
+        // once unpinned, so its keys are copied out first
+        if (left.table->layout == StorageLayout::PAGED || right.table->layout == StorageLayout::PAGED)
+        {
+            std::vector<std::string> build_strings, probe_strings;
+            JoinInput owned_build = build, owned_probe = probe;
+            for (auto [input, strings] : {std::pair{&owned_build, &build_strings}, std::pair{&owned_probe, &probe_strings}})
+            {
+                if (input->table->layout != StorageLayout::PAGED)
+                    continue;
+                strings->reserve(input->rows->size());
+                for (int row : *input->rows)
+                    strings->push_back(std::get<std::string>(input->table->get_value(row, input->column)));
+                input->strings = strings;
+            }
+            return parallel ? partitioned_hash_join<std::string_view>(owned_build, owned_probe, build_is_left, *pool)
+                            : hash_join_keys<std::string_view>(owned_build, owned_probe, build_is_left);
+        }
+        return parallel ? partitioned_hash_join<std::string_view>(build, probe, build_is_left, *pool)
+                        : hash_join_keys<std::string_view>(build, probe, build_is_left);
+    }
+    if (left_type == ColumnType::INT && right_type == ColumnType::INT)
+        return parallel ? partitioned_hash_join<int64_t>(build, probe, build_is_left, *pool)
+                        : hash_join_keys<int64_t>(build, probe, build_is_left);
+    return parallel ? partitioned_hash_join<double>(build, probe, build_is_left, *pool)
+                    : hash_join_keys<double>(build, probe, build_is_left);
+}
+
+const char *join_strategy_name(JoinStrategy strategy)
+{
+    switch (strategy)
+    {
+    case JoinStrategy::INDEX_NESTED_LOOP:
+        return "INDEX NESTED LOOP JOIN";
+    case JoinStrategy::MERGE:
+        return "MERGE JOIN";
+    default:
+        return "HASH JOIN";
+    }
+}
+
+bool join_column_indexed(const JoinInput &input)
+{
+    // Only a single INT primary key is probed by value
+    return input.table->int_key() && input.table->key_columns[0] == input.column;
+}
+
+// Rows of an input that is a filtered subset of its table, as a lookup
+// mask; empty when every row takes part
+static std::vector<char> input_mask(const JoinInput &input)
+{
+    std::vector<char> mask;
+    if (input.rows->size() == input.table->row_count())
+        return mask;
+    mask.assign(input.table->slot_count(), 0);
+    for (int row : *input.rows)
+        mask[row] = 1;
+    return mask;
+}
+
+JoinPlan choose_join(const JoinInput &left, const JoinInput &right)
+{
+    JoinPlan plan;
+    bool both_int = column_type_of(left.table->columns[left.column].type) == ColumnType::INT &&
+                    column_type_of(right.table->columns[right.column].type) == ColumnType::INT;
+    bool left_indexed = both_int && join_column_indexed(left);
+    bool right_indexed = both_int && join_column_indexed(right);
+
+    // Rough per-row costs: hashing touches the build side twice (hash and
+    // insert) and the probe side once; an index probe costs a root-to-leaf
+    // descent; a merge walks both leaf chains sequentially.
+    double n_left = left.rows->size();
+    double n_right = right.rows->size();
+    double best = 2 * std::min(n_left, n_right) + std::max(n_left, n_right);
+
+    if (right_indexed)
+    {
+        double cost = n_left * std::log2(double(right.table->row_count()) + 2);
+        if (cost < best)
+        {
+            best = cost;
+            plan.strategy = JoinStrategy::INDEX_NESTED_LOOP;
+            plan.inner_is_right = true;
+        }
+    }
+    if (left_indexed)
+    {
+        double cost = n_right * std::log2(double(left.table->row_count()) + 2);
+        if (cost < best)
+        {
+            best = cost;
+            plan.strategy = JoinStrategy::INDEX_NESTED_LOOP;
+            plan.inner_is_right = false;
+        }
+    }
+    if (left_indexed && right_indexed)
+    {
+        double cost = 0.5 * (left.table->row_count() + right.table->row_count());
+        if (cost < best)
+        {
+            best = cost;
+            plan.strategy = JoinStrategy::MERGE;
+        }
+    }
+    return plan;
+}
+
+JoinPairs index_nested_loop_join(const JoinInput &left, const JoinInput &right, bool inner_is_right)
+{
+    JoinPairs pairs;
+    std::vector<int> outer_kept;
+    const JoinInput outer = numeric_key_rows(inner_is_right ? left : right, outer_kept);
+    const JoinInput &inner = inner_is_right ? right : left;
+    std::vector<char> inner_mask = input_mask(inner);
+    std::vector<int64_t> outer_keys = extract_keys<int64_t>(outer);
+
+    for (size_t i = 0; i < outer_keys.size(); i++)
+    {
+        int key = static_cast<int>(outer_keys[i]);
+        int inner_row;
+        if (key != outer_keys[i] || !inner.table->index.find(key, inner_row))
+            continue;
+        if (!inner_mask.empty() && !inner_mask[inner_row])
+            continue;
+        int outer_row = (*outer.rows)[i];
+        if (inner_is_right)
+            pairs.emplace_back(outer_row, inner_row);
+        else
+            pairs.emplace_back(inner_row, outer_row);
+    }
+    return pairs;
+}
+
+JoinPairs merge_join(const JoinInput &left, const JoinInput &right)
+{
+    JoinPairs pairs;
+    std::vector<char> left_mask = input_mask(left);
+    std::vector<char> right_mask = input_mask(right);
+
+    // Both sides are unique primary keys, so each key matches at most once
+    BPlusTree::Cursor l = left.table->index.begin();
+    BPlusTree::Cursor r = right.table->index.begin();
+    while (l.valid() && r.valid())
+    {
+        if (l.key() < r.key())
+        {
+            l.next();
+        }
+        else if (r.key() < l.key())
+        {
+            r.next();
+        }
+        else
+        {
+            int left_row = l.value();
+            int right_row = r.value();
+            if ((left_mask.empty() || left_mask[left_row]) && (right_mask.empty() || right_mask[right_row]))
+                pairs.emplace_back(left_row, right_row);
+            l.next();
+            r.next();
+        }
+    }
+    return pairs;
+}
+
+JoinPairs execute_join(const JoinPlan &plan, const JoinInput &left, const JoinInput &right, ThreadPool *pool)
+{
+    switch (plan.strategy)
+    {
+    case JoinStrategy::INDEX_NESTED_LOOP:
+        return index_nested_loop_join(left, right, plan.inner_is_right);
+    case JoinStrategy::MERGE:
+        return merge_join(left, right);
+    default:
+        return hash_join(left, right, pool);
+    }
+}
@@ -0,0 +1,831 @@
+#include "Operator.h"
+#include "BinaryCodec.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <unordered_map>
+
+std::string Operator::explain(int depth) const
+{
+    std::string out = std::string(2 * depth, ' ') + describe() + "\n";
+    for (const Operator *input : inputs)
+        out += input->explain(depth + 1);
+    return out;
+}
+
+// Three-way comparison of two values; numbers compare numerically across
+// INT and FLOAT, strings byte-wise, and a number sorts before a string
+static int compare_values(const Value &lhs, const Value &rhs)
+{
+    const std::string *ls = std::get_if<std::string>(&lhs);
+    const std::string *rs = std::get_if<std::string>(&rhs);
+    if (ls && rs)
+    {
+        int order = ls->compare(*rs);
+        return (order > 0) - (order < 0);
+    }
+    if (ls || rs)
+        return ls ? 1 : -1;
+    if (std::holds_alternative<int>(lhs) && std::holds_alternative<int>(rhs))
+    {
+        int a = std::get<int>(lhs), b = std::get<int>(rhs);
+        return (a > b) - (a < b);
+    }
+    double a = std::holds_alternative<int>(lhs) ? std::get<int>(lhs) : std::get<float>(lhs);
+    double b = std::holds_alternative<int>(rhs) ? std::get<int>(rhs) : std::get<float>(rhs);
+    return (a > b) - (a < b);
+}
+
+// ------------------- Scans -------------------
+// Split [0, n) into morsels, filter each on the pool into its own
+// selection vector, and concatenate those in morsel order so the result
+// matches a sequential pass
+template <typename Fn>
+static std::vector<int> collect_morsels(ThreadPool &pool, size_t n, size_t morsel_rows, Fn filter)
+{
+    size_t morsels = (n + morsel_rows - 1) / morsel_rows;
+    std::vector<std::vector<int>> parts(morsels);
+    pool.run(morsels, [&](size_t m, size_t)
+             { filter(m * morsel_rows, std::min(n, (m + 1) * morsel_rows), parts[m]); });
+
+    if (morsels == 1)
+        return std::move(parts[0]);
+    size_t total = 0;
+    for (const auto &part : parts)
+        total += part.size();
+    std::vector<int> out;
+    out.reserve(total);
+    for (const auto &part : parts)
+        out.insert(out.end(), part.begin(), part.end());
+    return out;
+}
+
+ScanOperator::ScanOperator(const Table &table, std::vector<int> fetch) : source(table), fetch(std::move(fetch))
+{
+    bool all = this->fetch.size() == table.columns.size();
+    for (size_t i = 0; i < this->fetch.size(); i++)
+    {
+        const Column &col = table.columns[this->fetch[i]];
+        output.push_back({col.name, column_type_of(col.type), col.indexed});
+        all = all && this->fetch[i] == int(i);
+    }
+    // A PAGED record decodes whole, so fetch it once rather than per column
+    whole_rows = all && table.layout == StorageLayout::PAGED;
+}
+
+void ScanOperator::fill(RowBatch &batch, size_t max_rows)
+{
+    for (; pos < rows.size() && batch.size < max_rows; pos++)
+    {
+        std::vector<Value> &row = batch.add_row(fetch.size());
+        if (whole_rows)
+        {
+            row = source.get_row(rows[pos]);
+            continue;
+        }
+        for (size_t i = 0; i < fetch.size(); i++)
+            row[i] = source.get_value(rows[pos], fetch[i]);
+    }
+}
+
+TableScan::TableScan(const Table &table, std::vector<int> fetch, const Predicate &pred,
+                     ThreadPool &pool, size_t morsel_rows)
+    : ScanOperator(table, std::move(fetch)), filtered(!pred.empty())
+{
+    // Columnar tables filter whole blocks into selection bitmaps. Morsels
+    // and blocks start on word boundaries, so tombstones are masked out
+    // word by word.
+    bool columnar = table.layout == StorageLayout::COLUMNAR && filtered;
+    rows = collect_morsels(pool, table.slot_count(), morsel_rows,
+                           [&](size_t begin, size_t end, std::vector<int> &out)
+                           {
+                               if (!columnar)
+                               {
+                                   for (size_t i = begin; i < end; i++)
+                                   {
+                                       if (table.is_live(i) && pred.matches(table, i))
+                                           out.push_back(i);
+                                   }
+                                   return;
+                               }
+
+                               uint64_t bits[Predicate::BLOCK_ROWS / 64];
+                               for (size_t start = begin; start < end; start += Predicate::BLOCK_ROWS)
+                               {
+                                   size_t count = std::min(Predicate::BLOCK_ROWS, end - start);
+                                   pred.filter_block(table, start, count, bits);
+                                   for (size_t w = 0; w < (count + 63) / 64; w++)
+                                   {
+                                       for (uint64_t word = bits[w] & table.live[start / 64 + w]; word; word &= word - 1)
+                                           out.push_back(start + w * 64 + __builtin_ctzll(word));
+                                   }
+                               }
+                           });
+}
+
+std::string TableScan::describe() const
+{
+    return "TableScan " + source.name + (filtered ? " (filtered)" : "");
+}
+
+IndexScan::IndexScan(const Table &table, std::vector<int> fetch, const AccessPath &path,
+                     const Predicate &residual, ThreadPool &pool, size_t morsel_rows)
+    : ScanOperator(table, std::move(fetch)), path_text(path.describe())
+{
+    if (path.type == AccessPathType::EMPTY)
+        return;
+
+    std::vector<int> candidates;
+    if (path.secondary)
+    {
+        candidates = path.secondary->lookup(path.secondary_min, path.secondary_max);
+    }
+    else if (path.key_bytes && path.type == AccessPathType::INDEX_POINT)
+    {
+        candidates = table.key_index.search(path.key_min);
+    }
+    else if (path.key_bytes)
+    {
+        for (auto it = table.key_index.lower_bound(path.key_min);
+             it.valid() && (path.key_max.empty() || it.key() < path.key_max); it.next())
+            candidates.push_back(it.value());
+        std::sort(candidates.begin(), candidates.end());
+    }
+    else if (path.type == AccessPathType::INDEX_POINT)
+    {
+        candidates = table.index.search(path.min_key);
+    }
+    else
+    {
+        candidates = table.index.range_search(path.min_key, path.max_key);
+        // Hand rows back in storage order, same as a full scan would
+        std::sort(candidates.begin(), candidates.end());
+    }
+
+    if (residual.empty())
+    {
+        rows = std::move(candidates);
+        return;
+    }
+    rows = collect_morsels(pool, candidates.size(), morsel_rows,
+                           [&](size_t begin, size_t end, std::vector<int> &out)
+                           {
+                               for (size_t i = begin; i < end; i++)
+                               {
+                                   if (residual.matches(table, candidates[i]))
+                                       out.push_back(candidates[i]);
+                               }
+                           });
+}
+
+std::string IndexScan::describe() const
+{
+    return "IndexScan " + source.name + ": " + path_text;
+}
+
+OrderedIndexScan::OrderedIndexScan(const Table &table, std::vector<int> fetch, const AccessPath &path,
+                                   const Predicate &residual)
+    : source(table), fetch(std::move(fetch)), residual(residual), path_text(path.describe())
+{
+    bool all = this->fetch.size() == table.columns.size();
+    for (size_t i = 0; i < this->fetch.size(); i++)
+    {
+        const Column &col = table.columns[this->fetch[i]];
+        output.push_back({col.name, column_type_of(col.type), col.indexed});
+        all = all && this->fetch[i] == int(i);
+    }
+    whole_rows = all && table.layout == StorageLayout::PAGED;
+    finished = path.type == AccessPathType::EMPTY;
+    whole_table = path.type == AccessPathType::FULL_SCAN && residual.empty();
+    if (table.int_key())
+    {
+        bool bounded = path.type != AccessPathType::FULL_SCAN;
+        int_cursor = bounded ? table.index.lower_bound(path.min_key) : table.index.begin();
+        max_key = bounded ? path.max_key : INT_MAX;
+    }
+    else
+    {
+        bytes_cursor = path.key_bytes ? table.key_index.lower_bound(path.key_min) : table.key_index.begin();
+        key_max = path.key_bytes ? path.key_max : "";
+        point = path.key_bytes && path.type == AccessPathType::INDEX_POINT;
+        if (point)
+            key_max = path.key_min;
+    }
+}
+
+void OrderedIndexScan::fill(RowBatch &batch, size_t max_rows)
+{
+    while (!finished && batch.size < max_rows)
+    {
+        int row;
+        if (int_cursor)
+        {
+            finished = !int_cursor->valid() || int_cursor->key() > max_key;
+            if (finished)
+                break;
+            row = int_cursor->value();
+            int_cursor->next();
+        }
+        else
+        {
+            // A point key ends with itself; a range before key_max, if set
+            finished = !bytes_cursor->valid() ||
+                       (point ? bytes_cursor->key() != key_max
+                              : !key_max.empty() && bytes_cursor->key() >= key_max);
+            if (finished)
+                break;
+            row = bytes_cursor->value();
+            bytes_cursor->next();
+        }
+        if (!residual.matches(source, row))
+            continue;
+
+        std::vector<Value> &out = batch.add_row(fetch.size());
+        emitted++;
+        if (whole_rows)
+        {
+            out = source.get_row(row);
+            continue;
+        }
+        for (size_t i = 0; i < fetch.size(); i++)
+            out[i] = source.get_value(row, fetch[i]);
+    }
+}
+
+size_t OrderedIndexScan::row_count() const
+{
+    return whole_table ? source.row_count() - emitted : UNKNOWN_ROWS;
+}
+
+std::string OrderedIndexScan::describe() const
+{
+    return "OrderedIndexScan " + source.name + ": " + path_text;
+}
+
+// ------------------- Filter -------------------
+Filter::Filter(OperatorPtr input, std::vector<FilterCondition> conditions)
+    : child(std::move(input)), conditions(std::move(conditions))
+{
+    output = child->columns();
+    inputs.push_back(child.get());
+    for (const FilterCondition &cond : this->conditions)
+    {
+        compiled.emplace_back();
+        convertible.push_back(
+            compile_condition(cond.column, output[cond.column].type, cond.op, cond.value, compiled.back()));
+    }
+}
+
+bool Filter::passes(const std::vector<Value> &row) const
+{
+    // Conjunctions separated by OR: the row passes once one holds in full
+    bool group = true;
+    for (size_t i = 0; i < conditions.size(); i++)
+    {
+        const FilterCondition &cond = conditions[i];
+        if (i > 0 && cond.or_before)
+        {
+            if (group)
+                return true;
+            group = true;
+        }
+        if (!group)
+            continue;
+        group = convertible[i] && condition_matches(compiled[i], row[cond.column]);
+    }
+    return group;
+}
+
+void Filter::fill(RowBatch &batch, size_t max_rows)
+{
+    while (batch.size < max_rows)
+    {
+        if (in_pos == in.size)
+        {
+            child->next(in);
+            in_pos = 0;
+            if (in.size == 0)
+                return;
+        }
+        for (; in_pos < in.size && batch.size < max_rows; in_pos++)
+        {
+            // Swapping hands the row over and leaves the batch's spare
+            // vector behind for the input to refill
+            if (passes(in.rows[in_pos]))
+                std::swap(batch.add_row(0), in.rows[in_pos]);
+        }
+    }
+}
+
+std::string Filter::describe() const
+{
+    return "Filter (" + std::to_string(conditions.size()) + " condition" +
+           (conditions.size() == 1 ? ")" : "s)");
+}
+
+// ------------------- Project -------------------
+Project::Project(OperatorPtr input, std::vector<int> columns, std::vector<std::string> names)
+    : child(std::move(input)), picks(std::move(columns))
+{
+    for (size_t i = 0; i < picks.size(); i++)
+        output.push_back({names[i], child->columns()[picks[i]].type});
+    inputs.push_back(child.get());
+}
+
+void Project::fill(RowBatch &batch, size_t max_rows)
+{
+    child->next(in, max_rows);
+    for (size_t r = 0; r < in.size; r++)
+    {
+        std::vector<Value> &from = in.rows[r];
+        std::vector<Value> &row = batch.add_row(picks.size());
+        for (size_t i = 0; i < picks.size(); i++)
+            row[i] = from[picks[i]];
+    }
+}
+
+std::string Project::describe() const
+{
+    std::string out = "Project";
+    for (size_t i = 0; i < output.size(); i++)
+        out += (i == 0 ? " " : ", ") + output[i].name;
+    return out;
+}
+
+// ------------------- EquiJoin -------------------
+EquiJoin::EquiJoin(std::unique_ptr<ScanOperator> left_scan, std::unique_ptr<ScanOperator> right_scan,
+                   int left_column, int right_column, std::vector<JoinColumn> columns, ThreadPool &pool)
+    : left(std::move(left_scan)), right(std::move(right_scan)), picks(std::move(columns))
+{
+    for (const auto &pick : picks)
+    {
+        const Table &table = pick.left ? left->table() : right->table();
+        output.push_back({pick.name, column_type_of(table.columns[pick.column].type)});
+    }
+    inputs.push_back(left.get());
+    inputs.push_back(right.get());
+
+    JoinInput left_input{&left->table(), left_column, &left->row_ids()};
+    JoinInput right_input{&right->table(), right_column, &right->row_ids()};
+    JoinPlan plan = choose_join(left_input, right_input);
+    strategy_text = join_strategy_name(plan.strategy);
+    if (plan.strategy == JoinStrategy::INDEX_NESTED_LOOP)
+        strategy_text += " (probing " + (plan.inner_is_right ? right : left)->table().name + " index)";
+    else if (plan.strategy == JoinStrategy::HASH && partitioned_join(left_input, right_input, &pool))
+        strategy_text += " (radix-partitioned, " + std::to_string(pool.thread_count()) + " threads)";
+    pairs = execute_join(plan, left_input, right_input, &pool);
+}
+
+void EquiJoin::fill(RowBatch &batch, size_t max_rows)
+{
+    for (; pos < pairs.size() && batch.size < max_rows; pos++)
+    {
+        std::vector<Value> &row = batch.add_row(picks.size());
+        for (size_t i = 0; i < picks.size(); i++)
+        {
+            const JoinColumn &pick = picks[i];
+            row[i] = pick.left ? left->table().get_value(pairs[pos].first, pick.column)
+                               : right->table().get_value(pairs[pos].second, pick.column);
+        }
+    }
+}
+
+std::string EquiJoin::describe() const
+{
+    return "EquiJoin: " + strategy_text;
+}
+
+// ------------------- Sort -------------------
+Sort::Sort(OperatorPtr input, std::vector<SortKey> keys, size_t keep, std::shared_ptr<ThreadPool> pool)
+    : child(std::move(input)), keys(std::move(keys)), keep(keep), pool(std::move(pool))
+{
+    output = child->columns();
+    inputs.push_back(child.get());
+}
+
+bool Sort::before(const std::vector<Value> &a, const std::vector<Value> &b) const
+{
+    for (const SortKey &key : keys)
+    {
+        int order = compare_values(a[key.column], b[key.column]);
+        if (order != 0)
+            return key.descending ? order > 0 : order < 0;
+    }
+    return false;
+}
+
+void Sort::top_k()
+{
+    // Max-heap of the best rows so far, worst on top; the input position
+    // breaks ties so equal rows keep their order
+    using Entry = std::pair<size_t, std::vector<Value>>;
+    std::vector<Entry> heap;
+    auto worse = [&](const Entry &a, const Entry &b)
+    {
+        if (before(a.second, b.second))
+            return true;
+        return !before(b.second, a.second) && a.first < b.first;
+    };
+
+    RowBatch in;
+    size_t seen = 0;
+    for (child->next(in); in.size > 0; child->next(in))
+    {
+        for (size_t r = 0; r < in.size; r++, seen++)
+        {
+            if (heap.size() < keep)
+            {
+                heap.push_back({seen, std::move(in.rows[r])});
+                std::push_heap(heap.begin(), heap.end(), worse);
+            }
+            else if (!heap.empty() && before(in.rows[r], heap.front().second))
+            {
+                std::pop_heap(heap.begin(), heap.end(), worse);
+                heap.back() = {seen, std::move(in.rows[r])};
+                std::push_heap(heap.begin(), heap.end(), worse);
+            }
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), worse);
+    sorted.reserve(heap.size());
+    for (auto &entry : heap)
+        sorted.push_back(std::move(entry.second));
+}
+
+// Order-preserving 64-bit image of a number, or of a string's first eight
+// bytes; false if the value is not of the column's kind
+static bool sort_prefix(const Value &val, ColumnType type, uint64_t &out)
+{
+    if (type == ColumnType::STRING)
+    {
+        const std::string *text = std::get_if<std::string>(&val);
+        if (!text)
+            return false;
+        out = 0;
+        for (size_t i = 0; i < 8; i++)
+            out = out << 8 | (i < text->size() ? uint8_t((*text)[i]) : 0);
+        return true;
+    }
+    if (std::holds_alternative<std::string>(val))
+        return false;
+    double num = std::holds_alternative<int>(val) ? std::get<int>(val) : std::get<float>(val);
+    if (num == 0)
+        num = 0; // -0 compares equal to 0
+    uint64_t bits;
+    std::memcpy(&bits, &num, sizeof(bits));
+    out = bits >> 63 ? ~bits : bits | uint64_t(1) << 63;
+    return true;
+}
+
+void Sort::full_sort()
+{
+    std::vector<std::vector<Value>> rows;
+    RowBatch in;
+    for (child->next(in); in.size > 0; child->next(in))
+    {
+        for (size_t r = 0; r < in.size; r++)
+            rows.push_back(std::move(in.rows[r]));
+    }
+
+    // Sort (key prefixes, row) entries in one flat array, so most
+    // comparisons never touch the rows. A number's prefix is exact, so when
+    // the first key is numeric the second key's prefix breaks its ties;
+    // rows are compared only past that, then their input positions, which
+    // keeps the sort stable.
+    struct Entry
+    {
+        uint64_t prefix[2];
+        size_t row;
+    };
+    size_t prefixes = keys.size() == 1 || output[keys[0].column].type == ColumnType::STRING ? 1 : 2;
+    std::vector<Entry> entries(rows.size());
+    for (size_t r = 0; r < rows.size() && prefixes > 0; r++)
+    {
+        entries[r] = {{0, 0}, r};
+        for (size_t k = 0; k < prefixes; k++)
+        {
+            const SortKey &key = keys[k];
+            if (!sort_prefix(rows[r][key.column], output[key.column].type, entries[r].prefix[k]))
+                prefixes = 0; // A value of another kind: compare rows only
+            else if (key.descending)
+                entries[r].prefix[k] = ~entries[r].prefix[k];
+        }
+    }
+    for (size_t r = 0; prefixes == 0 && r < rows.size(); r++)
+        entries[r] = {{0, 0}, r};
+    // Rows settle every tie the prefixes leave, unless the prefixes are exact
+    bool exact = prefixes == keys.size();
+    for (size_t k = 0; k < prefixes; k++)
+        exact = exact && output[keys[k].column].type != ColumnType::STRING;
+    auto less = [&](const Entry &a, const Entry &b)
+    {
+        if (a.prefix[0] != b.prefix[0])
+            return a.prefix[0] < b.prefix[0];
+        if (a.prefix[1] != b.prefix[1])
+            return a.prefix[1] < b.prefix[1];
+        if (!exact && before(rows[a.row], rows[b.row]))
+            return true;
+        return (exact || !before(rows[b.row], rows[a.row])) && a.row < b.row;
+    };
+
+    // Sort equal runs on the pool, then merge neighbours pairwise
+    size_t runs = pool ? std::min(pool->thread_count(), rows.size() / PARALLEL_SORT_MIN_ROWS) : 1;
+    if (runs <= 1)
+    {
+        std::sort(entries.begin(), entries.end(), less);
+    }
+    else
+    {
+        size_t run_rows = (entries.size() + runs - 1) / runs;
+        auto at = [&](size_t offset) { return entries.begin() + std::min(offset, entries.size()); };
+        pool->run(runs, [&](size_t run, size_t)
+                  { std::sort(at(run * run_rows), at((run + 1) * run_rows), less); });
+        for (size_t width = run_rows; width < entries.size(); width *= 2)
+        {
+            size_t merges = (entries.size() + 2 * width - 1) / (2 * width);
+            pool->run(merges, [&](size_t m, size_t)
+                      {
+                          size_t begin = m * 2 * width;
+                          std::inplace_merge(at(begin), at(begin + width), at(begin + 2 * width), less);
+                      });
+        }
+    }
+
+    sorted.reserve(rows.size());
+    for (const Entry &entry : entries)
+        sorted.push_back(std::move(rows[entry.row]));
+}
+
+void Sort::fill(RowBatch &batch, size_t max_rows)
+{
+    if (!done)
+    {
+        if (keep != UNKNOWN_ROWS)
+            top_k();
+        else
+            full_sort();
+        done = true;
+    }
+    for (; pos < sorted.size() && batch.size < max_rows; pos++)
+        std::swap(batch.add_row(0), sorted[pos]);
+}
+
+size_t Sort::row_count() const
+{
+    if (done)
+        return sorted.size() - pos;
+    size_t rows = child->row_count();
+    return rows == UNKNOWN_ROWS ? UNKNOWN_ROWS : std::min(rows, keep);
+}
+
+std::string Sort::describe() const
+{
+    std::string out = keep != UNKNOWN_ROWS ? "Top " + std::to_string(keep) + " by" : "Sort by";
+    for (size_t i = 0; i < keys.size(); i++)
+        out += (i == 0 ? " " : ", ") + output[keys[i].column].name + (keys[i].descending ? " DESC" : "");
+    return out;
+}
+
+// ------------------- Limit -------------------
+Limit::Limit(OperatorPtr input, size_t limit, size_t offset)
+    : child(std::move(input)), limit(limit), offset(offset)
+{
+    output = child->columns();
+    inputs.push_back(child.get());
+}
+
+void Limit::fill(RowBatch &batch, size_t max_rows)
+{
+    if (returned >= limit)
+        return;
+    while (skipped < offset)
+    {
+        child->next(in, std::min(DEFAULT_BATCH_ROWS, offset - skipped));
+        if (in.size == 0)
+            return;
+        skipped += in.size;
+    }
+    child->next(batch, std::min(max_rows, limit - returned));
+    returned += batch.size;
+}
+
+size_t Limit::row_count() const
+{
+    size_t available = child->row_count();
+    if (available == UNKNOWN_ROWS)
+        return UNKNOWN_ROWS;
+    size_t to_skip = offset - skipped;
+    available = available > to_skip ? available - to_skip : 0;
+    return std::min(available, limit - returned);
+}
+
+std::string Limit::describe() const
+{
+    if (limit == UNKNOWN_ROWS)
+        return "Offset " + std::to_string(offset);
+    std::string out = "Limit " + std::to_string(limit);
+    if (offset > 0)
+        out += " offset " + std::to_string(offset);
+    return out;
+}
+
+// ------------------- Aggregate -------------------
+const char *aggregate_name(AggregateFunction function)
+{
+    switch (function)
+    {
+    case AggregateFunction::COUNT:
+        return "COUNT";
+    case AggregateFunction::SUM:
+        return "SUM";
+    case AggregateFunction::MIN:
+        return "MIN";
+    case AggregateFunction::MAX:
+        return "MAX";
+    case AggregateFunction::AVG:
+        return "AVG";
+    }
+    return "?";
+}
+
+Aggregate::Aggregate(OperatorPtr input, std::vector<int> group_columns, std::vector<AggregateSpec> aggregates)
+    : child(std::move(input)), group_columns(std::move(group_columns)), aggregates(std::move(aggregates))
+{
+    const auto &in = child->columns();
+    for (int col : this->group_columns)
+        output.push_back({in[col].name, in[col].type});
+    for (const auto &agg : this->aggregates)
+    {
+        ColumnType type = agg.column == -1 ? ColumnType::INT : in[agg.column].type;
+        if ((agg.function == AggregateFunction::SUM || agg.function == AggregateFunction::AVG) &&
+            type == ColumnType::STRING)
+            throw std::runtime_error(std::string(aggregate_name(agg.function)) + " needs a numeric column: " + agg.name);
+        if (agg.function == AggregateFunction::COUNT)
+            type = ColumnType::INT;
+        else if (agg.function == AggregateFunction::AVG)
+            type = ColumnType::FLOAT;
+        output.push_back({agg.name, type});
+    }
+    inputs.push_back(child.get());
+}
+
+// A COUNT or INT SUM; totals past the int range come out as a FLOAT rather
+// than failing the query
+static Value int64_value(int64_t total)
+{
+    if (total < INT_MIN || total > INT_MAX)
+        return static_cast<float>(total);
+    return static_cast<int>(total);
+}
+
+// Running state of one aggregate in one group
+struct Accumulator
+{
+    int64_t count = 0;
+    int64_t int_sum = 0;
+    double float_sum = 0;
+    Value best; // MIN/MAX so far, once count > 0
+};
+
+void Aggregate::run()
+{
+    struct Group
+    {
+        std::vector<Value> keys;
+        std::vector<Accumulator> accumulators;
+    };
+    std::vector<Group> groups;
+    std::unordered_map<std::string, size_t> group_of;
+    if (group_columns.empty())
+        groups.push_back({{}, std::vector<Accumulator>(aggregates.size())});
+
+    RowBatch in;
+    std::string key;
+    for (child->next(in); in.size > 0; child->next(in))
+    {
+        for (size_t r = 0; r < in.size; r++)
+        {
+            const std::vector<Value> &row = in.rows[r];
+            size_t g = 0;
+            if (!group_columns.empty())
+            {
+                key.clear();
+                BinaryWriter writer(key);
+                for (int col : group_columns)
+                    writer.put_value(row[col]);
+                auto found = group_of.try_emplace(key, groups.size());
+                if (found.second)
+                {
+                    Group group{{}, std::vector<Accumulator>(aggregates.size())};
+                    for (int col : group_columns)
+                        group.keys.push_back(row[col]);
+                    groups.push_back(std::move(group));
+                }
+                g = found.first->second;
+            }
+
+            for (size_t a = 0; a < aggregates.size(); a++)
+            {
+                const AggregateSpec &agg = aggregates[a];
+                Accumulator &acc = groups[g].accumulators[a];
+                if (agg.column == -1)
+                {
+                    acc.count++;
+                    continue;
+                }
+                const Value &val = row[agg.column];
+                switch (agg.function)
+                {
+                case AggregateFunction::COUNT:
+                    break;
+                case AggregateFunction::SUM:
+                case AggregateFunction::AVG:
+                    if (const int *num = std::get_if<int>(&val))
+                        acc.int_sum += *num;
+                    else if (const float *num = std::get_if<float>(&val))
+                        acc.float_sum += *num;
+                    break;
+                case AggregateFunction::MIN:
+                    if (acc.count == 0 || compare_values(val, acc.best) < 0)
+                        acc.best = val;
+                    break;
+                case AggregateFunction::MAX:
+                    if (acc.count == 0 || compare_values(val, acc.best) > 0)
+                        acc.best = val;
+                    break;
+                }
+                acc.count++;
+            }
+        }
+    }
+
+    size_t key_count = group_columns.size();
+    for (auto &group : groups)
+    {
+        std::vector<Value> row = std::move(group.keys);
+        for (size_t a = 0; a < aggregates.size(); a++)
+        {
+            const AggregateSpec &agg = aggregates[a];
+            const Accumulator &acc = group.accumulators[a];
+            ColumnType type = output[key_count + a].type;
+            switch (agg.function)
+            {
+            case AggregateFunction::COUNT:
+                row.push_back(int64_value(acc.count));
+                break;
+            case AggregateFunction::SUM:
+                if (type == ColumnType::INT)
+                    row.push_back(int64_value(acc.int_sum));
+                else
+                    row.emplace_back(static_cast<float>(acc.float_sum));
+                break;
+            case AggregateFunction::AVG:
+                row.emplace_back(acc.count == 0 ? 0.0f
+                                                : static_cast<float>((acc.int_sum + acc.float_sum) / acc.count));
+                break;
+            case AggregateFunction::MIN:
+            case AggregateFunction::MAX:
+                if (acc.count > 0)
+                    row.push_back(acc.best);
+                else if (type == ColumnType::STRING)
+                    row.emplace_back(std::string());
+                else if (type == ColumnType::FLOAT)
+                    row.emplace_back(0.0f);
+                else
+                    row.emplace_back(0);
+                break;
+            }
+        }
+        results.push_back(std::move(row));
+    }
+    done = true;
+}
+
+void Aggregate::fill(RowBatch &batch, size_t max_rows)
+{
+    if (!done)
+        run();
+    for (; pos < results.size() && batch.size < max_rows; pos++)
+        std::swap(batch.add_row(0), results[pos]);
+}
+
+size_t Aggregate::row_count() const
+{
+    if (done)
+        return results.size() - pos;
+    return group_columns.empty() ? 1 : UNKNOWN_ROWS;
+}
+
+std::string Aggregate::describe() const
+{
+    std::string out = "Aggregate";
+    for (size_t i = 0; i < output.size(); i++)
+        out += (i == 0 ? " " : ", ") + output[i].name;
+    if (!group_columns.empty())
+    {
+        out += " group by";
+        for (size_t i = 0; i < group_columns.size(); i++)
+            out += (i == 0 ? " " : ", ") + output[i].name;
+    }
+    return out;
+}
@@ -0,0 +1,310 @@
+#include "Predicate.h"
+#include "SimdKernels.h"
+
+bool parse_compare_op(const std::string &op, CompareOp &out)
+{
+    if (op == "=")
+        out = CompareOp::EQ;
+    else if (op == "!=")
+        out = CompareOp::NE;
+    else if (op == "<")
+        out = CompareOp::LT;
+    else if (op == "<=")
+        out = CompareOp::LE;
+    else if (op == ">")
+        out = CompareOp::GT;
+    else if (op == ">=")
+        out = CompareOp::GE;
+    else
+        return false;
+    return true;
+}
+
+template <typename T>
+static bool compare(T lhs, CompareOp op, T rhs)
+{
+    switch (op)
+    {
+    case CompareOp::EQ:
+        return lhs == rhs;
+    case CompareOp::NE:
+        return lhs != rhs;
+    case CompareOp::LT:
+        return lhs < rhs;
+    case CompareOp::LE:
+        return lhs <= rhs;
+    case CompareOp::GT:
+        return lhs > rhs;
+    case CompareOp::GE:
+        return lhs >= rhs;
+    }
+    return false;
+}
+
+// Float equality is tolerant, ordering is exact
+static bool compare_float(float lhs, CompareOp op, float rhs)
+{
+    if (op == CompareOp::EQ)
+        return std::abs(lhs - rhs) < 1e-6;
+    if (op == CompareOp::NE)
+        return std::abs(lhs - rhs) >= 1e-6;
+    return compare(lhs, op, rhs);
+}
+
+bool compile_condition(int column, ColumnType type, CompareOp op, const Value &val, CompiledCondition &out)
+{
+    out.column = column;
+    out.type = type;
+    out.op = op;
+    try
+    {
+        if (type == ColumnType::INT)
+        {
+            if (std::holds_alternative<int>(val))
+                out.int_value = std::get<int>(val);
+            else if (std::holds_alternative<float>(val))
+                out.int_value = static_cast<int>(std::get<float>(val));
+            else
+                out.int_value = std::stoi(std::get<std::string>(val));
+        }
+        else if (type == ColumnType::FLOAT)
+        {
+            if (std::holds_alternative<int>(val))
+                out.float_value = static_cast<float>(std::get<int>(val));
+            else if (std::holds_alternative<float>(val))
+                out.float_value = std::get<float>(val);
+            else
+                out.float_value = std::stof(std::get<std::string>(val));
+        }
+        else
+        {
+            std::stringstream ss;
+            ss << val;
+            out.string_value = Database::trim(ss.str());
+        }
+    }
+    catch (...)
+    {
+        // Constant does not convert to the column type: nothing can match
+        return false;
+    }
+    return true;
+}
+
+bool condition_matches(const CompiledCondition &cond, const Value &cell)
+{
+    switch (cond.type)
+    {
+    case ColumnType::INT:
+    {
+        const int *num = std::get_if<int>(&cell);
+        return num && compare(*num, cond.op, cond.int_value);
+    }
+    case ColumnType::FLOAT:
+    {
+        if (const float *f = std::get_if<float>(&cell))
+            return compare_float(*f, cond.op, cond.float_value);
+        if (const int *i = std::get_if<int>(&cell))
+            return compare_float(static_cast<float>(*i), cond.op, cond.float_value);
+        return false;
+    }
+    default:
+    {
+        const std::string *str = std::get_if<std::string>(&cell);
+        return str && compare(std::string_view(*str), cond.op, std::string_view(cond.string_value));
+    }
+    }
+}
+
+Predicate Predicate::compile(const Table &table, const std::vector<Condition> &conditions)
+{
+    Predicate pred;
+    if (conditions.empty())
+        return pred;
+
+    // Split on OR into groups of AND-ed conditions
+    std::vector<std::vector<int>> groups(1);
+    for (size_t i = 0; i < conditions.size(); i++)
+    {
+        if (i > 0 && conditions[i].logical_op == "OR")
+            groups.emplace_back();
+        groups.back().push_back(pred.add_leaf(table, conditions[i]));
+    }
+
+    std::vector<int> group_roots;
+    for (auto &group : groups)
+    {
+        if (group.size() == 1)
+        {
+            group_roots.push_back(group[0]);
+            continue;
+        }
+        PredicateNode and_node;
+        and_node.kind = PredicateNode::AND;
+        and_node.children = group;
+        pred.nodes.push_back(and_node);
+        group_roots.push_back(pred.nodes.size() - 1);
+    }
+
+    if (group_roots.size() == 1)
+    {
+        pred.root = group_roots[0];
+    }
+    else
+    {
+        PredicateNode or_node;
+        or_node.kind = PredicateNode::OR;
+        or_node.children = group_roots;
+        pred.nodes.push_back(or_node);
+        pred.root = pred.nodes.size() - 1;
+    }
+    return pred;
+}
+
+int Predicate::add_leaf(const Table &table, const Condition &cond)
+{
+    PredicateNode leaf;
+    leaf.kind = PredicateNode::ALWAYS_FALSE;
+
+    CompiledCondition cc;
+    for (size_t i = 0; i < table.columns.size(); i++)
+    {
+        if (table.columns[i].name == cond.column)
+        {
+            cc.column = i;
+            break;
+        }
+    }
+
+    CompareOp op;
+    if (cc.column != -1 && parse_compare_op(cond.op, op) &&
+        compile_condition(cc.column, column_type_of(table.columns[cc.column].type), op, cond.value, cc))
+    {
+        conditions.push_back(cc);
+        leaf.kind = PredicateNode::LEAF;
+        leaf.condition = conditions.size() - 1;
+    }
+
+    nodes.push_back(leaf);
+    return nodes.size() - 1;
+}
+
+bool Predicate::eval_node(int node_idx, const Table &table, size_t row) const
+{
+    const PredicateNode &node = nodes[node_idx];
+    switch (node.kind)
+    {
+    case PredicateNode::LEAF:
+        return eval_condition(conditions[node.condition], table, row);
+    case PredicateNode::AND:
+        for (int child : node.children)
+        {
+            if (!eval_node(child, table, row))
+                return false;
+        }
+        return true;
+    case PredicateNode::OR:
+        for (int child : node.children)
+        {
+            if (eval_node(child, table, row))
+                return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool Predicate::eval_condition(const CompiledCondition &cond, const Table &table, size_t row)
+{
+    if (table.layout == StorageLayout::COLUMNAR)
+    {
+        const ColumnVector &cv = table.column_data[cond.column];
+        if (!cv.is_valid(row))
+            return false;
+        switch (cond.type)
+        {
+        case ColumnType::INT:
+            return compare(cv.ints[row], cond.op, cond.int_value);
+        case ColumnType::FLOAT:
+            return compare_float(cv.floats[row], cond.op, cond.float_value);
+        default:
+            return compare(cv.get_string(row), cond.op, std::string_view(cond.string_value));
+        }
+    }
+
+    Value paged_cell;
+    if (table.layout == StorageLayout::PAGED)
+        paged_cell = table.get_value(row, cond.column);
+    const Value &cell = table.layout == StorageLayout::PAGED ? paged_cell : table.rows[row][cond.column];
+    return condition_matches(cond, cell);
+}
+
+void Predicate::filter_block(const Table &table, size_t start, size_t count, uint64_t *out) const
+{
+    size_t words = (count + 63) / 64;
+    if (root != -1)
+    {
+        filter_node(root, table, start, count, out);
+        return;
+    }
+
+    std::fill(out, out + words, ~uint64_t(0));
+    if (count % 64)
+        out[words - 1] = (uint64_t(1) << (count % 64)) - 1;
+}
+
+void Predicate::filter_node(int node_idx, const Table &table, size_t start, size_t count,
+                            uint64_t *out) const
+{
+    const PredicateNode &node = nodes[node_idx];
+    size_t words = (count + 63) / 64;
+    switch (node.kind)
+    {
+    case PredicateNode::LEAF:
+        filter_condition(conditions[node.condition], table, start, count, out);
+        return;
+    case PredicateNode::AND:
+    case PredicateNode::OR:
+    {
+        filter_node(node.children[0], table, start, count, out);
+        uint64_t child_bits[BLOCK_ROWS / 64];
+        for (size_t c = 1; c < node.children.size(); c++)
+        {
+            filter_node(node.children[c], table, start, count, child_bits);
+            for (size_t w = 0; w < words; w++)
+                out[w] = node.kind == PredicateNode::AND ? out[w] & child_bits[w] : out[w] | child_bits[w];
+        }
+        return;
+    }
+    default:
+        std::fill(out, out + words, uint64_t(0));
+    }
+}
+
+void Predicate::filter_condition(const CompiledCondition &cond, const Table &table,
+                                 size_t start, size_t count, uint64_t *out)
+{
+    size_t words = (count + 63) / 64;
+    if (table.layout == StorageLayout::COLUMNAR && cond.type != ColumnType::STRING)
+    {
+        const ColumnVector &cv = table.column_data[cond.column];
+        if (cond.type == ColumnType::INT)
+            filter_int32(cv.ints.data() + start, count, cond.op, cond.int_value, out);
+        else
+            filter_float(cv.floats.data() + start, count, cond.op, cond.float_value, out);
+
+        // Cells that failed type conversion never match
+        const uint64_t *valid = cv.validity.data() + start / 64;
+        for (size_t w = 0; w < words; w++)
+            out[w] &= valid[w];
+        return;
+    }
+
+    std::fill(out, out + words, uint64_t(0));
+    for (size_t i = 0; i < count; i++)
+    {
+        if (eval_condition(cond, table, start + i))
+            out[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
@@ -0,0 +1,142 @@
+#include "ResultCursor.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+std::vector<Value> &RowBatch::add_row(size_t columns)
+{
+    if (size == rows.size())
+        rows.emplace_back();
+    std::vector<Value> &row = rows[size++];
+    row.resize(columns);
+    return row;
+}
+
+// ------------------- ResultCursor -------------------
+ResultCursor::ResultCursor(std::vector<ResultColumn> columns, std::string plan, size_t rows, Source source,
+                           std::vector<std::shared_lock<std::shared_mutex>> latches)
+    : result_columns(std::move(columns)), plan_text(std::move(plan)), total_rows(rows),
+      source(std::move(source)), latches(std::move(latches))
+{
+}
+
+bool ResultCursor::next(RowBatch &batch, size_t max_rows)
+{
+    batch.size = 0;
+    if (source && max_rows > 0)
+        source(batch, max_rows);
+    if (batch.size == 0)
+        close();
+    return batch.size > 0;
+}
+
+void ResultCursor::close()
+{
+    source = nullptr;
+    latches.clear();
+}
+
+// ------------------- Printing -------------------
+// Same text as streaming the Value, without a stream per cell
+static void append_value(std::string &out, const Value &val)
+{
+    if (const int *num = std::get_if<int>(&val))
+    {
+        char buffer[16];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), *num);
+        out.append(buffer, result.ptr);
+    }
+    else if (const float *num = std::get_if<float>(&val))
+    {
+        char buffer[32];
+        int length = std::snprintf(buffer, sizeof(buffer), "%g", *num);
+        out.append(buffer, length);
+    }
+    else
+    {
+        out += std::get<std::string>(val);
+    }
+}
+
+// Left-aligned in a column of width plus two spaces
+static void append_cell(std::string &out, std::string_view cell, size_t width)
+{
+    out += cell;
+    out.append(width + 2 - cell.size(), ' ');
+}
+
+void print_result(ResultCursor &cursor, std::ostream &out, size_t window_rows)
+{
+    const auto &columns = cursor.columns();
+    size_t column_count = columns.size();
+    std::vector<size_t> widths;
+    for (const auto &col : columns)
+        widths.push_back(col.name.size() + (col.key ? 1 : 0));
+
+    // Format the first window ahead of the header so it can size the columns
+    size_t total = cursor.row_count();
+    RowBatch batch;
+    std::vector<std::string> cells;
+    size_t buffered = 0;
+    while (buffered < window_rows &&
+           cursor.next(batch, std::min(DEFAULT_BATCH_ROWS, window_rows - buffered)))
+    {
+        for (size_t r = 0; r < batch.size; r++)
+        {
+            for (size_t c = 0; c < column_count; c++)
+            {
+                cells.emplace_back();
+                append_value(cells.back(), batch.rows[r][c]);
+                widths[c] = std::max(widths[c], cells.back().size());
+            }
+        }
+        buffered += batch.size;
+    }
+
+    // An unknown count is known once the window is not filled; otherwise it
+    // follows the rows
+    if (total == UNKNOWN_ROWS && buffered < window_rows)
+        total = buffered;
+    std::string text = "\n" + cursor.plan() + "\nResults";
+    if (total != UNKNOWN_ROWS)
+        text += " (" + std::to_string(total) + " rows)";
+    text += ":\n";
+    size_t line_width = 0;
+    for (size_t c = 0; c < column_count; c++)
+    {
+        append_cell(text, columns[c].name + (columns[c].key ? "*" : ""), widths[c]);
+        line_width += widths[c] + 2;
+    }
+    text += "\n" + std::string(line_width, '-') + "\n";
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        append_cell(text, cells[i], widths[i % column_count]);
+        if (i % column_count == column_count - 1)
+            text += "\n";
+    }
+    out.write(text.data(), text.size());
+    if (buffered < window_rows)
+        return;
+
+    // The rest streams a batch at a time
+    std::string cell;
+    while (cursor.next(batch))
+    {
+        text.clear();
+        for (size_t r = 0; r < batch.size; r++)
+        {
+            for (size_t c = 0; c < column_count; c++)
+            {
+                cell.clear();
+                append_value(cell, batch.rows[r][c]);
+                widths[c] = std::max(widths[c], cell.size());
+                append_cell(text, cell, widths[c]);
+            }
+            text += "\n";
+        }
+        buffered += batch.size;
+        out.write(text.data(), text.size());
+    }
+    if (total == UNKNOWN_ROWS)
+        out << "(" << buffered << " rows)\n";
+}
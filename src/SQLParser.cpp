@@ -15,10 +15,25 @@ void SQLParser::parse(const std::string &query, Database &db)
             parse_insert(ss, db);
         else if (token == "SELECT")
             parse_select(ss, db);
+        else if (token == "EXPLAIN")
+        {
+            ss >> token; // SELECT
+            parse_select(ss, db, true);
+        }
         else if (token == "UPDATE")
             parse_update(ss, db);
         else if (token == "DELETE")
             parse_delete(ss, db);
+        else if (token == "VACUUM")
+            parse_vacuum(ss, db);
+        else if (token == "COPY")
+            parse_copy(ss, db);
+        else if (token == "SHOW")
+            parse_show(ss, db);
+        else if (token == "SET")
+            parse_set(ss, db);
+        else if (token == "CHECKPOINT" || token == "CHECKPOINT;")
+            db.checkpoint();
         else
             throw std::runtime_error("Unknown command");
     }
@@ -33,6 +48,14 @@ void SQLParser::parse_create(std::stringstream &ss, Database &db)
     std::string table_keyword, table_name;
     ss >> table_keyword >> table_name;
 
+    std::string create_kind = table_keyword;
+    std::transform(create_kind.begin(), create_kind.end(), create_kind.begin(), ::toupper);
+    if (create_kind == "INDEX")
+    {
+        parse_create_index(ss, db, table_name);
+        return;
+    }
+
     std::vector<Column> columns;
     std::string full_spec;
     std::getline(ss, full_spec);
@@ -44,31 +67,51 @@ void SQLParser::parse_create(std::stringstream &ss, Database &db)
     {
         throw std::runtime_error("Invalid CREATE TABLE syntax");
     }
+    // Optional storage clause after the column list: USING ROW | COLUMNAR | PAGED
+    StorageLayout layout = StorageLayout::ROW;
+    std::stringstream suffix_ss(full_spec.substr(end + 1));
+    std::string using_keyword, layout_name;
+    if (suffix_ss >> using_keyword)
+    {
+        suffix_ss >> layout_name;
+        if (!layout_name.empty() && layout_name.back() == ';')
+            layout_name.pop_back();
+        std::transform(using_keyword.begin(), using_keyword.end(), using_keyword.begin(), ::toupper);
+        std::transform(layout_name.begin(), layout_name.end(), layout_name.begin(), ::toupper);
+        if (using_keyword == "USING" && layout_name == "COLUMNAR")
+            layout = StorageLayout::COLUMNAR;
+        else if (using_keyword == "USING" && layout_name == "PAGED")
+            layout = StorageLayout::PAGED;
+        else if (using_keyword != ";" && !(using_keyword == "USING" && layout_name == "ROW"))
+            throw std::runtime_error("Unknown storage clause: " + using_keyword + " " + layout_name);
+    }
     full_spec = full_spec.substr(start + 1, end - start - 1);
 
-    // Split column definitions by comma and trim each
+    // Split column definitions by the commas outside parentheses (a
+    // PRIMARY KEY (a, b) clause has its own) and trim each
     std::vector<std::string> column_defs;
-    std::stringstream col_ss(full_spec);
     std::string column_def;
-    while (std::getline(col_ss, column_def, ','))
+    int depth = 0;
+    for (size_t i = 0; i <= full_spec.size(); i++)
     {
-        // Trim whitespace from each column definition
-        auto trim = [](std::string &s)
+        char c = i < full_spec.size() ? full_spec[i] : ',';
+        depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+        if (c != ',' || depth > 0)
         {
-            s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch)
-                                            { return !std::isspace(ch); }));
-            s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch)
-                                 { return !std::isspace(ch); })
-                        .base(),
-                    s.end());
-        };
-        trim(column_def);
+            column_def += c;
+            continue;
+        }
+        column_def = Database::trim(column_def);
         if (!column_def.empty())
         {
             column_defs.push_back(column_def);
         }
+        column_def.clear();
     }
 
+    // Table-level PRIMARY KEY (col, ...) clause, giving the key column order
+    std::vector<std::string> primary_key;
+
     for (const auto &column_def : column_defs)
     {
         std::stringstream def_ss(column_def);
@@ -83,6 +126,21 @@ void SQLParser::parse_create(std::stringstream &ss, Database &db)
             continue; // Invalid column definition
         }
 
+        std::string first = tokens[0];
+        std::transform(first.begin(), first.end(), first.begin(), ::toupper);
+        if (first == "PRIMARY")
+        {
+            size_t open = column_def.find('(');
+            size_t close = column_def.rfind(')');
+            if (!primary_key.empty() || open == std::string::npos || close == std::string::npos || open > close)
+                throw std::runtime_error("Invalid PRIMARY KEY clause");
+            std::stringstream key_ss(column_def.substr(open + 1, close - open - 1));
+            std::string key_col;
+            while (std::getline(key_ss, key_col, ','))
+                primary_key.push_back(Database::trim(key_col));
+            continue;
+        }
+
         Column col;
         col.name = tokens[0];
         col.type = tokens[1];
@@ -101,7 +159,49 @@ void SQLParser::parse_create(std::stringstream &ss, Database &db)
         columns.push_back(col);
     }
 
-    db.create_table(table_name, columns);
+    db.create_table(table_name, columns, layout, primary_key);
+}
+
+// CREATE INDEX name ON table(column) [USING BTREE | HASH]; the index name is
+// already consumed
+void SQLParser::parse_create_index(std::stringstream &ss, Database &db, const std::string &index_name)
+{
+    std::string rest;
+    std::getline(ss, rest);
+    rest.erase(std::remove(rest.begin(), rest.end(), ';'), rest.end());
+
+    std::stringstream rest_ss(rest);
+    std::string on_keyword;
+    rest_ss >> on_keyword;
+    std::transform(on_keyword.begin(), on_keyword.end(), on_keyword.begin(), ::toupper);
+
+    std::string target;
+    std::getline(rest_ss, target);
+    size_t open = target.find('(');
+    size_t close = target.rfind(')');
+    if (on_keyword != "ON" || index_name.empty() || open == std::string::npos ||
+        close == std::string::npos || open >= close)
+    {
+        throw std::runtime_error("Invalid CREATE INDEX syntax, expected CREATE INDEX name ON table(column)");
+    }
+
+    IndexKind kind = IndexKind::BTREE;
+    std::stringstream suffix_ss(target.substr(close + 1));
+    std::string using_keyword, kind_name;
+    if (suffix_ss >> using_keyword)
+    {
+        suffix_ss >> kind_name;
+        std::transform(using_keyword.begin(), using_keyword.end(), using_keyword.begin(), ::toupper);
+        std::transform(kind_name.begin(), kind_name.end(), kind_name.begin(), ::toupper);
+        if (using_keyword == "USING" && kind_name == "HASH")
+            kind = IndexKind::HASH;
+        else if (!(using_keyword == "USING" && kind_name == "BTREE"))
+            throw std::runtime_error("Unknown index type: " + using_keyword + " " + kind_name);
+    }
+
+    std::string table_name = Database::trim(target.substr(0, open));
+    std::string column_name = Database::trim(target.substr(open + 1, close - open - 1));
+    db.create_index(index_name, table_name, column_name, kind);
 }
 
 void SQLParser::parse_insert(std::stringstream &ss, Database &db)
@@ -116,16 +216,49 @@ void SQLParser::parse_insert(std::stringstream &ss, Database &db)
         return;
     }
 
-    std::vector<Value> parsed_values;
     std::string value_str;
     std::getline(ss, value_str);
 
-    // Remove semicolons and trim
+    // Remove semicolons, then split VALUES (...), (...) into tuples
     value_str.erase(std::remove(value_str.begin(), value_str.end(), ';'), value_str.end());
-    value_str = value_str.substr(value_str.find('(') + 1);
-    value_str = value_str.substr(0, value_str.find(')'));
+    std::vector<std::vector<Value>> rows;
+    bool in_quotes = false;
+    size_t tuple_start = std::string::npos;
+    for (size_t i = 0; i < value_str.size(); i++)
+    {
+        char c = value_str[i];
+        if (c == '\'')
+            in_quotes = !in_quotes;
+        else if (!in_quotes && c == '(' && tuple_start == std::string::npos)
+            tuple_start = i + 1;
+        else if (!in_quotes && c == ')' && tuple_start != std::string::npos)
+        {
+            rows.push_back(parse_tuple(value_str.substr(tuple_start, i - tuple_start), *table, db));
+            tuple_start = std::string::npos;
+        }
+    }
+    if (rows.empty())
+    {
+        throw std::runtime_error("Invalid INSERT syntax");
+    }
 
-    std::stringstream values_ss(value_str);
+    try
+    {
+        if (rows.size() == 1)
+            db.insert_into(table_name, rows[0]);
+        else
+            db.insert_many(table_name, rows);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Insert error: " << e.what() << "\n";
+    }
+}
+
+std::vector<Value> SQLParser::parse_tuple(const std::string &tuple, const Table &table, Database &db)
+{
+    std::vector<Value> parsed_values;
+    std::stringstream values_ss(tuple);
 
     size_t col_index = 0;
     bool in_quotes = false;
@@ -149,12 +282,12 @@ void SQLParser::parse_insert(std::stringstream &ss, Database &db)
 
         if (!in_quotes && c == ',')
         {
-            if (col_index >= table->columns.size())
+            if (col_index >= table.columns.size())
             {
                 throw std::runtime_error("Too many values");
             }
 
-            const std::string &col_type = table->columns[col_index].type;
+            const std::string &col_type = table.columns[col_index].type;
 
             if (col_type == "STRING")
             {
@@ -179,31 +312,24 @@ void SQLParser::parse_insert(std::stringstream &ss, Database &db)
 
     if (!current_value.empty())
     {
-        if (col_index >= table->columns.size())
+        if (col_index >= table.columns.size())
         {
             throw std::runtime_error("Too many values");
         }
-        const std::string &col_type = table->columns[col_index].type;
+        const std::string &col_type = table.columns[col_index].type;
         Value val = db.public_parse_value(current_value, col_type);
         parsed_values.push_back(val);
     }
 
-    if (parsed_values.size() != table->columns.size())
+    if (parsed_values.size() != table.columns.size())
     {
         throw std::runtime_error("Column count mismatch");
     }
-
-    try
-    {
-        db.insert_into(table_name, parsed_values);
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Insert error: " << e.what() << "\n";
-    }
+    return parsed_values;
 }
 
-std::vector<Condition> SQLParser::parse_where_clause(std::stringstream &ss, Database &db, const std::string &table_name)
+std::vector<Condition> SQLParser::parse_where_clause(std::stringstream &ss, Database &db, const std::string &table_name,
+                                                     const std::string &join_table)
 {
     std::vector<Condition> conditions;
     std::string logical_op = "AND"; // Default
@@ -271,10 +397,26 @@ std::vector<Condition> SQLParser::parse_where_clause(std::stringstream &ss, Data
         // Parse value
         try
         {
-            int col_idx = db.public_get_col_index(table_name, cond.column);
+            // Columns may be qualified; in a join bare names try the first
+            // table first
+            const Table *owner = nullptr;
+            int col_idx = -1;
+            size_t dot = cond.column.find('.');
+            for (const std::string &name : {table_name, join_table})
+            {
+                if (name.empty() || (dot != std::string::npos && cond.column.substr(0, dot) != name))
+                    continue;
+                col_idx = db.public_get_col_index(name, cond.column.substr(dot == std::string::npos ? 0 : dot + 1));
+                owner = db.get_table(name);
+                if (col_idx != -1)
+                    break;
+            }
+            // An unknown column is kept, with its value as written, so the
+            // statement can report it instead of losing the condition
             if (col_idx == -1)
-                throw std::runtime_error("Column not found");
-            cond.value = db.public_parse_value(value_str, table->columns[col_idx].type);
+                cond.value = value_str;
+            else
+                cond.value = db.public_parse_value(value_str, owner->columns[col_idx].type);
             std::cerr << "Parsed value: " << cond.value << "\n";
         }
         catch (...)
@@ -321,63 +463,190 @@ std::vector<Condition> SQLParser::parse_where_clause(std::stringstream &ss, Data
     return conditions;
 }
 
-void SQLParser::parse_select(std::stringstream &ss, Database &db)
+// Offset of keyword as a whole word outside quotes, ignoring case, or npos
+static size_t find_keyword(const std::string &text, const std::string &keyword, size_t from = 0)
 {
-    std::string fields_str;
-    std::getline(ss, fields_str, 'F');
-    ss.putback('F');
+    bool in_quotes = false;
+    for (size_t i = from; i + keyword.size() <= text.size(); i++)
+    {
+        if (text[i] == '\'')
+            in_quotes = !in_quotes;
+        if (in_quotes || (i > 0 && !::isspace(static_cast<unsigned char>(text[i - 1]))))
+            continue;
+        size_t end = i + keyword.size();
+        if (end < text.size() && !::isspace(static_cast<unsigned char>(text[end])) && text[end] != ';')
+            continue;
+        bool match = true;
+        for (size_t k = 0; k < keyword.size() && match; k++)
+            match = ::toupper(static_cast<unsigned char>(text[i + k])) == keyword[k];
+        if (match)
+            return i;
+    }
+    return std::string::npos;
+}
 
-    std::vector<std::string> selected_columns;
-    bool select_all = false;
+// Comma-separated names with spaces dropped
+static std::vector<std::string> split_names(const std::string &text)
+{
+    std::vector<std::string> names;
+    std::stringstream names_ss(text);
+    std::string name;
+    while (std::getline(names_ss, name, ','))
+    {
+        name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+        if (!name.empty())
+            names.push_back(name);
+    }
+    return names;
+}
 
-    std::stringstream fields_ss(fields_str);
-    std::string field;
-    while (std::getline(fields_ss, field, ','))
+// * | item, ... where an item is a column or COUNT(*), COUNT|SUM|MIN|MAX|AVG(column)
+static void parse_select_list(const std::string &fields_str, SelectQuery &query)
+{
+    static const std::pair<const char *, AggregateFunction> functions[] = {
+        {"COUNT", AggregateFunction::COUNT},
+        {"SUM", AggregateFunction::SUM},
+        {"MIN", AggregateFunction::MIN},
+        {"MAX", AggregateFunction::MAX},
+        {"AVG", AggregateFunction::AVG}};
+
+    for (const auto &field : split_names(fields_str))
     {
-        field.erase(std::remove_if(field.begin(), field.end(), ::isspace), field.end());
         if (field == "*")
         {
-            select_all = true;
+            query.select_all = true;
             break;
         }
-        selected_columns.push_back(field);
+        SelectItem item{field, false, AggregateFunction::COUNT, field};
+        size_t open = field.find('(');
+        if (open != std::string::npos && field.back() == ')')
+        {
+            std::string function = field.substr(0, open);
+            std::transform(function.begin(), function.end(), function.begin(), ::toupper);
+            item.column = field.substr(open + 1, field.size() - open - 2);
+            for (const auto &known : functions)
+            {
+                if (function == known.first)
+                {
+                    item.aggregate = true;
+                    item.function = known.second;
+                }
+            }
+            if (!item.aggregate)
+                throw std::runtime_error("Unknown function: " + function);
+            if (item.column.empty() || (item.column == "*" && item.function != AggregateFunction::COUNT))
+                throw std::runtime_error("Invalid argument to " + function + ": " + field);
+            item.name = function + "(" + item.column + ")";
+        }
+        query.items.push_back(item);
     }
+}
 
-    std::string from_keyword, table1_name, join_keyword, table2_name;
-    ss >> from_keyword >> table1_name;
-
-    // Remove semicolon from first table
-    if (!table1_name.empty() && table1_name.back() == ';')
+// SELECT items FROM t [JOIN t2 ON a.x = b.y] [WHERE ...] [GROUP BY cols]
+//     [ORDER BY key [ASC|DESC], ...] [LIMIT n] [OFFSET n]
+void SQLParser::parse_select(std::stringstream &ss, Database &db, bool explain)
+{
+    std::string statement;
+    std::getline(ss, statement);
+    statement = Database::trim(statement);
+    if (!statement.empty() && statement.back() == ';')
+        statement.pop_back();
+
+    size_t from_pos = find_keyword(statement, "FROM");
+    if (from_pos == std::string::npos)
+        throw std::runtime_error("Invalid SELECT syntax, expected FROM");
+    SelectQuery query;
+    parse_select_list(statement.substr(0, from_pos), query);
+
+    // Clauses after WHERE are cut off first, so its values end where they do
+    std::string body = statement.substr(from_pos + 4);
+    std::vector<std::pair<size_t, std::string>> clauses;
+    for (const char *keyword : {"GROUP", "ORDER", "LIMIT", "OFFSET"})
     {
-        table1_name.pop_back();
+        size_t pos = find_keyword(body, keyword);
+        if (pos != std::string::npos)
+            clauses.push_back({pos, keyword});
     }
-
-    // Check for JOIN
-    if (ss >> join_keyword && (join_keyword == "JOIN" || join_keyword == "INNER"))
+    std::sort(clauses.begin(), clauses.end());
+    for (size_t c = 0; c < clauses.size(); c++)
     {
-        ss >> table2_name;
+        const std::string &keyword = clauses[c].second;
+        size_t begin = clauses[c].first + keyword.size();
+        size_t end = c + 1 < clauses.size() ? clauses[c + 1].first : body.size();
+        std::stringstream clause_ss(body.substr(begin, end - begin));
+        std::string by_keyword, rest;
+        if (keyword == "LIMIT" || keyword == "OFFSET")
+        {
+            std::string number;
+            clause_ss >> number >> rest;
+            if (number.empty() || number.size() > 18 || !rest.empty() ||
+                !std::all_of(number.begin(), number.end(), ::isdigit))
+                throw std::runtime_error("Invalid " + keyword + ", expected a row count");
+            (keyword == "LIMIT" ? query.limit : query.offset) = std::stoull(number);
+            continue;
+        }
+
+        clause_ss >> by_keyword;
+        std::transform(by_keyword.begin(), by_keyword.end(), by_keyword.begin(), ::toupper);
+        std::getline(clause_ss, rest);
+        if (keyword == "GROUP")
+        {
+            query.group_by = split_names(rest);
+            if (by_keyword != "BY" || query.group_by.empty())
+                throw std::runtime_error("Invalid GROUP BY syntax");
+            continue;
+        }
 
-        // Remove semicolon from second table
-        if (!table2_name.empty() && table2_name.back() == ';')
+        // ORDER BY key [ASC|DESC], ...; aggregates as in the select list
+        std::stringstream keys_ss(rest);
+        std::string key;
+        while (std::getline(keys_ss, key, ','))
         {
-            table2_name.pop_back();
+            OrderItem item;
+            std::stringstream key_ss(key);
+            std::string word, direction;
+            while (key_ss >> word)
+            {
+                std::string upper = word;
+                std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+                if (upper == "ASC" || upper == "DESC")
+                    direction = upper;
+                else if (!direction.empty())
+                    throw std::runtime_error("Invalid ORDER BY key: " + Database::trim(key));
+                else
+                    item.column += word;
+            }
+            if (item.column.empty())
+                throw std::runtime_error("Invalid ORDER BY syntax");
+            size_t open = item.column.find('(');
+            if (open != std::string::npos)
+                std::transform(item.column.begin(), item.column.begin() + open, item.column.begin(), ::toupper);
+            item.descending = direction == "DESC";
+            query.order_by.push_back(item);
         }
+        if (by_keyword != "BY" || query.order_by.empty())
+            throw std::runtime_error("Invalid ORDER BY syntax");
+    }
+    if (!clauses.empty())
+        body.erase(clauses[0].first);
+
+    std::stringstream body_ss(body);
+    std::string join_keyword;
+    body_ss >> query.table;
+    if (body_ss >> join_keyword && (join_keyword == "JOIN" || join_keyword == "INNER"))
+    {
+        if (join_keyword == "INNER")
+            body_ss >> join_keyword; // JOIN
+        body_ss >> query.join_table;
 
         std::string on_keyword;
-        ss >> on_keyword; // Should be "ON"
+        body_ss >> on_keyword; // Should be "ON"
 
         // Parse join condition
-        Condition jc;
+        Condition &jc = query.join;
         jc.is_join = true;
         std::string left_part, op, right_part;
-        ss >> left_part >> op >> right_part;
-
-        // Clean right_part from semicolons
-        right_part = Database::trim(right_part);
-        if (!right_part.empty() && right_part.back() == ';')
-        {
-            right_part.pop_back();
-        }
+        body_ss >> left_part >> op >> right_part;
 
         // Parse left side
         size_t dot_pos = left_part.find('.');
@@ -390,31 +659,19 @@ void SQLParser::parse_select(std::stringstream &ss, Database &db)
         jc.right_col = right_part.substr(dot_pos + 1);
         jc.op = op;
 
-        std::vector<Condition> join_conds = {jc};
-
-        // Parse WHERE clause if exists
-        std::vector<Condition> where_conds;
         std::string where_kw;
-        if (ss >> where_kw && where_kw == "WHERE")
-        {
-            where_conds = parse_where_clause(ss, db, table1_name);
-        }
-
-        db.select_join(table1_name, table2_name, join_conds,
-                       where_conds, selected_columns, select_all);
+        if (body_ss >> where_kw && where_kw == "WHERE")
+            query.where = parse_where_clause(body_ss, db, query.table, query.join_table);
     }
-    else
+    else if (join_keyword == "WHERE")
     {
-        // Existing single-table logic
-        ss.seekg(-join_keyword.length(), std::ios::cur);
-        std::vector<Condition> conditions;
-        std::string where_clause;
-        if (ss >> where_clause && where_clause == "WHERE")
-        {
-            conditions = parse_where_clause(ss, db, table1_name);
-        }
-        db.select(table1_name, conditions, selected_columns, select_all);
+        query.where = parse_where_clause(body_ss, db, query.table);
     }
+
+    if (explain)
+        db.explain(query);
+    else
+        db.select(query);
 }
 
 void SQLParser::parse_update(std::stringstream &ss, Database &db)
@@ -476,9 +733,9 @@ void SQLParser::parse_update(std::stringstream &ss, Database &db)
     {
         db.update(table_name, updates, conditions);
     }
-    catch (...)
+    catch (const std::exception &e)
     {
-        std::cerr << "Update failed\n";
+        std::cerr << "Update failed: " << e.what() << "\n";
     }
 }
 
@@ -504,8 +761,135 @@ void SQLParser::parse_delete(std::stringstream &ss, Database &db)
     {
         db.delete_rows(table_name, conditions);
     }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Delete failed: " << e.what() << "\n";
+    }
+}
+
+void SQLParser::parse_vacuum(std::stringstream &ss, Database &db)
+{
+    std::string table_name;
+    ss >> table_name;
+    if (!table_name.empty() && table_name.back() == ';')
+        table_name.pop_back();
+    if (table_name.empty())
+        throw std::runtime_error("Invalid VACUUM syntax");
+    db.vacuum(table_name);
+}
+
+// COPY table FROM 'file.csv' [WITH] [HEADER] [DELIMITER 'c']
+void SQLParser::parse_copy(std::stringstream &ss, Database &db)
+{
+    std::string table_name, from_keyword;
+    ss >> table_name >> from_keyword;
+    std::transform(from_keyword.begin(), from_keyword.end(), from_keyword.begin(), ::toupper);
+    if (table_name.empty() || from_keyword != "FROM")
+        throw std::runtime_error("Invalid COPY syntax, expected COPY <table> FROM '<file>'");
+
+    std::string rest;
+    std::getline(ss, rest);
+    rest = Database::trim(rest);
+    if (!rest.empty() && rest.back() == ';')
+        rest.pop_back();
+
+    // Quoted literal starting at pos, '' standing for a quote; pos ends
+    // past the closing quote
+    size_t pos = 0;
+    auto quoted = [&]()
+    {
+        while (pos < rest.size() && ::isspace(static_cast<unsigned char>(rest[pos])))
+            pos++;
+        if (pos >= rest.size() || rest[pos] != '\'')
+            throw std::runtime_error("Invalid COPY syntax, expected a quoted string");
+        std::string text;
+        for (pos++; pos < rest.size(); pos++)
+        {
+            if (rest[pos] != '\'')
+                text += rest[pos];
+            else if (pos + 1 < rest.size() && rest[pos + 1] == '\'')
+                text += rest[++pos];
+            else
+                break;
+        }
+        if (pos >= rest.size())
+            throw std::runtime_error("Invalid COPY syntax, unterminated string");
+        pos++;
+        return text;
+    };
+
+    std::string path = quoted();
+    CsvOptions options;
+    std::stringstream options_ss(rest.substr(pos));
+    std::string word;
+    while (options_ss >> word)
+    {
+        std::transform(word.begin(), word.end(), word.begin(), ::toupper);
+        if (word == "WITH")
+            continue;
+        if (word == "HEADER")
+        {
+            options.header = true;
+            continue;
+        }
+        if (word != "DELIMITER")
+            throw std::runtime_error("Unknown COPY option: " + word);
+        std::getline(options_ss, rest);
+        pos = 0;
+        std::string delimiter = quoted();
+        if (delimiter.size() != 1 || delimiter[0] == '"' || delimiter[0] == '\n')
+            throw std::runtime_error("COPY DELIMITER must be a single character");
+        options.delimiter = delimiter[0];
+        options_ss.str(rest.substr(pos));
+        options_ss.clear();
+    }
+    db.copy_from(table_name, path, options);
+}
+
+void SQLParser::parse_show(std::stringstream &ss, Database &db)
+{
+    std::string what, table_name;
+    ss >> what >> table_name;
+    std::transform(what.begin(), what.end(), what.begin(), ::toupper);
+    if (!table_name.empty() && table_name.back() == ';')
+        table_name.pop_back();
+    if (what == "BUFFER_POOL" || what == "BUFFER_POOL;")
+    {
+        db.show_buffer_pool();
+        return;
+    }
+    if (what != "INDEX" || table_name.empty())
+        throw std::runtime_error("Invalid SHOW syntax, expected SHOW INDEX <table> or SHOW BUFFER_POOL");
+    db.show_index(table_name);
+}
+
+// SET THREADS n | SET MORSEL_SIZE n
+void SQLParser::parse_set(std::stringstream &ss, Database &db)
+{
+    std::string setting, value;
+    ss >> setting >> value;
+    std::transform(setting.begin(), setting.end(), setting.begin(), ::toupper);
+    if (!value.empty() && value.back() == ';')
+        value.pop_back();
+
+    size_t number = 0;
+    try
+    {
+        number = std::stoul(value);
+    }
     catch (...)
     {
-        std::cerr << "Delete failed\n";
+        throw std::runtime_error("Invalid SET value: " + value);
     }
+
+    if (setting == "THREADS")
+        db.set_threads(number);
+    else if (setting == "MORSEL_SIZE")
+        db.set_morsel_size(number);
+    else if (setting == "WAL_SYNC_MS")
+        db.set_wal_sync(number);
+    else if (setting == "BUFFER_POOL_MB")
+        db.set_buffer_pool_size(number);
+    else
+        throw std::runtime_error("Unknown setting: " + setting);
 }
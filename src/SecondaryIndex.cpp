@@ -0,0 +1,61 @@
+#include "SecondaryIndex.h"
+
+template class BasicBPlusTree<IndexEntry, int, std::less<IndexEntry>, BPLUS_DEFAULT_ORDER>;
+
+void SecondaryIndex::insert(int64_t key, int row)
+{
+    if (kind == IndexKind::HASH)
+        hash.insert(key, row);
+    else
+        tree.insert({key, row}, row);
+}
+
+void SecondaryIndex::remove(int64_t key, int row)
+{
+    if (kind == IndexKind::HASH)
+        hash.remove(key, row);
+    else
+        tree.remove({key, row});
+}
+
+bool SecondaryIndex::find(int64_t key, int &row) const
+{
+    if (kind == IndexKind::HASH)
+        return hash.find(key, row);
+    auto it = tree.lower_bound({key, INT32_MIN});
+    if (!it.valid() || it.key().key != key)
+        return false;
+    row = it.value();
+    return true;
+}
+
+std::vector<int> SecondaryIndex::lookup(int64_t min_key, int64_t max_key) const
+{
+    if (kind == IndexKind::HASH)
+        return min_key == max_key ? hash.lookup(min_key) : std::vector<int>();
+
+    std::vector<int> rows;
+    for (auto it = tree.lower_bound({min_key, INT32_MIN}); it.valid() && it.key().key <= max_key; it.next())
+        rows.push_back(it.value());
+    // Hand rows back in slot order, same as a full scan would
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+void SecondaryIndex::rebuild(std::vector<IndexEntry> entries)
+{
+    if (kind == IndexKind::HASH)
+    {
+        hash.reset(entries.size());
+        for (const auto &entry : entries)
+            hash.insert(entry.key, entry.row);
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end());
+    std::vector<std::pair<IndexEntry, int>> sorted;
+    sorted.reserve(entries.size());
+    for (const auto &entry : entries)
+        sorted.push_back({entry, entry.row});
+    tree.bulk_load(sorted);
+}
@@ -0,0 +1,389 @@
+#include "SimdKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NEXUS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+SimdLevel detect_simd_level()
+{
+    static const SimdLevel detected = []
+    {
+#ifdef NEXUS_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return SimdLevel::SSE2;
+#endif
+        return SimdLevel::SCALAR;
+    }();
+    return detected;
+}
+
+// Read on every kernel call, from any thread, while a bench may force a
+// level. Loads are relaxed: a reader that sees the flag before the new
+// level gets an earlier forced level or SCALAR, all of which this CPU runs.
+static std::atomic<SimdLevel> forced_level{SimdLevel::SCALAR};
+static std::atomic<bool> level_forced{false};
+
+SimdLevel active_simd_level()
+{
+    return level_forced.load(std::memory_order_relaxed) ? forced_level.load(std::memory_order_relaxed)
+                                                        : detect_simd_level();
+}
+
+void set_simd_level(SimdLevel level)
+{
+    forced_level.store(std::min(level, detect_simd_level()), std::memory_order_relaxed);
+    level_forced.store(true, std::memory_order_relaxed);
+}
+
+const char *simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE2:
+        return "SSE2";
+    default:
+        return "SCALAR";
+    }
+}
+
+// ------------------- Scalar kernels -------------------
+template <CompareOp OP, typename T>
+static inline bool scalar_compare(T lhs, T rhs)
+{
+    if constexpr (OP == CompareOp::EQ)
+        return lhs == rhs;
+    else if constexpr (OP == CompareOp::NE)
+        return lhs != rhs;
+    else if constexpr (OP == CompareOp::LT)
+        return lhs < rhs;
+    else if constexpr (OP == CompareOp::LE)
+        return lhs <= rhs;
+    else if constexpr (OP == CompareOp::GT)
+        return lhs > rhs;
+    else
+        return lhs >= rhs;
+}
+
+template <CompareOp OP>
+static inline bool scalar_compare_float(float lhs, float rhs)
+{
+    // Matches Predicate's tolerant float equality
+    if constexpr (OP == CompareOp::EQ)
+        return std::abs(lhs - rhs) < 1e-6;
+    else if constexpr (OP == CompareOp::NE)
+        return std::abs(lhs - rhs) >= 1e-6;
+    else
+        return scalar_compare<OP>(lhs, rhs);
+}
+
+// Fills words [first_word, ceil(n / 64)) of the bitmap
+template <CompareOp OP, typename T>
+static void scalar_kernel(const T *data, size_t n, T value, uint64_t *out, size_t first_word = 0)
+{
+    size_t words = (n + 63) / 64;
+    for (size_t w = first_word; w < words; w++)
+    {
+        size_t base = w * 64;
+        size_t limit = std::min<size_t>(64, n - base);
+        uint64_t bits = 0;
+        for (size_t j = 0; j < limit; j++)
+        {
+            bool pass;
+            if constexpr (std::is_same_v<T, float>)
+                pass = scalar_compare_float<OP>(data[base + j], value);
+            else
+                pass = scalar_compare<OP>(data[base + j], value);
+            bits |= uint64_t(pass) << j;
+        }
+        out[w] = bits;
+    }
+}
+
+#ifdef NEXUS_X86_SIMD
+// ------------------- AVX2 kernels -------------------
+// Each word of the bitmap is built from eight 8-lane compares; the partial
+// last word is finished by the scalar kernel.
+template <CompareOp OP>
+__attribute__((target("avx2"))) static void int32_avx2(const int32_t *data, size_t n, int32_t value, uint64_t *out)
+{
+    const __m256i needle = _mm256_set1_epi32(value);
+    size_t full_words = n / 64;
+    for (size_t w = 0; w < full_words; w++)
+    {
+        uint64_t bits = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + w * 64 + k * 8));
+            __m256i m;
+            if constexpr (OP == CompareOp::EQ || OP == CompareOp::NE)
+                m = _mm256_cmpeq_epi32(x, needle);
+            else if constexpr (OP == CompareOp::GT || OP == CompareOp::LE)
+                m = _mm256_cmpgt_epi32(x, needle);
+            else
+                m = _mm256_cmpgt_epi32(needle, x);
+            uint64_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+            // NE, LE and GE are the complements of EQ, GT and LT
+            if constexpr (OP == CompareOp::NE || OP == CompareOp::LE || OP == CompareOp::GE)
+                mask ^= 0xFF;
+            bits |= mask << (k * 8);
+        }
+        out[w] = bits;
+    }
+    scalar_kernel<OP>(data, n, value, out, full_words);
+}
+
+template <CompareOp OP>
+__attribute__((target("avx2"))) static void float_avx2(const float *data, size_t n, float value, uint64_t *out)
+{
+    const __m256 needle = _mm256_set1_ps(value);
+    // 1e-6f is the largest float below 1e-6, so |d| <= 1e-6f matches |d| < 1e-6
+    const __m256 epsilon = _mm256_set1_ps(1e-6f);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t full_words = n / 64;
+    for (size_t w = 0; w < full_words; w++)
+    {
+        uint64_t bits = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            __m256 x = _mm256_loadu_ps(data + w * 64 + k * 8);
+            __m256 m;
+            if constexpr (OP == CompareOp::EQ)
+                m = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(x, needle)), epsilon, _CMP_LE_OQ);
+            else if constexpr (OP == CompareOp::NE)
+                m = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(x, needle)), epsilon, _CMP_GT_OQ);
+            else if constexpr (OP == CompareOp::LT)
+                m = _mm256_cmp_ps(x, needle, _CMP_LT_OQ);
+            else if constexpr (OP == CompareOp::LE)
+                m = _mm256_cmp_ps(x, needle, _CMP_LE_OQ);
+            else if constexpr (OP == CompareOp::GT)
+                m = _mm256_cmp_ps(x, needle, _CMP_GT_OQ);
+            else
+                m = _mm256_cmp_ps(x, needle, _CMP_GE_OQ);
+            bits |= uint64_t(static_cast<uint32_t>(_mm256_movemask_ps(m))) << (k * 8);
+        }
+        out[w] = bits;
+    }
+    scalar_kernel<OP>(data, n, value, out, full_words);
+}
+
+// ------------------- SSE2 kernels -------------------
+template <CompareOp OP>
+__attribute__((target("sse2"))) static void int32_sse2(const int32_t *data, size_t n, int32_t value, uint64_t *out)
+{
+    const __m128i needle = _mm_set1_epi32(value);
+    size_t full_words = n / 64;
+    for (size_t w = 0; w < full_words; w++)
+    {
+        uint64_t bits = 0;
+        for (int k = 0; k < 16; k++)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + w * 64 + k * 4));
+            __m128i m;
+            if constexpr (OP == CompareOp::EQ || OP == CompareOp::NE)
+                m = _mm_cmpeq_epi32(x, needle);
+            else if constexpr (OP == CompareOp::GT || OP == CompareOp::LE)
+                m = _mm_cmpgt_epi32(x, needle);
+            else
+                m = _mm_cmplt_epi32(x, needle);
+            uint64_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+            if constexpr (OP == CompareOp::NE || OP == CompareOp::LE || OP == CompareOp::GE)
+                mask ^= 0xF;
+            bits |= mask << (k * 4);
+        }
+        out[w] = bits;
+    }
+    scalar_kernel<OP>(data, n, value, out, full_words);
+}
+
+template <CompareOp OP>
+__attribute__((target("sse2"))) static void float_sse2(const float *data, size_t n, float value, uint64_t *out)
+{
+    const __m128 needle = _mm_set1_ps(value);
+    const __m128 epsilon = _mm_set1_ps(1e-6f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t full_words = n / 64;
+    for (size_t w = 0; w < full_words; w++)
+    {
+        uint64_t bits = 0;
+        for (int k = 0; k < 16; k++)
+        {
+            __m128 x = _mm_loadu_ps(data + w * 64 + k * 4);
+            __m128 m;
+            if constexpr (OP == CompareOp::EQ)
+                m = _mm_cmple_ps(_mm_andnot_ps(sign, _mm_sub_ps(x, needle)), epsilon);
+            else if constexpr (OP == CompareOp::NE)
+                m = _mm_cmpgt_ps(_mm_andnot_ps(sign, _mm_sub_ps(x, needle)), epsilon);
+            else if constexpr (OP == CompareOp::LT)
+                m = _mm_cmplt_ps(x, needle);
+            else if constexpr (OP == CompareOp::LE)
+                m = _mm_cmple_ps(x, needle);
+            else if constexpr (OP == CompareOp::GT)
+                m = _mm_cmpgt_ps(x, needle);
+            else
+                m = _mm_cmpge_ps(x, needle);
+            bits |= uint64_t(static_cast<uint32_t>(_mm_movemask_ps(m))) << (k * 4);
+        }
+        out[w] = bits;
+    }
+    scalar_kernel<OP>(data, n, value, out, full_words);
+}
+#endif
+
+// ------------------- Dispatch -------------------
+template <CompareOp OP>
+static void dispatch_int32(const int32_t *data, size_t n, int32_t value, uint64_t *out)
+{
+#ifdef NEXUS_X86_SIMD
+    switch (active_simd_level())
+    {
+    case SimdLevel::AVX2:
+        return int32_avx2<OP>(data, n, value, out);
+    case SimdLevel::SSE2:
+        return int32_sse2<OP>(data, n, value, out);
+    default:
+        break;
+    }
+#endif
+    scalar_kernel<OP>(data, n, value, out);
+}
+
+template <CompareOp OP>
+static void dispatch_float(const float *data, size_t n, float value, uint64_t *out)
+{
+#ifdef NEXUS_X86_SIMD
+    switch (active_simd_level())
+    {
+    case SimdLevel::AVX2:
+        return float_avx2<OP>(data, n, value, out);
+    case SimdLevel::SSE2:
+        return float_sse2<OP>(data, n, value, out);
+    default:
+        break;
+    }
+#endif
+    scalar_kernel<OP>(data, n, value, out);
+}
+
+void filter_int32(const int32_t *data, size_t n, CompareOp op, int32_t value, uint64_t *out)
+{
+    switch (op)
+    {
+    case CompareOp::EQ:
+        return dispatch_int32<CompareOp::EQ>(data, n, value, out);
+    case CompareOp::NE:
+        return dispatch_int32<CompareOp::NE>(data, n, value, out);
+    case CompareOp::LT:
+        return dispatch_int32<CompareOp::LT>(data, n, value, out);
+    case CompareOp::LE:
+        return dispatch_int32<CompareOp::LE>(data, n, value, out);
+    case CompareOp::GT:
+        return dispatch_int32<CompareOp::GT>(data, n, value, out);
+    case CompareOp::GE:
+        return dispatch_int32<CompareOp::GE>(data, n, value, out);
+    }
+}
+
+void filter_float(const float *data, size_t n, CompareOp op, float value, uint64_t *out)
+{
+    switch (op)
+    {
+    case CompareOp::EQ:
+        return dispatch_float<CompareOp::EQ>(data, n, value, out);
+    case CompareOp::NE:
+        return dispatch_float<CompareOp::NE>(data, n, value, out);
+    case CompareOp::LT:
+        return dispatch_float<CompareOp::LT>(data, n, value, out);
+    case CompareOp::LE:
+        return dispatch_float<CompareOp::LE>(data, n, value, out);
+    case CompareOp::GT:
+        return dispatch_float<CompareOp::GT>(data, n, value, out);
+    case CompareOp::GE:
+        return dispatch_float<CompareOp::GE>(data, n, value, out);
+    }
+}
+
+// ------------------- In-node key search -------------------
+// UPPER counts keys <= needle, otherwise keys < needle. Keys are sorted, so
+// that count is the insertion position.
+template <bool UPPER>
+static int scalar_search(const int32_t *keys, int count, int32_t key)
+{
+    if constexpr (UPPER)
+        return std::upper_bound(keys, keys + count, key) - keys;
+    else
+        return std::lower_bound(keys, keys + count, key) - keys;
+}
+
+#ifdef NEXUS_X86_SIMD
+template <bool UPPER>
+__attribute__((target("avx2,popcnt"))) static int search_avx2(const int32_t *keys, int count, int32_t key)
+{
+    const __m256i needle = _mm256_set1_epi32(key);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        // Lanes below the insertion point: x < key, or x <= key for upper
+        __m256i below = UPPER ? _mm256_xor_si256(_mm256_cmpgt_epi32(x, needle), _mm256_set1_epi32(-1))
+                              : _mm256_cmpgt_epi32(needle, x);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(below));
+        if (mask != 0xFF)
+            return i + __builtin_popcount(mask);
+    }
+    return i + scalar_search<UPPER>(keys + i, count - i, key);
+}
+
+template <bool UPPER>
+__attribute__((target("sse2"))) static int search_sse2(const int32_t *keys, int count, int32_t key)
+{
+    const __m128i needle = _mm_set1_epi32(key);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+        __m128i below = UPPER ? _mm_xor_si128(_mm_cmpgt_epi32(x, needle), _mm_set1_epi32(-1))
+                              : _mm_cmplt_epi32(x, needle);
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(below));
+        if (mask != 0xF)
+            return i + __builtin_popcount(mask);
+    }
+    return i + scalar_search<UPPER>(keys + i, count - i, key);
+}
+#endif
+
+template <bool UPPER>
+static int dispatch_search(const int32_t *keys, int count, int32_t key)
+{
+#ifdef NEXUS_X86_SIMD
+    switch (active_simd_level())
+    {
+    case SimdLevel::AVX2:
+        return search_avx2<UPPER>(keys, count, key);
+    case SimdLevel::SSE2:
+        return search_sse2<UPPER>(keys, count, key);
+    default:
+        break;
+    }
+#endif
+    return scalar_search<UPPER>(keys, count, key);
+}
+
+int search_lower_bound_i32(const int32_t *keys, int count, int32_t key)
+{
+    return dispatch_search<false>(keys, count, key);
+}
+
+int search_upper_bound_i32(const int32_t *keys, int count, int32_t key)
+{
+    return dispatch_search<true>(keys, count, key);
+}
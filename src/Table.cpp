@@ -0,0 +1,630 @@
+#include "Table.h"
+#include "BinaryCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+ColumnType column_type_of(const std::string &type)
+{
+    if (type == "INT")
+        return ColumnType::INT;
+    if (type == "FLOAT")
+        return ColumnType::FLOAT;
+    return ColumnType::STRING;
+}
+
+// A value as it reads in a STRING column
+static std::string text_of(const Value &value)
+{
+    if (std::holds_alternative<std::string>(value))
+        return std::get<std::string>(value);
+    std::stringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+int64_t index_key_of(const Value &value, ColumnType type)
+{
+    if (type == ColumnType::INT)
+    {
+        if (std::holds_alternative<int>(value))
+            return std::get<int>(value);
+        if (std::holds_alternative<float>(value))
+            return static_cast<int64_t>(std::get<float>(value));
+        // Cells that failed conversion read back as "NULL" and sort first
+        try
+        {
+            return std::stoll(std::get<std::string>(value));
+        }
+        catch (...)
+        {
+            return INT64_MIN;
+        }
+    }
+
+    if (type == ColumnType::FLOAT)
+    {
+        float f = -std::numeric_limits<float>::infinity();
+        if (std::holds_alternative<float>(value))
+            f = std::get<float>(value);
+        else if (std::holds_alternative<int>(value))
+            f = static_cast<float>(std::get<int>(value));
+        else
+        {
+            try
+            {
+                f = std::stof(std::get<std::string>(value));
+            }
+            catch (...)
+            {
+            }
+        }
+        if (f == 0.0f)
+            f = 0.0f; // -0 and +0 compare equal
+        int32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        // Negative floats sort backwards by bit pattern; flip their magnitude
+        return bits < 0 ? bits ^ 0x7FFFFFFF : bits;
+    }
+
+    std::string text = text_of(value);
+    // Big-endian bytes compare like the string itself; shift the unsigned
+    // range onto int64
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; i++)
+        prefix = (prefix << 8) | (i < text.size() ? static_cast<unsigned char>(text[i]) : 0);
+    return static_cast<int64_t>(prefix ^ (uint64_t(1) << 63));
+}
+
+void append_key_bytes(std::string &out, const Value &value, ColumnType type)
+{
+    if (type != ColumnType::STRING)
+    {
+        // Big-endian with the sign bit flipped sorts like the int64 key
+        uint64_t key = static_cast<uint64_t>(index_key_of(value, type)) ^ (uint64_t(1) << 63);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            out += static_cast<char>(key >> shift);
+        return;
+    }
+
+    // 0x00 is escaped as 0x00 0xFF and the value ends in 0x00 0x01, so no
+    // encoded string is a prefix of another and bytes sort like the text
+    for (char c : text_of(value))
+    {
+        out += c;
+        if (c == '\0')
+            out += '\xFF';
+    }
+    out += '\0';
+    out += '\x01';
+}
+
+bool Table::int_key() const
+{
+    return key_columns.size() == 1 && column_type_of(columns[key_columns[0]].type) == ColumnType::INT;
+}
+
+std::string Table::key_of(const std::vector<Value> &row) const
+{
+    std::string key;
+    for (int col : key_columns)
+        append_key_bytes(key, row[col], column_type_of(columns[col].type));
+    return key;
+}
+
+std::string Table::key_of(size_t slot) const
+{
+    std::string key;
+    for (int col : key_columns)
+        append_key_bytes(key, get_value(slot, col), column_type_of(columns[col].type));
+    return key;
+}
+
+void ColumnVector::set_valid(size_t row, bool valid)
+{
+    if ((row >> 6) >= validity.size())
+        validity.resize((row >> 6) + 1, 0);
+    if (valid)
+        validity[row >> 6] |= uint64_t(1) << (row & 63);
+    else
+        validity[row >> 6] &= ~(uint64_t(1) << (row & 63));
+}
+
+void ColumnVector::append_string(size_t row, std::string_view text)
+{
+    if (text.size() > UINT32_MAX)
+        throw std::runtime_error("String of " + std::to_string(text.size()) + " bytes is too long");
+    offsets[row] = bytes.size();
+    lengths[row] = text.size();
+    bytes += text;
+}
+
+void ColumnVector::append(const Value &val)
+{
+    bool valid = true;
+    switch (type)
+    {
+    case ColumnType::INT:
+    {
+        int32_t num = 0;
+        if (std::holds_alternative<int>(val))
+            num = std::get<int>(val);
+        else if (std::holds_alternative<float>(val))
+            num = static_cast<int32_t>(std::get<float>(val));
+        else
+        {
+            try
+            {
+                num = std::stoi(std::get<std::string>(val));
+            }
+            catch (...)
+            {
+                valid = false;
+            }
+        }
+        ints.push_back(num);
+        break;
+    }
+    case ColumnType::FLOAT:
+    {
+        float num = 0.0f;
+        if (std::holds_alternative<float>(val))
+            num = std::get<float>(val);
+        else if (std::holds_alternative<int>(val))
+            num = static_cast<float>(std::get<int>(val));
+        else
+        {
+            try
+            {
+                num = std::stof(std::get<std::string>(val));
+            }
+            catch (...)
+            {
+                valid = false;
+            }
+        }
+        floats.push_back(num);
+        break;
+    }
+    case ColumnType::STRING:
+    {
+        offsets.push_back(0);
+        lengths.push_back(0);
+        if (std::holds_alternative<std::string>(val))
+        {
+            append_string(size, std::get<std::string>(val));
+        }
+        else
+        {
+            std::stringstream ss;
+            ss << val;
+            append_string(size, ss.str());
+        }
+        break;
+    }
+    }
+    set_valid(size, valid);
+    size++;
+}
+
+Value ColumnVector::get(size_t row) const
+{
+    if (!is_valid(row))
+        return std::string("NULL");
+    switch (type)
+    {
+    case ColumnType::INT:
+        return ints[row];
+    case ColumnType::FLOAT:
+        return floats[row];
+    default:
+        return std::string(get_string(row));
+    }
+}
+
+void ColumnVector::assign(const std::vector<int> &rows, const Value &val)
+{
+    if (rows.empty())
+        return;
+
+    if (type != ColumnType::STRING)
+    {
+        // Convert once through append, then broadcast the converted cell
+        ColumnVector converted;
+        converted.type = type;
+        converted.append(val);
+        bool valid = converted.is_valid(0);
+        for (int row : rows)
+        {
+            if (type == ColumnType::INT)
+                ints[row] = converted.ints[0];
+            else
+                floats[row] = converted.floats[0];
+            set_valid(row, valid);
+        }
+        return;
+    }
+
+    std::string new_str;
+    if (std::holds_alternative<std::string>(val))
+    {
+        new_str = std::get<std::string>(val);
+    }
+    else
+    {
+        std::stringstream ss;
+        ss << val;
+        new_str = ss.str();
+    }
+
+    // Overwrite in place when the new string fits, else append it and
+    // leave the old bytes unused
+    for (int row : rows)
+    {
+        if (new_str.size() <= lengths[row])
+        {
+            std::memcpy(&bytes[offsets[row]], new_str.data(), new_str.size());
+            unused_bytes += lengths[row] - new_str.size();
+            packed = packed && new_str.size() == lengths[row];
+            lengths[row] = new_str.size();
+        }
+        else
+        {
+            unused_bytes += lengths[row];
+            append_string(row, new_str);
+            packed = false;
+        }
+        set_valid(row, true);
+    }
+
+    // Repeated growing updates would otherwise grow the arena without bound
+    if (unused_bytes > bytes.size() / 2)
+        erase({});
+}
+
+void ColumnVector::erase(const std::vector<int> &rows)
+{
+    if (rows.empty() && packed)
+        return;
+
+    std::string new_bytes;
+    if (type == ColumnType::STRING)
+        new_bytes.reserve(bytes.size() - unused_bytes);
+
+    size_t next = 0;
+    size_t write = 0;
+    for (size_t row = 0; row < size; row++)
+    {
+        if (next < rows.size() && static_cast<size_t>(rows[next]) == row)
+        {
+            next++;
+            continue;
+        }
+        if (type == ColumnType::INT)
+            ints[write] = ints[row];
+        else if (type == ColumnType::FLOAT)
+            floats[write] = floats[row];
+        else
+        {
+            std::string_view text = get_string(row);
+            offsets[write] = new_bytes.size();
+            lengths[write] = text.size();
+            new_bytes += text;
+        }
+        set_valid(write, is_valid(row));
+        write++;
+    }
+
+    size = write;
+    if (type == ColumnType::INT)
+        ints.resize(size);
+    else if (type == ColumnType::FLOAT)
+        floats.resize(size);
+    else
+    {
+        offsets.resize(size);
+        lengths.resize(size);
+        bytes.swap(new_bytes);
+        unused_bytes = 0;
+        packed = true;
+    }
+    validity.resize((size + 63) / 64);
+}
+
+size_t ColumnVector::memory_bytes() const
+{
+    return ints.capacity() * sizeof(int32_t) + floats.capacity() * sizeof(float) +
+           offsets.capacity() * sizeof(uint64_t) + lengths.capacity() * sizeof(uint32_t) + bytes.capacity() +
+           validity.capacity() * sizeof(uint64_t);
+}
+
+void Table::init_storage()
+{
+    column_data.clear();
+    if (layout != StorageLayout::COLUMNAR)
+        return;
+    for (const auto &col : columns)
+    {
+        ColumnVector cv;
+        cv.type = column_type_of(col.type);
+        column_data.push_back(std::move(cv));
+    }
+}
+
+static std::string encode_row(const std::vector<Value> &values)
+{
+    std::string record;
+    BinaryWriter out(record);
+    for (const auto &val : values)
+        out.put_value(val);
+    return record;
+}
+
+static std::vector<Value> decode_row(std::string_view record, size_t columns)
+{
+    BinaryReader in(record.data(), record.size());
+    std::vector<Value> values;
+    values.reserve(columns);
+    for (size_t c = 0; c < columns; c++)
+        values.push_back(in.get_value());
+    return values;
+}
+
+Value Table::paged_value(size_t row, size_t col) const
+{
+    PageGuard page = pool->fetch(records[row].page);
+    std::string_view record = SlottedPage(page.data()).get_record(records[row].slot);
+    BinaryReader in(record.data(), record.size());
+    for (size_t c = 0; c < col; c++)
+        in.skip_value();
+    return in.get_value();
+}
+
+// Bytes encode_row would produce, without building the record
+static size_t encoded_size(const std::vector<Value> &values)
+{
+    size_t size = 0;
+    for (const auto &val : values)
+    {
+        const std::string *text = std::get_if<std::string>(&val);
+        size += sizeof(ValueTag) + (text ? sizeof(uint32_t) + text->size() : sizeof(int32_t));
+    }
+    return size;
+}
+
+static void check_record_size(size_t size)
+{
+    if (size > SlottedPage::MAX_RECORD)
+        throw std::runtime_error("Row of " + std::to_string(size) + " bytes does not fit in a page");
+}
+
+void Table::check_row_fits(const std::vector<Value> &values) const
+{
+    if (layout == StorageLayout::PAGED)
+        check_record_size(encoded_size(values));
+}
+
+RecordId Table::store_record(const std::string &record)
+{
+    check_record_size(record.size());
+    if (fill_page != INVALID_PAGE)
+    {
+        PageGuard page = pool->fetch(fill_page);
+        SlottedPage slotted(page.mutable_data());
+        int slot = slotted.insert(record);
+        if (slot >= 0)
+            return {fill_page, static_cast<uint16_t>(slot)};
+    }
+    PageGuard page = pool->allocate();
+    SlottedPage slotted(page.mutable_data());
+    slotted.init();
+    int slot = slotted.insert(record);
+    fill_page = page.id();
+    pages.push_back(fill_page);
+    return {fill_page, static_cast<uint16_t>(slot)};
+}
+
+std::vector<Value> Table::get_row(size_t row) const
+{
+    if (layout == StorageLayout::PAGED)
+    {
+        PageGuard page = pool->fetch(records[row].page);
+        SlottedPage slotted(page.data());
+        return decode_row(slotted.get_record(records[row].slot), columns.size());
+    }
+    if (layout != StorageLayout::COLUMNAR)
+        return rows[row];
+
+    std::vector<Value> out;
+    out.reserve(column_data.size());
+    for (const auto &cv : column_data)
+        out.push_back(cv.get(row));
+    return out;
+}
+
+void Table::set_live(size_t slot, bool on)
+{
+    if (slot >> 6 >= live.size())
+        live.resize((slot >> 6) + 1, 0);
+    if (on)
+        live[slot >> 6] |= uint64_t(1) << (slot & 63);
+    else
+        live[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+}
+
+size_t Table::append_row(const std::vector<Value> &values)
+{
+    size_t slot;
+    if (layout == StorageLayout::PAGED)
+    {
+        // Like column vectors, slots are append-only until compact()
+        records.push_back(store_record(encode_row(values)));
+        slot = records.size() - 1;
+    }
+    else if (layout != StorageLayout::COLUMNAR)
+    {
+        if (!free_slots.empty())
+        {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            rows[slot] = values;
+        }
+        else
+        {
+            slot = rows.size();
+            rows.push_back(values);
+        }
+    }
+    else
+    {
+        // Column vectors are append-only; their tombstones wait for compact()
+        for (size_t i = 0; i < column_data.size(); i++)
+            column_data[i].append(values[i]);
+        slot = slot_count() - 1;
+    }
+    set_live(slot, true);
+    live_rows++;
+    return slot;
+}
+
+void Table::update_rows(const std::vector<int> &row_ids, size_t col, const Value &val)
+{
+    if (layout == StorageLayout::PAGED)
+    {
+        for (int row : row_ids)
+        {
+            std::vector<Value> values = get_row(row);
+            values[col] = val;
+            std::string record = encode_row(values);
+            PageGuard page = pool->fetch(records[row].page);
+            SlottedPage slotted(page.mutable_data());
+            if (slotted.update(records[row].slot, record))
+                continue;
+            // Grown past what its page can hold: move the row
+            slotted.erase(records[row].slot);
+            page = PageGuard();
+            records[row] = store_record(record);
+        }
+        return;
+    }
+
+    if (layout == StorageLayout::COLUMNAR)
+    {
+        std::vector<int> sorted = row_ids;
+        std::sort(sorted.begin(), sorted.end());
+        column_data[col].assign(sorted, val);
+        return;
+    }
+
+    for (int row : row_ids)
+        rows[row][col] = val;
+}
+
+void Table::erase_rows(const std::vector<int> &row_ids)
+{
+    for (int row : row_ids)
+    {
+        if (!is_live(row))
+            continue;
+        set_live(row, false);
+        live_rows--;
+        if (layout == StorageLayout::PAGED)
+        {
+            PageGuard page = pool->fetch(records[row].page);
+            SlottedPage(page.mutable_data()).erase(records[row].slot);
+        }
+        else if (layout != StorageLayout::COLUMNAR)
+        {
+            // Free the row's values now; the slot itself is reused later
+            std::vector<Value>().swap(rows[row]);
+            free_slots.push_back(row);
+        }
+    }
+}
+
+size_t Table::compact()
+{
+    std::vector<int> dead;
+    dead.reserve(dead_slots());
+    for (size_t slot = 0; slot < slot_count(); slot++)
+    {
+        if (!is_live(slot))
+            dead.push_back(slot);
+    }
+
+    if (!dead.empty())
+    {
+        if (layout == StorageLayout::PAGED)
+        {
+            // Copy the survivors onto fresh, densely filled pages
+            std::vector<uint32_t> old_pages;
+            old_pages.swap(pages);
+            fill_page = INVALID_PAGE;
+            std::vector<RecordId> moved;
+            moved.reserve(live_rows);
+            for (size_t slot = 0; slot < records.size(); slot++)
+            {
+                if (!is_live(slot))
+                    continue;
+                std::string record;
+                {
+                    PageGuard page = pool->fetch(records[slot].page);
+                    record = SlottedPage(page.data()).get_record(records[slot].slot);
+                }
+                moved.push_back(store_record(record));
+            }
+            records.swap(moved);
+            for (uint32_t page_id : old_pages)
+                pool->free_page(page_id);
+        }
+        else if (layout == StorageLayout::COLUMNAR)
+        {
+            for (auto &cv : column_data)
+                cv.erase(dead);
+        }
+        else
+        {
+            size_t write = 0;
+            for (size_t row = 0; row < rows.size(); row++)
+            {
+                if (!is_live(row))
+                    continue;
+                if (write != row)
+                    rows[write] = std::move(rows[row]);
+                write++;
+            }
+            rows.resize(write);
+            rows.shrink_to_fit();
+        }
+    }
+    else if (layout == StorageLayout::COLUMNAR)
+    {
+        // No dead rows, but UPDATE may have left unused string bytes
+        for (auto &cv : column_data)
+            cv.erase(dead);
+    }
+
+    free_slots.clear();
+    live.assign((live_rows + 63) / 64, 0);
+    for (size_t slot = 0; slot < live_rows; slot++)
+        live[slot >> 6] |= uint64_t(1) << (slot & 63);
+    return dead.size();
+}
+
+std::ostream &operator<<(std::ostream &os, const Value &val)
+{
+    if (std::holds_alternative<int>(val))
+    {
+        os << std::get<int>(val);
+    }
+    else if (std::holds_alternative<float>(val))
+    {
+        os << std::get<float>(val);
+    }
+    else
+    {
+        os << std::get<std::string>(val);
+    }
+    return os;
+}
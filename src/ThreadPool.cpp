@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    threads = std::max<size_t>(threads, 1);
+    ranges = std::make_unique<Range[]>(threads);
+    for (size_t i = 1; i < threads; i++)
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+size_t ThreadPool::default_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::run(size_t tasks, const std::function<void(size_t, size_t)> &fn)
+{
+    if (tasks == 0)
+        return;
+    std::unique_lock<std::mutex> owned(owner, std::defer_lock);
+    if (workers.empty() || tasks == 1 || !owned.try_lock())
+    {
+        for (size_t task = 0; task < tasks; task++)
+            fn(task, 0);
+        return;
+    }
+
+    const size_t n = thread_count();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t p = 0; p < n; p++)
+        {
+            ranges[p].next.store(tasks * p / n, std::memory_order_relaxed);
+            ranges[p].end = tasks * (p + 1) / n;
+        }
+        job = &fn;
+        error = nullptr;
+        busy = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy == 0; });
+    job = nullptr;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ThreadPool::worker_loop(size_t participant)
+{
+    size_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        work(participant);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
+
+void ThreadPool::work(size_t participant)
+{
+    const size_t n = thread_count();
+    // Own range first, then the others' in turn
+    for (size_t k = 0; k < n; k++)
+    {
+        Range &range = ranges[(participant + k) % n];
+        for (;;)
+        {
+            size_t task = range.next.fetch_add(1, std::memory_order_relaxed);
+            if (task >= range.end)
+                break;
+            try
+            {
+                (*job)(task, participant);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,337 @@
+#include "WriteAheadLog.h"
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+static constexpr char WAL_MAGIC[8] = {'N', 'X', 'W', 'A', 'L', '0', '0', '1'};
+static constexpr size_t WAL_HEADER_BYTES = sizeof(WAL_MAGIC) + sizeof(uint64_t);
+static constexpr size_t RECORD_HEADER_BYTES = 2 * sizeof(uint32_t);
+
+// CRC-32 (IEEE 802.3), table driven
+static uint32_t crc32(const char *data, size_t length)
+{
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static std::runtime_error io_error(const std::string &what, const std::string &path)
+{
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// fdatasync where there is one; macOS only offers fsync
+void sync_fd(int fd, const std::string &path)
+{
+#ifdef MACOS
+    int rc = ::fsync(fd);
+#else
+    int rc = ::fdatasync(fd);
+#endif
+    if (rc != 0)
+        throw io_error("Cannot sync", path);
+}
+
+void write_all(int fd, const char *data, size_t length, const std::string &path)
+{
+    while (length > 0)
+    {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw io_error("Cannot write", path);
+        data += n;
+        length -= n;
+    }
+}
+
+std::string directory_of(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+}
+
+void sync_path(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw io_error("Cannot open", path);
+    int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0)
+        throw io_error("Cannot sync", path);
+}
+
+// Create path holding just a header, durably
+static int create_log(const std::string &path, uint64_t generation)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw io_error("Cannot create", path);
+    char header[WAL_HEADER_BYTES];
+    std::memcpy(header, WAL_MAGIC, sizeof(WAL_MAGIC));
+    std::memcpy(header + sizeof(WAL_MAGIC), &generation, sizeof(generation));
+    try
+    {
+        write_all(fd, header, sizeof(header), path);
+        sync_fd(fd, path);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    return fd;
+}
+
+WalContents WriteAheadLog::scan(const std::string &path)
+{
+    WalContents out;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return out;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // A header cut short by a crash while the log was created is no log
+    if (data.size() < WAL_HEADER_BYTES)
+    {
+        out.torn = !data.empty();
+        return out;
+    }
+    if (std::memcmp(data.data(), WAL_MAGIC, sizeof(WAL_MAGIC)) != 0)
+        throw std::runtime_error("Not a NexusPrime log: " + path);
+    std::memcpy(&out.generation, data.data() + sizeof(WAL_MAGIC), sizeof(uint64_t));
+
+    size_t pos = WAL_HEADER_BYTES;
+    while (data.size() - pos >= RECORD_HEADER_BYTES)
+    {
+        uint32_t length, crc;
+        std::memcpy(&length, data.data() + pos, sizeof(length));
+        std::memcpy(&crc, data.data() + pos + sizeof(length), sizeof(crc));
+        const char *payload = data.data() + pos + RECORD_HEADER_BYTES;
+        if (length > data.size() - pos - RECORD_HEADER_BYTES || crc32(payload, length) != crc)
+            break;
+        out.records.emplace_back(payload, length);
+        pos += RECORD_HEADER_BYTES + length;
+    }
+    out.valid_bytes = pos;
+    out.torn = pos < data.size();
+    return out;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string &log_path, uint64_t generation, size_t valid_bytes)
+    : path(log_path), current_generation(generation)
+{
+    if (valid_bytes == 0)
+    {
+        fd = create_log(path, generation);
+        sync_path(directory_of(path));
+    }
+    else
+    {
+        fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0)
+            throw io_error("Cannot open", path);
+        // Drop a torn tail so new records follow the last good one
+        if (::ftruncate(fd, valid_bytes) != 0 || ::lseek(fd, 0, SEEK_END) < 0)
+        {
+            auto error = io_error("Cannot truncate", path);
+            ::close(fd);
+            throw error;
+        }
+        sync_fd(fd, path);
+    }
+    syncer = std::thread(&WriteAheadLog::syncer_loop, this);
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    tick.notify_all();
+    syncer.join();
+
+    // Whatever was appended goes to disk before the file closes
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [&] { return !flushing; });
+    try
+    {
+        if (durable < appended)
+            flush(lock, true);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "WAL: " << e.what() << "\n";
+    }
+    ::close(fd);
+}
+
+uint64_t WriteAheadLog::append(const std::string &record)
+{
+    uint32_t length = static_cast<uint32_t>(record.size());
+    uint32_t crc = crc32(record.data(), record.size());
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    pending.append(reinterpret_cast<const char *>(&crc), sizeof(crc));
+    pending += record;
+    appended += RECORD_HEADER_BYTES + record.size();
+    record_count++;
+    return appended;
+}
+
+void WriteAheadLog::commit(uint64_t lsn)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        if (!failure.empty())
+            throw std::runtime_error("WAL unavailable: " + failure);
+        if (durable >= lsn || (sync_interval > 0 && written >= lsn))
+            return;
+        if (flushing)
+            flushed.wait(lock);
+        else
+            flush(lock, sync_interval == 0);
+    }
+}
+
+void WriteAheadLog::flush(std::unique_lock<std::mutex> &lock, bool sync)
+{
+    flushing = true;
+    std::string batch;
+    batch.swap(pending);
+    uint64_t target = appended;
+    bool need_sync = sync && durable < target;
+    lock.unlock();
+
+    std::string error;
+    try
+    {
+        write_all(fd, batch.data(), batch.size(), path);
+        if (need_sync)
+            sync_fd(fd, path);
+    }
+    catch (const std::exception &e)
+    {
+        error = e.what();
+    }
+
+    lock.lock();
+    flushing = false;
+    if (error.empty())
+    {
+        written = target;
+        if (need_sync)
+        {
+            durable = target;
+            sync_count++;
+        }
+    }
+    else
+    {
+        // The batch may be half written; later records cannot follow it
+        failure = error;
+    }
+    flushed.notify_all();
+}
+
+uint64_t WriteAheadLog::generation() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return current_generation;
+}
+
+uint64_t WriteAheadLog::records() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return record_count;
+}
+
+uint64_t WriteAheadLog::syncs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return sync_count;
+}
+
+void WriteAheadLog::set_sync_interval(unsigned milliseconds)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sync_interval = milliseconds;
+    }
+    tick.notify_all();
+}
+
+void WriteAheadLog::syncer_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        if (sync_interval == 0)
+        {
+            tick.wait(lock, [&] { return stopping || sync_interval > 0; });
+            continue;
+        }
+        tick.wait_for(lock, std::chrono::milliseconds(sync_interval), [&] { return stopping; });
+        if (!stopping && !flushing && failure.empty() && durable < appended)
+            flush(lock, true);
+    }
+}
+
+void WriteAheadLog::restart(uint64_t next_generation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [&] { return !flushing; });
+
+    // Until the new log is in place, records appended to the old one would
+    // be skipped by recovery, so a failure here fails later commits too
+    std::string fresh = path + ".new";
+    int fresh_fd = -1;
+    try
+    {
+        fresh_fd = create_log(fresh, next_generation);
+        if (::rename(fresh.c_str(), path.c_str()) != 0)
+            throw io_error("Cannot replace", path);
+        sync_path(directory_of(path));
+    }
+    catch (const std::exception &e)
+    {
+        if (fresh_fd >= 0)
+            ::close(fresh_fd);
+        failure = e.what();
+        throw;
+    }
+    ::close(fd);
+    fd = fresh_fd;
+
+    // The checkpoint already holds every record queued or written so far
+    pending.clear();
+    written = durable = appended;
+    failure.clear();
+    current_generation = next_generation;
+    record_count = 0;
+    flushed.notify_all();
+}
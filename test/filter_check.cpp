@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "Database.h"
+
+// ------------------- Join Filter Check -------------------
+// A join WHERE clause with OR is checked on the joined rows by a Filter,
+// while an AND-only clause is pushed into the scans' predicates. Both must
+// agree: each AND query is run again with "OR u.k = -1", which no row
+// satisfies, and must return the same rows on every storage layout.
+//
+// Usage: filter_check
+
+static std::vector<std::string> result_rows(Database &db, const SelectQuery &query)
+{
+    std::vector<std::string> out;
+    ResultCursor cursor = db.open_query(query);
+    RowBatch batch;
+    while (cursor.next(batch))
+    {
+        for (size_t r = 0; r < batch.size; r++)
+        {
+            std::stringstream line;
+            for (const Value &val : batch.rows[r])
+                line << val << '|';
+            out.push_back(line.str());
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static Condition condition(const std::string &column, const std::string &op, Value value,
+                           const std::string &logical_op = "AND")
+{
+    Condition cond;
+    cond.column = column;
+    cond.op = op;
+    cond.value = std::move(value);
+    cond.logical_op = logical_op;
+    return cond;
+}
+
+int main()
+{
+    std::mt19937 rng(11);
+    const float near_values[] = {3.0f, 3.0000002f, 2.9999998f, 3.5f, -1.25f};
+    size_t failures = 0;
+    size_t checked = 0;
+
+    for (StorageLayout layout : {StorageLayout::ROW, StorageLayout::COLUMNAR, StorageLayout::PAGED})
+    {
+        Database db;
+        db.create_table("t", {{"id", "INT", true}, {"b", "FLOAT", false}, {"s", "STRING", false}}, layout);
+        db.create_table("u", {{"id", "INT", false}, {"k", "INT", false}}, layout);
+        std::vector<std::vector<Value>> t_rows, u_rows;
+        for (int i = 0; i < 2000; i++)
+        {
+            t_rows.push_back({i, near_values[rng() % 5], std::string(1, char('a' + rng() % 4))});
+            u_rows.push_back({int(rng() % 2000), int(rng() % 10)});
+        }
+        db.insert_many("t", t_rows);
+        db.insert_many("u", u_rows);
+
+        std::vector<std::vector<Condition>> clauses = {
+            {condition("t.b", "=", 3)},
+            {condition("b", "=", 3.0f), condition("u.k", "<", 5)},
+            {condition("t.b", "!=", 3)},
+            {condition("t.b", ">=", 3), condition("t.s", "=", "b")},
+            {condition("u.k", "=", 7), condition("t.b", "<", 3)},
+            {condition("t.s", ">", "a"), condition("t.b", "=", "3")},
+        };
+        for (const auto &where : clauses)
+        {
+            SelectQuery query;
+            query.table = "t";
+            query.join_table = "u";
+            query.join.is_join = true;
+            query.join.left_table = "t";
+            query.join.left_col = "id";
+            query.join.right_table = "u";
+            query.join.right_col = "id";
+            query.join.op = "=";
+            query.select_all = true;
+            query.where = where;
+            std::vector<std::string> pushed = result_rows(db, query);
+
+            query.where.push_back(condition("u.k", "=", -1, "OR"));
+            std::vector<std::string> filtered = result_rows(db, query);
+            checked++;
+            if (pushed != filtered)
+            {
+                failures++;
+                std::cerr << "FAIL: clause " << checked << ": " << pushed.size() << " rows with AND, "
+                          << filtered.size() << " with OR u.k = -1\n";
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " of " << checked << " checks failed\n";
+        return 1;
+    }
+    std::cout << checked << " AND/OR clause pairs agree\n";
+    return 0;
+}
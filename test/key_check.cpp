@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "Database.h"
+
+// ------------------- Primary Key Update Check -------------------
+// An UPDATE that sets primary key columns must be rejected whole when a new
+// key is already held by a row it does not update, or when it gives several
+// rows the same key. A rejected UPDATE leaves every row and the index as
+// they were; an accepted one moves the rows in the index. Checked for an
+// INT key and a composite key on every storage layout, comparing the rows
+// an index lookup finds against those of a full scan. An UPDATE whose
+// WHERE names an unknown column is rejected the same way.
+//
+// Usage: key_check
+
+static std::vector<std::string> result_rows(Database &db, const SelectQuery &query)
+{
+    std::vector<std::string> out;
+    ResultCursor cursor = db.open_query(query);
+    RowBatch batch;
+    while (cursor.next(batch))
+    {
+        for (size_t r = 0; r < batch.size; r++)
+        {
+            std::stringstream line;
+            for (const Value &val : batch.rows[r])
+                line << val << '|';
+            out.push_back(line.str());
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static Condition condition(const std::string &column, const std::string &op, Value value)
+{
+    Condition cond;
+    cond.column = column;
+    cond.op = op;
+    cond.value = std::move(value);
+    cond.logical_op = "AND";
+    return cond;
+}
+
+static SelectQuery select_all(const std::string &table, std::vector<Condition> where = {})
+{
+    SelectQuery query;
+    query.table = table;
+    query.select_all = true;
+    query.where = std::move(where);
+    return query;
+}
+
+struct Checker
+{
+    size_t failures = 0;
+    size_t checked = 0;
+
+    void expect(bool ok, const std::string &what)
+    {
+        checked++;
+        if (!ok)
+        {
+            failures++;
+            std::cerr << "FAIL: " << what << "\n";
+        }
+    }
+
+    // Run an UPDATE that must throw, then check the table did not change
+    void rejected(Database &db, const std::string &table, const std::vector<std::pair<std::string, Value>> &set,
+                  const std::vector<Condition> &where, const std::string &what)
+    {
+        std::vector<std::string> before = result_rows(db, select_all(table));
+        bool threw = false;
+        try
+        {
+            db.update(table, set, where);
+        }
+        catch (const std::exception &)
+        {
+            threw = true;
+        }
+        expect(threw, what + ": no error");
+        expect(result_rows(db, select_all(table)) == before, what + ": rows changed");
+    }
+};
+
+int main()
+{
+    Checker check;
+    for (StorageLayout layout : {StorageLayout::ROW, StorageLayout::COLUMNAR, StorageLayout::PAGED})
+    {
+        std::string name = std::string(" (layout ") + std::to_string(int(layout)) + ")";
+        Database db;
+        db.create_table("t", {{"id", "INT", true}, {"v", "INT", false}}, layout);
+        db.insert_many("t", {{1, 10}, {2, 20}, {3, 30}});
+
+        check.rejected(db, "t", {{"id", 2}}, {condition("id", "=", 3)}, "INT key onto a kept row" + name);
+        check.rejected(db, "t", {{"id", 7}}, {condition("id", ">", 1)}, "INT key onto one value" + name);
+        check.rejected(db, "t", {{"v", 1}}, {condition("nosuch", "=", 3)}, "unknown WHERE column" + name);
+        for (int id : {2, 3, 7})
+        {
+            auto found = result_rows(db, select_all("t", {condition("id", "=", id)}));
+            check.expect(found.size() == (id == 7 ? 0u : 1u), "INT key lookup of " + std::to_string(id) + name);
+        }
+
+        // Giving a row a key another updated row gives up is not a clash
+        db.update("t", {{"id", 5}}, {condition("id", "=", 3)});
+        db.update("t", {{"id", 3}}, {condition("id", "=", 2)});
+        auto moved = result_rows(db, select_all("t", {condition("id", "=", 3)}));
+        check.expect(moved.size() == 1 && moved[0] == "3|20|", "INT key moved" + name);
+        check.expect(result_rows(db, select_all("t", {condition("id", "=", 2)})).empty(), "INT key freed" + name);
+        bool inserted = true;
+        try
+        {
+            db.insert_many("t", {{5, 0}});
+        }
+        catch (const std::exception &)
+        {
+            inserted = false;
+        }
+        check.expect(!inserted, "INT key held after move" + name);
+
+        db.create_table("c", {{"g", "STRING", true}, {"n", "INT", true}, {"x", "INT", false}}, layout);
+        db.insert_many("c", {{std::string("a"), 1, 0}, {std::string("a"), 2, 0}, {std::string("b"), 1, 0}});
+        check.rejected(db, "c", {{"g", std::string("b")}}, {condition("n", "=", 1), condition("g", "=", "a")},
+                       "composite key onto a kept row" + name);
+        check.rejected(db, "c", {{"n", 9}}, {condition("g", "=", "a")}, "composite key onto one value" + name);
+        auto held = result_rows(db, select_all("c", {condition("g", "=", "b"), condition("n", "=", 1)}));
+        check.expect(held.size() == 1, "composite key lookup" + name);
+    }
+
+    if (check.failures > 0)
+    {
+        std::cerr << check.failures << " of " << check.checked << " checks failed\n";
+        return 1;
+    }
+    std::cout << check.checked << " primary key update checks passed\n";
+    return 0;
+}
@@ -3,10 +3,24 @@
 #include "SQLParser.h"
 
 // ------------------- Main Function -------------------
-int main()
+// Usage: NexusPrime [data directory]. Without a directory nothing is
+// kept once the REPL exits.
+int main(int argc, char **argv)
 {
     Database db;
     SQLParser parser;
+    if (argc > 1)
+    {
+        try
+        {
+            db.open(argv[1]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
     std::cout << "\033[34mNexusPrime > \033[0m";
 
     // std::cout << "NexusPrime > ";
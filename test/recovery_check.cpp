@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// ------------------- Crash Recovery Check -------------------
+// Feeds `NexusPrime dir` a stream of INSERT, UPDATE, DELETE, VACUUM and
+// CHECKPOINT statements and SIGKILLs it at random points, sometimes also
+// cutting the end of wal.log inside a record as a torn write would. After
+// each crash the database is reopened and its tables must equal those of
+// an in-memory run of some prefix of the stream: nothing half applied and
+// nothing that was never sent. Without a torn log the prefix must also
+// cover every statement the process had finished.
+//
+// Statement i of the stream is followed by INSERT INTO seq VALUES (i), so
+// the recovered seq table says how far the prefix reaches. Each pair is
+// followed by an unknown command, whose error on the unbuffered stderr
+// tells the check that both statements have returned.
+//
+// Usage: recovery_check path/to/NexusPrime [sessions] [seed]
+
+static const std::vector<std::string> DUMP = {"SELECT * FROM a", "SELECT * FROM b", "SELECT * FROM c",
+                                              "SELECT * FROM seq"};
+static const std::string ACK_ERROR = "Error: Unknown command";
+static constexpr size_t SETUP_STATEMENTS = 5; // CREATE TABLE x4, CHECKPOINT
+
+struct Process
+{
+    pid_t pid = -1;
+    int in = -1;  // Its stdin
+    int out = -1; // Its stdout, or -1
+    int err = -1; // Its stderr, or -1
+};
+
+static Process spawn(const std::string &binary, const std::vector<std::string> &args, bool want_out, bool want_err)
+{
+    int in_pipe[2], out_pipe[2], err_pipe[2];
+    if (::pipe(in_pipe) != 0 || ::pipe(out_pipe) != 0 || ::pipe(err_pipe) != 0)
+        throw std::runtime_error("pipe failed");
+    Process proc;
+    proc.pid = ::fork();
+    if (proc.pid == 0)
+    {
+        int null_fd = ::open("/dev/null", O_WRONLY);
+        ::dup2(in_pipe[0], 0);
+        ::dup2(want_out ? out_pipe[1] : null_fd, 1);
+        ::dup2(want_err ? err_pipe[1] : null_fd, 2);
+        for (int fd : {in_pipe[0], in_pipe[1], out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1], null_fd})
+            ::close(fd);
+        std::vector<char *> argv{const_cast<char *>(binary.c_str())};
+        for (const auto &arg : args)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+        ::execv(binary.c_str(), argv.data());
+        ::_exit(127);
+    }
+    ::close(in_pipe[0]);
+    ::close(out_pipe[1]);
+    ::close(err_pipe[1]);
+    proc.in = in_pipe[1];
+    if (want_out)
+        proc.out = out_pipe[0];
+    else
+        ::close(out_pipe[0]);
+    if (want_err)
+        proc.err = err_pipe[0];
+    else
+        ::close(err_pipe[0]);
+    return proc;
+}
+
+static void write_all(int fd, const std::string &text)
+{
+    for (size_t done = 0; done < text.size();)
+    {
+        ssize_t n = ::write(fd, text.data() + done, text.size() - done);
+        if (n <= 0)
+            return; // The process is gone
+        done += n;
+    }
+}
+
+static std::string read_all(int fd)
+{
+    std::string text;
+    char buffer[65536];
+    for (ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0;)
+        text.append(buffer, n);
+    return text;
+}
+
+// Run the binary to completion on the statements; its stdout
+static std::string run(const std::string &binary, const std::vector<std::string> &args,
+                       const std::vector<std::string> &statements)
+{
+    std::string input;
+    for (const auto &stmt : statements)
+        input += stmt + "\n";
+    Process proc = spawn(binary, args, true, false);
+    std::thread writer([&] { write_all(proc.in, input); ::close(proc.in); });
+    std::string out = read_all(proc.out);
+    writer.join();
+    ::close(proc.out);
+    ::waitpid(proc.pid, nullptr, 0);
+    return out;
+}
+
+// The rows of the last DUMP.size() results, each result sorted, since a
+// checkpoint may renumber row slots
+static std::vector<std::vector<std::string>> dump_tables(const std::string &out)
+{
+    std::string text = std::regex_replace(out, std::regex("\x1b\\[[0-9;]*m"), "");
+    std::vector<std::string> lines;
+    std::stringstream ss(text);
+    for (std::string line; std::getline(ss, line);)
+        lines.push_back(line);
+
+    std::vector<std::vector<std::string>> tables;
+    std::regex results("Results \\((\\d+) rows\\):");
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        std::smatch match;
+        if (!std::regex_search(lines[i], match, results))
+            continue;
+        size_t rows = std::stoul(match[1]);
+        std::vector<std::string> table;
+        for (size_t r = 0; r < rows && i + 3 + r < lines.size(); r++)
+        {
+            // Widths depend on the rows seen first, so compare the words
+            std::stringstream cells(lines[i + 3 + r]);
+            std::string cell, row;
+            while (cells >> cell)
+                row += cell + " ";
+            table.push_back(row);
+        }
+        std::sort(table.begin(), table.end());
+        tables.push_back(table);
+    }
+    if (tables.size() > DUMP.size())
+        tables.erase(tables.begin(), tables.end() - DUMP.size());
+    return tables;
+}
+
+static std::vector<std::string> workload(std::mt19937 &rng, size_t count)
+{
+    std::vector<std::string> setup = {
+        "CREATE TABLE a (id INT PRIMARY KEY, g STRING, v FLOAT) USING ROW",
+        "CREATE TABLE b (g STRING, n INT, x INT, PRIMARY KEY (g, n)) USING COLUMNAR",
+        "CREATE TABLE c (k INT, s STRING) USING PAGED",
+        "CREATE TABLE seq (i INT PRIMARY KEY)",
+        "CHECKPOINT"};
+    std::vector<std::string> out = setup;
+    int next_id = 0;
+    int next_n = 0;
+    auto pick = [&](int n) { return int(rng() % n); };
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string stmt;
+        int kind = pick(100);
+        if (kind < 25)
+        {
+            stmt = "INSERT INTO a VALUES ";
+            for (int r = 0, rows = 1 + pick(20); r < rows; r++)
+            {
+                stmt += (r ? ", (" : "(") + std::to_string(next_id++) + ", 'g" + std::to_string(pick(20)) + "', " +
+                        std::to_string(pick(1000)) + ".5)";
+            }
+        }
+        else if (kind < 40)
+        {
+            stmt = "INSERT INTO b VALUES ";
+            for (int r = 0, rows = 1 + pick(20); r < rows; r++)
+            {
+                stmt += (r ? ", ('h" : "('h") + std::to_string(pick(10)) + "', " + std::to_string(next_n++) + ", " +
+                        std::to_string(pick(100)) + ")";
+            }
+        }
+        else if (kind < 50)
+        {
+            stmt = "INSERT INTO c VALUES (" + std::to_string(pick(50)) + ", 's" + std::to_string(pick(9)) + "'), (" +
+                   std::to_string(pick(50)) + ", 'x')";
+        }
+        else if (kind < 60)
+        {
+            int lo = pick(next_id + 1);
+            stmt = "DELETE FROM a WHERE id >= " + std::to_string(lo) + " AND id < " + std::to_string(lo + 30);
+        }
+        else if (kind < 66)
+        {
+            stmt = "DELETE FROM b WHERE g = 'h" + std::to_string(pick(10)) + "' AND n > " +
+                   std::to_string(pick(next_n + 1));
+        }
+        else if (kind < 72)
+        {
+            stmt = "DELETE FROM c WHERE k < " + std::to_string(pick(50));
+        }
+        else if (kind < 80)
+        {
+            stmt = "UPDATE a SET v = " + std::to_string(pick(100)) + ", g = 'u" + std::string(pick(12), 'x') +
+                   "' WHERE id > " + std::to_string(pick(next_id + 1));
+        }
+        else if (kind < 88)
+        {
+            stmt = "UPDATE b SET x = " + std::to_string(pick(100)) + " WHERE g = 'h" + std::to_string(pick(10)) + "'";
+        }
+        else if (kind < 92)
+        {
+            stmt = "UPDATE c SET s = 'y" + std::string(pick(30), 'y') + "' WHERE k = " + std::to_string(pick(50));
+        }
+        else if (kind < 96)
+        {
+            const char *vacuums[] = {"VACUUM a", "VACUUM b", "VACUUM c"};
+            stmt = vacuums[pick(3)];
+        }
+        else
+        {
+            stmt = "CHECKPOINT";
+        }
+        out.push_back(stmt);
+        out.push_back("INSERT INTO seq VALUES (" + std::to_string(i) + ")");
+    }
+    return out;
+}
+
+// Statements applied in the database at dir, found from its seq table and
+// checked against in-memory runs; 0 when no prefix matches
+static size_t recovered_prefix(const std::string &binary, const std::string &dir,
+                               const std::vector<std::string> &statements)
+{
+    auto state = dump_tables(run(binary, {dir}, DUMP));
+    if (state.size() != DUMP.size())
+        return 0;
+    int last = -1;
+    for (const auto &row : state[3])
+        last = std::max(last, std::stoi(row));
+
+    // Through the last seq insert, or one statement further
+    size_t done = SETUP_STATEMENTS + 2 * (last + 1);
+    for (size_t prefix : {done + 1, done})
+    {
+        if (prefix > statements.size())
+            continue;
+        std::vector<std::string> model(statements.begin(), statements.begin() + prefix);
+        model.insert(model.end(), DUMP.begin(), DUMP.end());
+        if (dump_tables(run(binary, {}, model)) == state)
+            return prefix;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: recovery_check path/to/NexusPrime [sessions] [seed]\n";
+        return 2;
+    }
+    std::string binary = argv[1];
+    size_t sessions = argc > 2 ? std::stoul(argv[2]) : 12;
+    std::mt19937 rng(argc > 3 ? std::stoul(argv[3]) : 1);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const char *tmp = std::getenv("TMPDIR");
+    std::string dir_template = std::string(tmp ? tmp : "/tmp") + "/recovery_check.XXXXXX";
+    if (!::mkdtemp(dir_template.data()))
+    {
+        std::cerr << "Cannot create a temporary directory\n";
+        return 2;
+    }
+    std::string dir = dir_template;
+
+    std::vector<std::string> statements = workload(rng, 60 * sessions);
+    std::vector<std::string> setup(statements.begin(), statements.begin() + SETUP_STATEMENTS);
+    run(binary, {dir}, setup);
+
+    size_t applied = SETUP_STATEMENTS;
+    size_t crashes = 0;
+    size_t torn = 0;
+    bool failed = false;
+    for (size_t session = 0; session < sessions && !failed && applied < statements.size(); session++)
+    {
+        // Send everything left, acknowledging pair by pair, and kill the
+        // process somewhere past a random number of acknowledgements
+        std::string input;
+        for (size_t i = applied; i < statements.size(); i++)
+        {
+            input += statements[i] + "\n";
+            if ((i - SETUP_STATEMENTS) % 2 == 1)
+                input += "ACK\n";
+        }
+        size_t kill_after = rng() % 60;
+        Process proc = spawn(binary, {dir}, false, true);
+        std::thread writer([&] { write_all(proc.in, input); ::close(proc.in); });
+
+        size_t acked = 0;
+        std::string errors;
+        char buffer[4096];
+        while (acked < kill_after)
+        {
+            ssize_t n = ::read(proc.err, buffer, sizeof(buffer));
+            if (n <= 0)
+                break;
+            errors.append(buffer, n);
+            size_t pos = 0;
+            for (size_t found; (found = errors.find(ACK_ERROR, pos)) != std::string::npos;)
+            {
+                acked++;
+                pos = found + ACK_ERROR.size();
+            }
+            // Keep a tail that may be the start of a split message
+            pos = std::max(pos, errors.size() >= ACK_ERROR.size() ? errors.size() - ACK_ERROR.size() + 1 : 0);
+            errors.erase(0, pos);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(rng() % 3000));
+        ::kill(proc.pid, SIGKILL);
+        ::waitpid(proc.pid, nullptr, 0);
+        writer.join();
+        ::close(proc.err);
+        crashes++;
+
+        // Finished statements at the kill; when the last recovery ended
+        // between a statement and its seq insert, the first ACK covers one
+        acked = std::min(acked, kill_after);
+        size_t finished = applied + 2 * acked;
+        if (acked > 0 && (applied - SETUP_STATEMENTS) % 2 == 1)
+            finished--;
+
+        // Sometimes also tear the last record of the log
+        bool tear = rng() % 3 == 0;
+        std::string log_path = dir + "/wal.log";
+        struct stat info;
+        if (tear && ::stat(log_path.c_str(), &info) == 0 && info.st_size > 64)
+        {
+            off_t cut = 1 + rng() % 40;
+            if (::truncate(log_path.c_str(), info.st_size - cut) != 0)
+                tear = false;
+            torn += tear;
+        }
+        else
+        {
+            tear = false;
+        }
+
+        size_t prefix = recovered_prefix(binary, dir, statements);
+        if (prefix == 0)
+        {
+            std::cerr << "FAIL: session " << session << ": recovered tables match no prefix of the statements\n";
+            failed = true;
+        }
+        else if (!tear && prefix < finished)
+        {
+            std::cerr << "FAIL: session " << session << ": " << finished << " statements had returned but only "
+                      << prefix << " were recovered\n";
+            failed = true;
+        }
+        applied = prefix;
+    }
+
+    std::string cleanup = "rm -rf '" + dir + "'";
+    if (!failed && std::system(cleanup.c_str()) != 0)
+        std::cerr << "Could not remove " << dir << "\n";
+    if (failed)
+    {
+        std::cerr << "Database left in " << dir << "\n";
+        return 1;
+    }
+    std::cout << crashes << " crashes (" << torn << " with a torn log) recovered to a prefix of "
+              << statements.size() << " statements\n";
+    return 0;
+}